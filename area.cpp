@@ -13,15 +13,13 @@
   This file contains numerous functions you must implement. Each function you
   must implement has a
 */
+#include <cmath>
 #include <stdexcept>
+#include <sstream>
 #include "bethyw.h"
 #include "area.h"
-#include "lib_json.hpp"
+#include "output.h"
 
-/*
-  An alias for the imported JSON parsing library.
-*/
-using json = nlohmann::json;
 /*
   Construct an Area with a given local authority code.
 
@@ -81,6 +79,49 @@ std::string Area::getLocalAuthorityCode() const {
     return names.find(lang)->second;
 }
 
+/*
+  Retrieve every name of the Area.
+
+  @return
+    The names, keyed by the three-letter language code
+
+  @example
+    Area area("W06000023");
+    area.setName("eng", "Powys");
+    auto names = area.getNames(); // {"eng": "Powys"}
+*/
+const std::map<std::string, std::string>& Area::getNames() const{
+    return names;
+}
+
+/*
+  Get the name to show for the Area: the English and Welsh names as
+  "Eng / Cym", or whichever single name we have, or "Unnamed" when there are
+  none. This function is callable from a constant context and will not throw.
+
+  @return
+    The name to display for the Area
+
+  @example
+    Area area("W06000023");
+    area.setName("eng", "Powys");
+    auto name = area.getDisplayName(); // returns "Powys"
+*/
+std::string Area::getDisplayName() const{
+    auto eng = names.find("eng");
+    auto cym = names.find("cym");
+
+    if(eng != names.end() && cym != names.end())
+        return eng->second + " / " + cym->second;
+    if(eng != names.end())
+        return eng->second;
+    if(cym != names.end())
+        return cym->second;
+    if(!names.empty())
+        return names.begin()->second;
+    return "Unnamed";
+}
+
 /*
   Set a name for the Area in a specific language.
 
@@ -139,11 +180,54 @@ void Area::setName(std::string lang, std::string name){
     auto measure2 = area.getMeasure("pop");
 */
 Measure& Area::getMeasure(const std::string key) {
-
-    if(measures.find(BethYw::convertToLower(key)) == measures.end())
+    const Measure* measure = findMeasure(key);
+    if(measure == nullptr)
         throw std::out_of_range("No measure found matching " + key);
 
-    return measures.at(key);
+    return measures.at(BethYw::convertToLower(key));
+}
+
+/*
+  Retrieve all of the Measures in this Area, ordered by their (lowercase)
+  codename, without copying them. This function is callable from a constant
+  context.
+
+  @return
+    A reference to the map of codename to Measure
+
+  @example
+    Area area("W06000023");
+    ...
+    for (auto const& measure : area.getMeasures())
+      std::cout << measure.second;
+*/
+const std::map<std::string, Measure>& Area::getMeasures() const{
+    return measures;
+}
+
+/*
+  Find a Measure by its codename (in any case) without throwing. This
+  function is callable from a constant context.
+
+  @param key
+    The codename for the measure you want to find
+
+  @return
+    A pointer to the Measure, or nullptr if there is no such measure
+
+  @example
+    Area area("W06000023");
+    ...
+    const Measure* pop = area.findMeasure("Pop");
+*/
+const Measure* Area::findMeasure(const std::string& key) const{
+    std::string lower = BethYw::convertToLower(key);
+
+    auto measure = measures.find(lower);
+    if(measure != measures.end())
+        return &measure->second;
+
+    return nullptr;
 }
 
 /*
@@ -154,7 +238,8 @@ Measure& Area::getMeasure(const std::string key) {
   passed into this function. The resulting Measure stored inside the Area
   instance should be a combination of the two Measures instances.
 
-  Note that the Measure's codename are be converted to lowercase.
+  Note that the Measure's codename are be converted to lowercase. Any derived
+  measures are calculated again, so none is left out of date.
 
   @param codename
     The codename for the Measure
@@ -185,6 +270,113 @@ void Area::setMeasure(std::string codename, Measure measure){
         measure.merge(measures.at(codenameLower));
         measures.at(codenameLower) = measure;
     }
+
+    //a derived measure set directly is just data from now on, and the
+    //derived measures calculated from this one are out of date
+    if(!derivations.empty()){
+        derivations.erase(codenameLower);
+        deriveAll();
+    }
+}
+
+/*
+  Define a derived measure for this Area and calculate it from the other
+  Measures. The definition is only kept when this Area has every Measure the
+  expression uses and no Measure already has that codename, so Areas without
+  the data don't end up with empty Measures. It is kept so the derived
+  measure can be calculated again when one of its inputs is set.
+
+  @param derivation
+    The derived measure's codename and expression, which may be shared with
+    other Areas
+
+  @return
+    true if the derived measure was defined for this Area, false otherwise
+
+  @example
+    auto popden = std::make_shared<const BethYw::Derivation>(
+        BethYw::parseDerivation("popden = pop / area"));
+    area.defineMeasure(popden);
+*/
+bool Area::defineMeasure(std::shared_ptr<const BethYw::Derivation> derivation){
+    if(measures.find(derivation->codename) != measures.end())
+        return false;
+
+    for(auto const& input : derivation->expression.getMeasures())
+        if(measures.find(input) == measures.end())
+            return false;
+
+    derivations[derivation->codename] = derivation;
+    std::set<std::string> derived;
+    derive(derivation->codename, derived);
+    return true;
+}
+
+/*
+  Calculate a derived measure for every year that all of its inputs have a
+  value in, and store it with the other Measures, replacing what was there.
+  Inputs that are derived measures themselves are calculated first. Years
+  where the result is not a finite number (e.g. a division by zero) are left
+  out.
+
+  @param codename
+    The codename of the derived measure to calculate
+
+  @param derived
+    The codenames of the derived measures already calculated this time, so
+    each is only calculated once (and definitions that use each other, which
+    merging Areas can make, don't recurse forever)
+*/
+void Area::derive(const std::string& codename, std::set<std::string>& derived){
+    auto definition = derivations.find(codename);
+    if(definition == derivations.end() || !derived.insert(codename).second)
+        return;
+    const BethYw::Derivation& derivation = *definition->second;
+    auto const& inputs = derivation.expression.getMeasures();
+
+    for(auto const& input : inputs)
+        derive(input, derived);
+
+    Measure result(derivation.codename, derivation.expression.getText());
+    std::vector<const std::map<unsigned int, double>*> readings;
+    for(auto const& input : inputs){
+        auto measure = measures.find(input);
+        if(measure == measures.end()){
+            readings.clear();
+            break;
+        }
+        readings.push_back(&measure->second.getReadings());
+    }
+
+    std::vector<double> values(inputs.size());
+    if(!readings.empty()){
+        for(auto const& reading : *readings.front()){
+            std::size_t found = 1;
+            values[0] = reading.second;
+            for(; found < readings.size(); found++){
+                auto value = readings[found]->find(reading.first);
+                if(value == readings[found]->end())
+                    break;
+                values[found] = value->second;
+            }
+            if(found < readings.size())
+                continue;
+
+            double value = derivation.expression.evaluate(values.data());
+            if(std::isfinite(value))
+                result.setValue(reading.first, value);
+        }
+    }
+    measures[codename] = std::move(result);
+}
+
+/*
+  Calculate every derived measure again, inputs first.
+*/
+void Area::deriveAll(){
+    std::set<std::string> derived;
+    for(auto const& derivation : derivations)
+        derive(derivation.first, derived);
 }
 
 /*
@@ -240,12 +432,10 @@ unsigned int Area::size() const{
     std::cout << area << std::endl;
 */
 std::ostream &operator<<(std::ostream &os, const Area &area) {
-
-    os << area.getName("eng") << " / " << area.getName("cym") << '('
-       << area.getLocalAuthorityCode() << ')' << std::endl;
+    os << area.getDisplayName() << " (" << area.localAuthorityCode << ")\n";
 
     if(area.measures.empty())
-        os << "<no measures>" << std::endl << std::endl;
+        os << "<no measures>\n\n";
 
     for(auto const& measure : area.measures)
         os << measure.second;
@@ -303,6 +493,58 @@ bool operator==(const Area& lhs, const Area& rhs){
 void Area::merge(Area areaNew){
     measures.insert(areaNew.measures.begin(), areaNew.measures.end());
     names.insert(areaNew.names.begin(), areaNew.names.end());
+    derivations.insert(areaNew.derivations.begin(), areaNew.derivations.end());
+    if(!derivations.empty())
+        deriveAll();
+}
+
+/*
+  Copy the part of this Area that passes the same filters the populate()
+  functions use: its names, the Measures in measuresFilter (all of them if it
+  is empty or null) and, of those, only the readings in the yearsFilter range.
+  A Measure with no readings in the range is still copied (empty), as the
+  parsers do when a file has the Measure but not those years.
+
+  @param measuresFilter
+    The (lowercase) codenames of the Measures to copy, or empty/null for all
+
+  @param yearsFilter
+    The first and last year of the readings to copy, or null (or 0, 0) for all
+
+  @return
+    A new Area with the filtered data
+
+  @example
+    Area area("W06000011");
+    ...
+    auto years = std::make_tuple(2010u, 2015u);
+    Area recent = area.select(nullptr, &years);
+*/
+Area Area::select(const std::unordered_set<std::string>* measuresFilter,
+                  const std::tuple<unsigned int, unsigned int>* yearsFilter) const{
+    Area area(localAuthorityCode);
+    area.names = names;
+
+    unsigned int yearStart = yearsFilter == nullptr ? 0 : std::get<0>(*yearsFilter);
+    unsigned int yearEnd = yearsFilter == nullptr ? 0 : std::get<1>(*yearsFilter);
+    bool allYears = yearStart == 0 && yearEnd == 0;
+
+    for(auto const& measure : measures){
+        if(measuresFilter != nullptr && !measuresFilter->empty()
+           && measuresFilter->find(measure.first) == measuresFilter->end())
+            continue;
+
+        if(allYears){
+            area.measures.insert(measure);
+            continue;
+        }
+        Measure selected(measure.second.getCodename(), measure.second.getLabel());
+        for(auto const& reading : measure.second.getReadings())
+            if(reading.first >= yearStart && reading.first <= yearEnd)
+                selected.setValue(reading.first, reading.second);
+        area.measures.emplace(measure.first, std::move(selected));
+    }
+    return area;
 }
 /*
   Convert this Area object, and the Measure instances within those, to a JSON string.
@@ -326,15 +568,72 @@ void Area::merge(Area areaNew){
 */
 
 std::string Area::toJSON() const {
-    json j;
+    std::ostringstream os;
+    toJSON(os);
+    return os.str();
+}
 
-    for (auto const& name : names)
-        j["names"][name.first] = name.second;
+/*
+  Write this Area, and the Measure instances within it, straight to an output
+  stream as JSON. The output is the same as the JSON string above, i.e. an
+  object with "measures" and "names" keys (each left out when empty), or null
+  if the Area has neither. If the stream has BethYw::withStatistics set, a
+  "statistics" key holds the extended statistics of each Measure.
 
-    for (auto const& measure : measures)
-        j["measures"][measure.first] = json::parse(measure.second.toJSON());
+  @param os
+    The output stream to write to
 
-    return j.dump();
-}
+  @example
+    Area area("W06000023");
+    area.setName("eng", "Powys");
+    area.toJSON(std::cout); // {"names":{"eng":"Powys"}}
+*/
+void Area::toJSON(std::ostream& os) const {
+    if(measures.empty() && names.empty()){
+        os.write("null", 4);
+        return;
+    }
+
+    os.put('{');
+    if(!measures.empty()){
+        os.write("\"measures\":", 11);
+        char sep = '{';
+        for (auto const& measure : measures){
+            os.put(sep);
+            BethYw::writeJSONString(os, measure.first);
+            os.put(':');
+            measure.second.toJSON(os);
+            sep = ',';
+        }
+        os.put('}');
+        if(!names.empty())
+            os.put(',');
+    }
 
+    if(!names.empty()){
+        os.write("\"names\":", 8);
+        char sep = '{';
+        for (auto const& name : names){
+            os.put(sep);
+            BethYw::writeJSONString(os, name.first);
+            os.put(':');
+            BethYw::writeJSONString(os, name.second);
+            sep = ',';
+        }
+        os.put('}');
+    }
 
+    if(!measures.empty() && BethYw::showStatistics(os)){
+        os.write(",\"statistics\":", 14);
+        char sep = '{';
+        for (auto const& measure : measures){
+            os.put(sep);
+            BethYw::writeJSONString(os, measure.first);
+            os.put(':');
+            BethYw::writeJSONStatistics(os, measure.second.getStatistics());
+            sep = ',';
+        }
+        os.put('}');
+    }
+    os.put('}');
+}
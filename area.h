@@ -16,9 +16,14 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <unordered_set>
 #include <iostream>
 #include <vector>
 #include "measure.h"
+#include "expression.h"
 #include "lib_json.hpp"
 
 /*
@@ -37,8 +42,18 @@ private:
 
     //Key = short code representing what data is stored |
     // Value = Measure object with all reading for that key
+    //Derived measures are kept here too, calculated when they are defined
+    //and again whenever one of their inputs is set
     std::map<std::string, Measure> measures;
 
+    //Key = codename of a derived measure | Value = how to calculate it,
+    //shared with every other Area it is defined for
+    std::map<std::string, std::shared_ptr<const BethYw::Derivation>> derivations;
+
+    /*----Helper----*/
+    void derive(const std::string& codename, std::set<std::string>& derived);
+    void deriveAll();
+
 public:
     /*----Constructors----*/
     Area() = default;
@@ -47,16 +62,24 @@ public:
     /*----Getters----*/
     std::string getLocalAuthorityCode() const;
     std::string getName(const std::string lang) const;
+    const std::map<std::string, std::string>& getNames() const;
+    std::string getDisplayName() const;
     Measure& getMeasure(const std::string key);
+    const std::map<std::string, Measure>& getMeasures() const;
+    const Measure* findMeasure(const std::string& key) const;
 
     /*----Setters---*/
     void setName(std::string lang, std::string name);
     void setMeasure(std::string codename, Measure measure);
+    bool defineMeasure(std::shared_ptr<const BethYw::Derivation> derivation);
 
     /*----Miscellaneous---*/
     unsigned int size() const;
     std::string toJSON() const;
+    void toJSON(std::ostream& os) const;
     void merge(Area areaNew);
+    Area select(const std::unordered_set<std::string>* measuresFilter,
+                const std::tuple<unsigned int, unsigned int>* yearsFilter) const;
 
     /*----Overrides----*/
     friend bool operator==(const Area& lhs, const Area& rhs);
@@ -0,0 +1,401 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the area index. See the header
+  file for additional comments.
+
+  The records are read with a seek and a read for each range, which works
+  the same on every platform, and glued back together into a smaller file of
+  the same format for the usual parser: the JSON objects go into a new
+  "value" array, and the CSV lines go after the header line. As the parser
+  skips every record of an area that isn't wanted anyway, what it imports
+  from the smaller file is the same as from the whole one.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "areaindex.h"
+#include "fileutil.h"
+#include "lib_json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+// a start offset and a length in the file
+using Range = std::pair<unsigned long long, unsigned long long>;
+
+struct AreaIndex {
+  unsigned long long size = 0;
+  long long modified = 0;
+  Range header = Range(0, 0);
+  std::map<std::string, std::vector<Range>> areas;
+};
+
+// one writer of an index file at a time
+std::mutex writeMutex;
+
+/*
+  Read "start+length,start+length,..." into ranges, or false if it isn't
+  valid.
+*/
+bool readRanges(const std::string& field, std::vector<Range>& ranges) {
+    std::istringstream stream(field);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        std::istringstream parts(range);
+        Range parsed;
+        char plus;
+        if (!(parts >> parsed.first >> plus >> parsed.second) || plus != '+')
+            return false;
+        ranges.push_back(parsed);
+    }
+    return true;
+}
+
+/*
+  Read the index file of a dataset, or false if it is missing or isn't valid.
+*/
+bool readIndex(const std::string& path, AreaIndex& index) {
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line))
+        return false;
+    std::istringstream stamp(line);
+    if (!(stamp >> index.size >> index.modified))
+        return false;
+
+    bool header = false;
+    while (std::getline(file, line)) {
+        std::size_t tab = line.find('\t');
+        if (tab == std::string::npos)
+            return false;
+        std::vector<Range> ranges;
+        if (!readRanges(line.substr(tab + 1), ranges))
+            return false;
+        if (!header) {
+            if (line.compare(0, tab, "header") != 0 || ranges.size() != 1)
+                return false;
+            index.header = ranges[0];
+            header = true;
+        } else {
+            index.areas[line.substr(0, tab)] = ranges;
+        }
+    }
+    return header;
+}
+
+/*
+  Write the index file of a dataset in the cache directory, one thread at a
+  time. If it can't be written the dataset is just indexed again next time.
+*/
+void writeIndex(const std::string& cacheDir, const std::string& path, const AreaIndex& index) {
+    std::ostringstream contents;
+    contents << index.size << '\t' << index.modified << '\n'
+             << "header\t" << index.header.first << '+' << index.header.second << '\n';
+    for (auto const& area : index.areas) {
+        contents << area.first << '\t';
+        bool first = true;
+        for (auto const& range : area.second) {
+            contents << (first ? "" : ",") << range.first << '+' << range.second;
+            first = false;
+        }
+        contents << '\n';
+    }
+    std::lock_guard<std::mutex> lock(writeMutex);
+    BethYw::makeDirectory(cacheDir);
+    BethYw::writeFileAtomically(path, contents.str());
+}
+
+/*
+  The position just after the JSON string starting at a quote, or npos if it
+  is never closed.
+*/
+std::size_t skipString(const std::string& text, std::size_t quote) {
+    for (std::size_t i = quote + 1; i < text.size(); i++) {
+        if (text[i] == '\\')
+            i++;
+        else if (text[i] == '"')
+            return i + 1;
+    }
+    return std::string::npos;
+}
+
+/*
+  The position of the first character that isn't whitespace (or one of the
+  extra characters given) from a position on.
+*/
+std::size_t skipSpace(const std::string& text, std::size_t i, const char* extra = "") {
+    std::string skipped = std::string(" \t\r\n") + extra;
+    std::size_t next = text.find_first_not_of(skipped, i);
+    return next == std::string::npos ? text.size() : next;
+}
+
+/*
+  Find the range of each object in the "value" array of a StatsWales JSON
+  file, and the area it is for. Each object is parsed on its own to find its
+  area code.
+*/
+bool indexJSON(const std::string& text, const std::string& codeColumn, AreaIndex& index) {
+    //find the "value" key of the outermost object
+    std::size_t i = 0;
+    int depth = 0;
+    bool found = false;
+    while (i < text.size() && !found) {
+        char c = text[i];
+        if (c == '"') {
+            std::size_t end = skipString(text, i);
+            if (end == std::string::npos)
+                return false;
+            if (depth == 1 && text.compare(i, end - i, "\"value\"") == 0) {
+                std::size_t colon = skipSpace(text, end);
+                if (colon < text.size() && text[colon] == ':') {
+                    std::size_t array = skipSpace(text, colon + 1);
+                    if (array >= text.size() || text[array] != '[')
+                        return false;
+                    end = array + 1;
+                    found = true;
+                }
+            }
+            i = end;
+            continue;
+        }
+        if (c == '{' || c == '[')
+            depth++;
+        else if (c == '}' || c == ']')
+            depth--;
+        i++;
+    }
+    if (!found)
+        return false;
+
+    for (;;) {
+        i = skipSpace(text, i, ",");
+        if (i >= text.size())
+            return false;
+        if (text[i] == ']')
+            return true;
+        if (text[i] != '{')
+            return false;
+
+        std::size_t start = i;
+        depth = 0;
+        do {
+            char c = text[i];
+            if (c == '"') {
+                i = skipString(text, i);
+                if (i == std::string::npos)
+                    return false;
+                continue;
+            }
+            if (c == '{' || c == '[')
+                depth++;
+            else if (c == '}' || c == ']')
+                depth--;
+            i++;
+        } while (depth > 0 && i < text.size());
+        if (depth != 0)
+            return false;
+
+        json record = json::parse(text.begin() + start, text.begin() + i);
+        auto code = record.find(codeColumn);
+        if (code == record.end() || !code->is_string())
+            return false;
+        index.areas[code->get<std::string>()].push_back(Range(start, i - start));
+    }
+}
+
+/*
+  Find the range of the header line of a CSV file of authority codes by
+  year, and of the line of each area. Lines of the same area next to each
+  other become one range.
+*/
+bool indexCSV(const std::string& text, AreaIndex& index) {
+    std::size_t end = text.find('\n');
+    end = end == std::string::npos ? text.size() : end + 1;
+    index.header = Range(0, end);
+
+    for (std::size_t start = end; start < text.size(); start = end) {
+        end = text.find('\n', start);
+        end = end == std::string::npos ? text.size() : end + 1;
+        if (text[start] == '"')
+            return false;
+        std::string code = text.substr(start, text.find_first_of(",\r\n", start) - start);
+        if (code.empty())
+            continue;
+
+        auto& ranges = index.areas[code];
+        if (!ranges.empty() && ranges.back().first + ranges.back().second == start)
+            ranges.back().second += end - start;
+        else
+            ranges.push_back(Range(start, end - start));
+    }
+    return true;
+}
+
+/*
+  Read a whole dataset file and index it, or false if it can't be read or
+  indexed.
+*/
+bool buildIndex(const std::string& path, const BethYw::InputFileSource& dataset, AreaIndex& index) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+    if (text.size() != index.size)
+        return false;
+
+    try {
+        if (dataset.PARSER == BethYw::SourceDataType::WelshStatsJSON)
+            return indexJSON(text, dataset.COLS.at(BethYw::SourceColumn::AUTH_CODE), index);
+        return indexCSV(text, index);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+/*
+  Get the path of the area index of a dataset. As with the snapshots, it is
+  named after a hash of the dataset's path, so one cache directory works for
+  different datasets directories.
+
+  @param cacheDir
+    The directory the index is kept in, ending in DIR_SEP
+
+  @param dir
+    The directory the dataset is in, ending in DIR_SEP
+
+  @param dataset
+    The dataset
+
+  @return
+    The path of its index file
+
+  @example
+    auto path = BethYw::areaIndexPath("cache/", "datasets/", InputFiles::POPDEN);
+    // e.g. cache/popden-1f0e3dad99908345.areas
+*/
+std::string BethYw::areaIndexPath(const std::string& cacheDir, const std::string& dir, const InputFileSource& dataset) {
+    std::string source = dir + dataset.FILE;
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(BethYw::hashBytes(source.data(), source.size())));
+    return cacheDir + dataset.CODE + "-" + hash + AREA_INDEX_SUFFIX;
+}
+
+/*
+  Read only the records of the areas in a filter from a dataset file, using
+  its area index (made first if it is missing or out of date), as a smaller
+  file in the same format that the parser can import instead of the whole
+  one.
+
+  @param dir
+    The directory the dataset is in, ending in DIR_SEP
+
+  @param dataset
+    The dataset, which must be a StatsWales JSON file or a CSV file of
+    authority codes by year
+
+  @param areasFilter
+    The codes of the areas wanted (not empty)
+
+  @param cacheDir
+    The directory the index is kept in, ending in DIR_SEP (not empty)
+
+  @param records
+    Where to put the smaller file
+
+  @return
+    true if the records were read, false if there is no cache directory,
+    the dataset is of another type or it couldn't be indexed (and should be
+    imported in full)
+
+  @example
+    std::string records;
+    if (BethYw::readAreaRecords("datasets/", InputFiles::POPDEN, {"W06000011"}, "cache/", records)) {
+      std::istringstream is(records);
+      areas.populate(is, InputFiles::POPDEN.PARSER, InputFiles::POPDEN.COLS, ...);
+    }
+*/
+bool BethYw::readAreaRecords(const std::string& dir,
+                             const InputFileSource& dataset,
+                             const StringFilterSet& areasFilter,
+                             const std::string& cacheDir,
+                             std::string& records) {
+    bool isJSON = dataset.PARSER == SourceDataType::WelshStatsJSON;
+    if (cacheDir.empty() || areasFilter.empty() || (!isJSON && dataset.PARSER != SourceDataType::AuthorityByYearCSV))
+        return false;
+
+    std::string path = dir + dataset.FILE;
+    AreaIndex stamp;
+    if (!BethYw::stampFile(path, stamp.size, stamp.modified))
+        return false;
+
+    std::string indexPath = BethYw::areaIndexPath(cacheDir, dir, dataset);
+    AreaIndex index;
+    if (!readIndex(indexPath, index) || index.size != stamp.size || index.modified != stamp.modified) {
+        index = stamp;
+        if (!buildIndex(path, dataset, index))
+            return false;
+        //a file changed while it was being read gets imported in full
+        AreaIndex after;
+        if (!BethYw::stampFile(path, after.size, after.modified)
+            || after.size != stamp.size || after.modified != stamp.modified)
+            return false;
+        writeIndex(cacheDir, indexPath, index);
+    }
+
+    //the ranges of every area wanted, in the order they are in the file
+    std::vector<Range> ranges;
+    for (auto const& code : areasFilter) {
+        auto area = index.areas.find(code);
+        if (area != index.areas.end())
+            ranges.insert(ranges.end(), area->second.begin(), area->second.end());
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    auto readRange = [&](const Range& range, std::string& into) {
+        std::size_t at = into.size();
+        into.resize(at + range.second);
+        return range.second == 0
+               || (file.seekg(range.first) && file.read(&into[at], range.second));
+    };
+
+    records.clear();
+    if (isJSON) {
+        records = "{\"value\":[";
+        for (std::size_t i = 0; i < ranges.size(); i++) {
+            if (i > 0)
+                records += ',';
+            if (!readRange(ranges[i], records))
+                return false;
+        }
+        records += "]}";
+    } else {
+        if (!readRange(index.header, records))
+            return false;
+        for (auto const& range : ranges)
+            if (!readRange(range, records))
+                return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef AREAINDEX_H_
+#define AREAINDEX_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for the area index, which says where
+  in a dataset file the records of each area are, so that with an areas
+  filter (-a) only those bytes are read and parsed instead of the whole file.
+
+  The index of a dataset is made the first time it is needed, by reading the
+  file once, and is kept in the cache directory (--cache) with the snapshots,
+  named after the dataset and a hash of its path (e.g.
+  popden-1f0e3dad99908345.areas), so the datasets directory is only ever
+  read. Without a cache directory no index is made:
+
+    size<TAB>modified time (in nanoseconds)
+    header<TAB>start+length
+    W06000001<TAB>start+length,start+length,...
+
+  For a StatsWales JSON file, the ranges are the objects in its "value" array
+  (and the header is empty). For a CSV file of authority codes by year, they
+  are the header line and the line of each area. The index is only used while
+  the size and modified time of the file still match, and is made again
+  otherwise. A file that can't be indexed (e.g. it is malformed) is just
+  imported in full, so the parser reports the error as usual.
+ */
+
+#include <string>
+
+#include "areas.h"
+#include "datasets.h"
+
+namespace BethYw {
+
+const std::string AREA_INDEX_SUFFIX = ".areas";
+
+std::string areaIndexPath(const std::string& cacheDir, const std::string& dir, const InputFileSource& dataset);
+bool readAreaRecords(const std::string& dir,
+                     const InputFileSource& dataset,
+                     const StringFilterSet& areasFilter,
+                     const std::string& cacheDir,
+                     std::string& records);
+
+} // namespace BethYw
+
+#endif // AREAINDEX_H_
@@ -12,17 +12,25 @@
   various populate() functions) and creating the Area and Measure objects.
 */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <stdexcept>
 #include <tuple>
 #include <unordered_set>
+#include <set>
+#include <sstream>
 
 #include "datasets.h"
 #include "areas.h"
 #include "measure.h"
 #include "datasets.h"
 #include "bethyw.h"
+#include "output.h"
+#include "arrow.h"
 #include "lib_json.hpp"
 /*
   An alias for the imported JSON parsing library.
@@ -71,6 +79,244 @@ void Areas::setArea(std::string localAuthorityCode, Area area) {
     }
 }
 
+/*
+  Merge the Areas imported (by populate()) from one source into this object,
+  with the same result as if the source had been imported straight into this
+  object instead. This lets sources be imported separately (e.g. at the same
+  time on different threads) and then merged in their original order.
+
+  Each parser has its own precedence, which is kept: JSON datasets add their
+  readings to any Measure already here (replacing the values of the same
+  years), and CSV files replace the whole Measure, as they call
+  Area::setMeasure() and Areas::setArea() respectively. If sketching is on
+  here, the readings merged in are sketched as though they were imported.
+
+  @param other
+    The Areas imported from the source (its Areas are moved out of it)
+
+  @param type
+    The type of the source other was imported from
+
+  @example
+    Areas data = Areas();
+    Areas dataset = Areas();
+    dataset.populate(...);
+    data.merge(std::move(dataset), BethYw::WelshStatsJSON);
+*/
+void Areas::merge(Areas other, const BethYw::SourceDataType& type){
+    for(auto& area : other.areas){
+        const std::string& code = area.first;
+        if(sketching)
+            for(auto const& measure : area.second.getMeasures())
+                for(auto const& reading : measure.second.getReadings())
+                    sketchReading(code, measure.first, measure.second.getLabel(), reading.first, reading.second);
+
+        auto existing = areas.find(code);
+        if(existing == areas.end()){
+            areas.emplace(code, std::move(area.second));
+        }else if(type == BethYw::WelshStatsJSON){
+            for(auto const& measure : area.second.getMeasures())
+                existing->second.setMeasure(measure.first, measure.second);
+        }else{
+            setArea(code, std::move(area.second));
+        }
+    }
+}
+
+/*
+  Turn on (or off) keeping sketches of each measure while importing data:
+  a t-digest of its values and a HyperLogLog of the areas with a value, for
+  approximate percentiles and counts without going through every reading.
+  Only data imported while it is on is sketched.
+
+  @param sketching
+    true to keep sketches while importing
+
+  @example
+    Areas data = Areas();
+    data.setSketching(true);
+    ...
+    auto median = data.getSketches().at("pop").values.quantile(0.5);
+*/
+void Areas::setSketching(bool sketching){
+    this->sketching = sketching;
+}
+
+/*
+  Add one imported reading to the sketches of its measure, if sketching is
+  on. A reading for an area, measure and year that has already been imported
+  replaces the old one rather than adding to it, and a value can't be taken
+  back out of a sketch, so it is only sketched the first time.
+
+  @param localAuthorityCode
+    The area the reading is for
+
+  @param codename
+    The codename of the measure (any case)
+
+  @param label
+    The measure's label
+
+  @param year
+    The year of the reading
+
+  @param value
+    The reading
+*/
+void Areas::sketchReading(const std::string& localAuthorityCode,
+                          const std::string& codename,
+                          const std::string& label,
+                          unsigned int year,
+                          double value){
+    if(!sketching)
+        return;
+
+    std::string key = BethYw::convertToLower(codename);
+    auto area = areas.find(localAuthorityCode);
+    if(area != areas.end()){
+        const Measure* measure = area->second.findMeasure(key);
+        if(measure != nullptr && measure->getReadings().count(year) > 0)
+            return;
+    }
+
+    auto& sketch = sketches[key];
+    if(sketch.label.empty())
+        sketch.label = label;
+    sketch.values.add(value);
+    sketch.areas.add(localAuthorityCode);
+}
+
+/*
+  Retrieve the sketches of each measure kept while importing with sketching
+  turned on, by (lowercase) measure codename. This function is callable from
+  a constant context.
+
+  @return
+    A reference to the sketches
+
+  @example
+    Areas data = Areas();
+    data.setSketching(true);
+    ...
+    for (auto const& sketch : data.getSketches())
+      std::cout << sketch.first << " " << sketch.second.values.quantile(0.99);
+*/
+const BethYw::SketchContainer& Areas::getSketches() const{
+    return sketches;
+}
+
+/*
+  Define a derived measure for every Area that has the measures it is
+  calculated from, e.g. "popden = pop / area". Each Area calculates it here,
+  and again if one of its inputs is set later, and the parsed expression is
+  shared between them. Areas added afterwards don't get it.
+
+  @param definition
+    The codename of the derived measure, an equals sign, and an expression
+    over other measure codenames using + - * / and brackets
+
+  @return
+    The number of Areas the derived measure was defined for
+
+  @throws
+    std::invalid_argument if the definition is not valid
+
+  @example
+    Areas data = Areas();
+    ...
+    data.defineMeasure("popden = pop / area");
+*/
+unsigned int Areas::defineMeasure(const std::string& definition){
+    auto derivation = std::make_shared<const BethYw::Derivation>(BethYw::parseDerivation(definition));
+
+    unsigned int defined = 0;
+    for(auto& area : areas)
+        if(area.second.defineMeasure(derivation))
+            defined++;
+    return defined;
+}
+
+/*
+  Add derived series of every Measure in every Area as new Measures alongside
+  it, e.g. a 3-year moving average of "pop" as "pop_ma3". Each Measure's
+  readings are gone through once, in year order, for all of the series (see
+  BethYw::transformSeries()), and years where a series has no value are left
+  out of it. The new Measures are:
+
+    <code>_ma<window>   <label> (<window>-year moving average)
+    <code>_yoy          <label> (change on previous year)
+    <code>_yoypct       <label> (% change on previous year)
+    <code>_cumsum       <label> (cumulative sum)
+
+  A series with no values at all in an Area (e.g. no consecutive years) is not
+  added to that Area.
+
+  @param transforms
+    Which series to add
+
+  @example
+    Areas data = Areas();
+    ...
+    BethYw::Transforms transforms;
+    transforms.movingAverage = true;
+    data.addTransforms(transforms);
+*/
+void Areas::addTransforms(const BethYw::Transforms& transforms){
+    if(!transforms.any())
+        return;
+
+    const std::string window = std::to_string(transforms.window);
+    const struct {
+        bool wanted;
+        std::string suffix;
+        std::string description;
+    } kinds[] = {
+        {transforms.movingAverage, "_ma" + window, " (" + window + "-year moving average)"},
+        {transforms.change, "_yoy", " (change on previous year)"},
+        {transforms.percentChange, "_yoypct", " (% change on previous year)"},
+        {transforms.cumulativeSum, "_cumsum", " (cumulative sum)"}};
+
+    std::vector<unsigned int> years;
+    std::vector<double> values;
+    std::vector<double> series[4];
+
+    for(auto& area : areas){
+        std::vector<Measure> added;
+
+        for(auto const& measure : area.second.getMeasures()){
+            years.clear();
+            values.clear();
+            for(auto const& reading : measure.second.getReadings()){
+                years.push_back(reading.first);
+                values.push_back(reading.second);
+            }
+            for(auto& output : series)
+                output.resize(years.size());
+
+            BethYw::transformSeries(years.data(), values.data(), years.size(), transforms.window,
+                                    kinds[0].wanted ? series[0].data() : nullptr,
+                                    kinds[1].wanted ? series[1].data() : nullptr,
+                                    kinds[2].wanted ? series[2].data() : nullptr,
+                                    kinds[3].wanted ? series[3].data() : nullptr);
+
+            for(unsigned int i = 0; i < 4; i++){
+                if(!kinds[i].wanted)
+                    continue;
+                Measure transformed(measure.first + kinds[i].suffix, measure.second.getLabel() + kinds[i].description);
+                for(std::size_t j = 0; j < years.size(); j++)
+                    if(!std::isnan(series[i][j]))
+                        transformed.setValue(years[j], series[i][j]);
+                if(transformed.size() > 0)
+                    added.push_back(transformed);
+            }
+        }
+
+        //added afterwards, so the Measures aren't changed while going through them
+        for(auto& measure : added)
+            area.second.setMeasure(measure.getCodename(), measure);
+    }
+}
+
 /*
   Retrieve an Area instance with a given local authority code.
 
@@ -99,6 +345,190 @@ Area& Areas::getArea(std::string localAuthorityCode){
     return areas.at(localAuthorityCode);
 }
 
+/*
+  Retrieve every Area, ordered by local authority code, without copying
+  them. This function is callable from a constant context.
+
+  @return
+    A reference to the AreasContainer
+
+  @example
+    Areas data = Areas();
+    ...
+    for (auto const& area : data.getAreas())
+      std::cout << area.second;
+*/
+const AreasContainer& Areas::getAreas() const{
+    return areas;
+}
+
+/*
+  Calculate the extended statistics for every Measure in every Area in one
+  batch. All of the readings are first packed into one pair of contiguous
+  year/value arrays, so the kernels in statistics.cpp run over memory that is
+  next to each other rather than following the nodes of each Measure's map.
+
+  @return
+    The statistics, by local authority code and then measure codename
+
+  @example
+    Areas data = Areas();
+    ...
+    auto stats = data.getStatistics();
+    auto median = stats["W06000011"]["pop"].median;
+*/
+StatisticsContainer Areas::getStatistics() const{
+    std::size_t total = 0;
+    for(auto const& area : areas)
+        for(auto const& measure : area.second.getMeasures())
+            total += measure.second.size();
+
+    std::vector<unsigned int> years;
+    std::vector<double> values;
+    years.reserve(total);
+    values.reserve(total);
+    for(auto const& area : areas){
+        for(auto const& measure : area.second.getMeasures()){
+            for(auto const& reading : measure.second.getReadings()){
+                years.push_back(reading.first);
+                values.push_back(reading.second);
+            }
+        }
+    }
+
+    //walk the Measures in the same order, each owning the next size() readings
+    StatisticsContainer stats;
+    std::size_t start = 0;
+    for(auto const& area : areas){
+        auto& areaStats = stats[area.first];
+        for(auto const& measure : area.second.getMeasures()){
+            std::size_t count = measure.second.size();
+            areaStats[measure.first] = BethYw::calculateStatistics(years.data() + start, values.data() + start, count);
+            start += count;
+        }
+    }
+    return stats;
+}
+
+/*
+  Rank the Areas by the value of one Measure in one year and return the n
+  highest (or lowest). The values for that year are gathered into one column
+  pointing back at each Area, and only the first n places are selected and
+  ordered (a heap of n, via std::partial_sort) rather than sorting them all.
+  Areas without a value for that year are left out, and ties go to the lower
+  local authority code.
+
+  @param codename
+    The codename of the Measure to rank by (any case)
+
+  @param year
+    The year of the values to rank
+
+  @param n
+    The number of places to return, at most
+
+  @param highest
+    true to rank the highest values first, false for the lowest first
+
+  @return
+    Up to n RankedArea entries, in rank order
+
+  @example
+    Areas data = Areas();
+    ...
+    auto top = data.rank("dens", 2019, 5);
+    auto name = top[0].area->getDisplayName();
+*/
+Ranking Areas::rank(const std::string& codename, unsigned int year, std::size_t n, bool highest) const{
+    const std::string key = BethYw::convertToLower(codename);
+
+    Ranking column;
+    column.reserve(areas.size());
+    for(auto const& area : areas){
+        const Measure* measure = area.second.findMeasure(key);
+        if(measure == nullptr)
+            continue;
+
+        auto const& readings = measure->getReadings();
+        auto reading = readings.find(year);
+        if(reading != readings.end() && !std::isnan(reading->second))
+            column.push_back(RankedArea{&area.second, reading->second});
+    }
+
+    auto before = [highest](const RankedArea& lhs, const RankedArea& rhs){
+        if(lhs.value != rhs.value)
+            return highest ? lhs.value > rhs.value : lhs.value < rhs.value;
+        return lhs.area->getLocalAuthorityCode() < rhs.area->getLocalAuthorityCode();
+    };
+
+    n = std::min(n, column.size());
+    std::partial_sort(column.begin(), column.begin() + n, column.end(), before);
+    column.erase(column.begin() + n, column.end());
+    return column;
+}
+
+/*
+  Correlate every measure with every other measure. The values are first laid
+  out as one column per measure codename and one row per (area, year) that
+  any measure has a value in, so each pair is compared over the areas and
+  years they both have values for (see BethYw::correlateColumns()).
+
+  @param method
+    Pearson's (linear) or Spearman's (rank) correlation
+
+  @param threads
+    The number of threads to use, or 0 for one per hardware thread
+
+  @return
+    The correlation matrix, with the measures in codename order
+
+  @example
+    Areas data = Areas();
+    ...
+    auto matrix = data.correlate(BethYw::CorrelationMethod::Spearman);
+*/
+BethYw::CorrelationMatrix Areas::correlate(BethYw::CorrelationMethod method, unsigned int threads) const{
+    BethYw::CorrelationMatrix matrix;
+    matrix.method = method;
+
+    //number the measures, and the rows each area will need
+    std::map<std::string, std::size_t> columns;
+    std::vector<std::map<unsigned int, std::size_t>> areaRows;
+    std::size_t rows = 0;
+    for(auto const& area : areas){
+        areaRows.emplace_back();
+        for(auto const& measure : area.second.getMeasures()){
+            columns.emplace(measure.first, 0);
+            for(auto const& reading : measure.second.getReadings())
+                areaRows.back().emplace(reading.first, 0);
+        }
+        for(auto& row : areaRows.back())
+            row.second = rows++;
+    }
+    for(auto& column : columns){
+        column.second = matrix.measures.size();
+        matrix.measures.push_back(column.first);
+    }
+
+    const std::size_t count = matrix.measures.size();
+    std::vector<double> values(rows * count, std::numeric_limits<double>::quiet_NaN());
+    auto rowsOfArea = areaRows.begin();
+    for(auto const& area : areas){
+        for(auto const& measure : area.second.getMeasures()){
+            double* column = values.data() + columns.at(measure.first) * rows;
+            for(auto const& reading : measure.second.getReadings())
+                column[rowsOfArea->at(reading.first)] = reading.second;
+        }
+        rowsOfArea++;
+    }
+
+    matrix.coefficients.resize(count * count);
+    matrix.counts.resize(count * count);
+    BethYw::correlateColumns(values.data(), rows, count, method,
+                             matrix.coefficients.data(), matrix.counts.data(), threads);
+    return matrix;
+}
+
 /*
   Retrieve the number of Areas within the container. This function is
   callable from a constant context, and does not modify the state of the instance, and
@@ -119,6 +549,48 @@ unsigned int Areas::size() const{
     return areas.size();
 }
 
+/*
+  Copy the Areas (and of those, the Measures and years) that pass the same
+  filters as the populate() functions, giving the same data as importing the
+  source again with those filters. This lets data imported once without
+  filters answer any number of filtered queries (e.g. in --serve mode).
+
+  @param areasFilter
+    The local authority codes of the Areas to copy, or empty/null for all
+
+  @param measuresFilter
+    The (lowercase) codenames of the Measures to copy, or empty/null for all
+
+  @param yearsFilter
+    The first and last year of the readings to copy, or null (or 0, 0) for all
+
+  @return
+    A new Areas object with the filtered data (sketching off)
+
+  @example
+    Areas data = Areas();
+    ...
+    StringFilterSet areasFilter = {"W06000011"};
+    Areas swansea = data.select(&areasFilter, nullptr, nullptr);
+*/
+Areas Areas::select(const StringFilterSet * const areasFilter,
+                    const StringFilterSet * const measuresFilter,
+                    const YearFilterTuple * const yearsFilter) const{
+    Areas selected = Areas();
+    if(isFilterEmpty(areasFilter)){
+        for(auto const& area : areas)
+            selected.areas.emplace_hint(selected.areas.end(), area.first, area.second.select(measuresFilter, yearsFilter));
+        return selected;
+    }
+
+    for(auto const& code : *areasFilter){
+        auto area = areas.find(code);
+        if(area != areas.end())
+            selected.areas.emplace(area->first, area->second.select(measuresFilter, yearsFilter));
+    }
+    return selected;
+}
+
 /*
   This function specifically parses the compiled areas.csv file of local 
   authority codes, and their names in English and Welsh.
@@ -256,49 +728,68 @@ void Areas::populateFromWelshStatsJSON(std::istream &is,
     unsigned int yearStart = std::get<0>(*yearsFilter);
     unsigned int yearEnd = std::get<1>(*yearsFilter);
 
+    //the column names are looked up once here rather than for every row
+    const std::string& codeColumn = cols.at(BethYw::SourceColumn::AUTH_CODE);
+    const std::string& nameColumn = cols.at(BethYw::SourceColumn::AUTH_NAME_ENG);
+    const std::string& yearColumn = cols.at(BethYw::SourceColumn::YEAR);
+    const std::string& valueColumn = cols.at(BethYw::SourceColumn::VALUE);
+
+    /* Here in case a JSON doesn't have a MEASURE_NAME/MEASURE_CODE
+     * if they don't it will use SINGE_MEASURE_****. */
+    auto measureCodeColumn = cols.find(BethYw::SourceColumn::MEASURE_CODE);
+    auto measureNameColumn = cols.find(BethYw::SourceColumn::MEASURE_NAME);
+    bool singleMeasure = measureCodeColumn == cols.end() || measureNameColumn == cols.end();
+    std::string singleCode;
+    std::string singleName;
+    bool singleWanted = false;
+    if(singleMeasure){
+        singleCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+        singleName = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
+        singleWanted = isFilterEmpty(measuresFilter) || filterContains(measuresFilter, BethYw::convertToLower(singleCode));
+    }
+
     json j;
     is >> j;
 
     for (auto& el : j["value"].items()) {
         auto &data = el.value();
-        std::string localAuthorityCode = data[cols.at(BethYw::SourceColumn::AUTH_CODE)];
+        std::string localAuthorityCode = data[codeColumn];
 
         //area in not already store and it in the filter or we are imporating them all
         if(isFilterEmpty(areasFilter)|| filterContains(areasFilter, localAuthorityCode)){
             if(areas.find(localAuthorityCode) == areas.end()){
                 Area temp = Area(localAuthorityCode);
-                temp.setName("eng", data[cols.at(BethYw::SourceColumn::AUTH_NAME_ENG)]);
+                temp.setName("eng", data[nameColumn]);
                 areas.insert({localAuthorityCode, temp});
             }
-            /* Here in case a JSON doesn't have a MEASURE_NAME/MEASURE_CODE
-             * if they don't it will use SINGE_MEASURE_****. */
             std::string measureCode;
             std::string measureName;
-            try{
-                measureName = data[cols.at(BethYw::SourceColumn::MEASURE_NAME)];
-                measureCode = data[cols.at(BethYw::SourceColumn::MEASURE_CODE)];
-            }catch(const std::out_of_range& error){
-                measureName = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
-                measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+            bool wanted;
+            if(singleMeasure){
+                measureCode = singleCode;
+                measureName = singleName;
+                wanted = singleWanted;
+            }else{
+                measureName = data[measureNameColumn->second];
+                measureCode = data[measureCodeColumn->second];
+                wanted = isFilterEmpty(measuresFilter) || filterContains(measuresFilter, BethYw::convertToLower(measureCode));
             }
 
-            if(isFilterEmpty(measuresFilter) || filterContains(measuresFilter, BethYw::convertToLower(measureCode))){
+            if(wanted){
 
-                double reading;
-                try{
-                    reading = data[cols.at(BethYw::SourceColumn::VALUE)];
-                }catch(const nlohmann::detail::type_error& error){
-                    std::string temp = data[cols.at(BethYw::SourceColumn::VALUE)];
-                    reading = std::stod(temp);
-                }
+                //some datasets give the value as a string
+                auto &value = data[valueColumn];
+                double reading = value.is_string() ? std::stod(value.get<std::string>()) : value.get<double>();
 
                 Measure measure = Measure(measureCode, measureName);
 
                 //turns the year string into unsigned int and happened to do some small validation
-                unsigned int year = BethYw::validateYear(data[cols.at(BethYw::SourceColumn::YEAR)]);
+                unsigned int year = BethYw::validateYear(data[yearColumn]);
 
-                if((yearsFilter == nullptr ||(yearStart == 0 && yearEnd == 0)) || (year >= yearStart && year <= yearEnd))
+                if((yearsFilter == nullptr ||(yearStart == 0 && yearEnd == 0)) || (year >= yearStart && year <= yearEnd)){
+                    sketchReading(localAuthorityCode, measureCode, measureName, year, reading);
                     measure.setValue(year, reading);
+                }
                 areas.at(localAuthorityCode).setMeasure(measureCode,measure);
             }
         }
@@ -372,7 +863,7 @@ void Areas::populateFromAuthorityByYearCSV(std::istream &is,
     auto dataCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
     auto dataName = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
 
-    if(is.good() && (isFilterEmpty(measuresFilter) || filterContains(measuresFilter, dataCode))){
+    if(is.good() && (isFilterEmpty(measuresFilter) || filterContains(measuresFilter, BethYw::convertToLower(dataCode)))){
 
         //get years for readability
         unsigned int yearStart = std::get<0>(*yearsFilter);
@@ -390,22 +881,31 @@ void Areas::populateFromAuthorityByYearCSV(std::istream &is,
         while(!(line.empty()))
             years.push_back(std::stol(getVariableCSV(line)));
 
+        //columns after the last year wanted are never read
+        std::size_t wantedColumns = 0;
+        for(std::size_t i = 0; i < years.size(); i++)
+            if(allYears || (years[i] >= yearStart && years[i] <= yearEnd))
+                wantedColumns = i + 1;
+
 
         while(std::getline(is, line)){
             std::string localAuthCode = getVariableCSV(line);
 
             if(isFilterEmpty(areasFilter) || filterContains(areasFilter, localAuthCode)){
                 Measure measure(dataCode,dataName);
-                for(auto const& year : years){
+                for(std::size_t i = 0; i < wantedColumns; i++){
+                    unsigned int year = years[i];
                     if(allYears || (year >= yearStart && year <= yearEnd)){
-                        measure.setValue(year,std::stod(getVariableCSV(line)));
+                        double value = std::stod(getVariableCSV(line));
+                        sketchReading(localAuthCode, dataCode, dataName, year, value);
+                        measure.setValue(year, value);
                     }else{
                         getVariableCSV(line);
                     }
-                    Area tempArea(localAuthCode);
-                    tempArea.setMeasure(dataCode, measure);
-                    setArea(localAuthCode, tempArea);
                 }
+                Area tempArea(localAuthCode);
+                tempArea.setMeasure(dataCode, measure);
+                setArea(localAuthCode, tempArea);
             }
         }
     }
@@ -582,15 +1082,232 @@ void Areas::populate(
     std::cout << data.toJSON();
 */
 std::string Areas::toJSON() const {
-   if(size() == 0)
-       return "{}";
+    std::ostringstream os;
+    toJSON(os);
+    return os.str();
+}
+
+/*
+  Write this Areas object, and all its containing Area instances, and the
+  Measure instances within those, straight to an output stream as JSON in a
+  single pass. The output is byte for byte the same as the string returned
+  by toJSON() above.
+
+  @param os
+    The output stream to write to
 
-   json j;
+  @example
+    Areas data = Areas();
+    ...
+    data.toJSON(std::cout);
+*/
+void Areas::toJSON(std::ostream& os) const {
+    if(size() == 0){
+        os.write("{}", 2);
+        return;
+    }
 
-  for (auto const& area : areas)
-      j[area.second.getLocalAuthorityCode()] = json::parse(area.second.toJSON());
+    char sep = '{';
+    for (auto const& area : areas){
+        os.put(sep);
+        BethYw::writeJSONString(os, area.second.getLocalAuthorityCode());
+        os.put(':');
+        area.second.toJSON(os);
+        sep = ',';
+    }
+    os.put('}');
+}
+
+/*
+  Write this Areas object as newline-delimited JSON, so a consumer can work on
+  each line as soon as it has read it instead of waiting for (and holding) one
+  large document.
+
+  By default there is one line per Area, in the same form as that Area's entry
+  in toJSON(), i.e. merging every line gives the toJSON() document:
+    {"W06000011":{"measures":{...},"names":{...}}}
+
+  With perMeasure set there is one line per Measure in each Area instead:
+    {"area":"W06000011","measure":"pop","label":"Population","values":{...}}
+
+  @param os
+    The output stream to write to
+
+  @param perMeasure
+    true for one line per Measure, false for one line per Area
+
+  @example
+    Areas data = Areas();
+    ...
+    data.toNDJSON(std::cout);
+*/
+void Areas::toNDJSON(std::ostream& os, bool perMeasure) const {
+    for (auto const& area : areas) {
+        if (!perMeasure) {
+            os.put('{');
+            BethYw::writeJSONString(os, area.first);
+            os.put(':');
+            area.second.toJSON(os);
+            os.write("}\n", 2);
+            continue;
+        }
+
+        for (auto const& measure : area.second.getMeasures()) {
+            os.write("{\"area\":", 8);
+            BethYw::writeJSONString(os, area.first);
+            os.write(",\"measure\":", 11);
+            BethYw::writeJSONString(os, measure.first);
+            os.write(",\"label\":", 9);
+            BethYw::writeJSONString(os, measure.second.getLabel());
+            os.write(",\"values\":", 10);
+            measure.second.toJSON(os);
+            os.write("}\n", 2);
+        }
+    }
+}
+
+/*
+  Write this Areas object as long format delimiter-separated values, one row
+  per reading:
+    area,measure,year,value
+  Rows are ordered by local authority code, then measure codename, then year.
+  Values are written in their shortest round-trip form.
+
+  @param os
+    The output stream to write to
+
+  @param delimiter
+    The character between fields, ',' for CSV or '\t' for TSV
+
+  @example
+    Areas data = Areas();
+    ...
+    data.toCSV(std::cout);       // CSV
+    data.toCSV(std::cout, '\t'); // TSV
+*/
+void Areas::toCSV(std::ostream& os, char delimiter) const {
+    os << "area" << delimiter << "measure" << delimiter << "year" << delimiter << "value\n";
+
+    char year[16];
+    for (auto const& area : areas) {
+        for (auto const& measure : area.second.getMeasures()) {
+            for (auto const& reading : measure.second.getReadings()) {
+                BethYw::writeCSVField(os, area.first, delimiter);
+                os.put(delimiter);
+                BethYw::writeCSVField(os, measure.first, delimiter);
+                os.put(delimiter);
+                os.write(year, BethYw::formatUnsigned(year, reading.first) - year);
+                os.put(delimiter);
+                BethYw::writeCSVNumber(os, reading.second);
+                os.put('\n');
+            }
+        }
+    }
+}
+
+/*
+  Write this Areas object as wide format delimiter-separated values, one row
+  per Measure in each Area and one column per year:
+    area,measure,<year 1>,<year 2>,...,<year n>
+  The years are every year found in any Measure, and a Measure without a
+  reading for a year has an empty field in that column.
+
+  @param os
+    The output stream to write to
+
+  @param delimiter
+    The character between fields, ',' for CSV or '\t' for TSV
+
+  @example
+    Areas data = Areas();
+    ...
+    data.toWideCSV(std::cout);
+*/
+void Areas::toWideCSV(std::ostream& os, char delimiter) const {
+    std::set<unsigned int> years;
+    for (auto const& area : areas)
+        for (auto const& measure : area.second.getMeasures())
+            for (auto const& reading : measure.second.getReadings())
+                years.insert(reading.first);
+
+    os << "area" << delimiter << "measure";
+    for (auto const& year : years)
+        os << delimiter << year;
+    os.put('\n');
+
+    for (auto const& area : areas) {
+        for (auto const& measure : area.second.getMeasures()) {
+            BethYw::writeCSVField(os, area.first, delimiter);
+            os.put(delimiter);
+            BethYw::writeCSVField(os, measure.first, delimiter);
+
+            //both are ordered by year, so walk them side by side
+            auto const& readings = measure.second.getReadings();
+            auto reading = readings.begin();
+            for (auto const& year : years) {
+                os.put(delimiter);
+                if (reading != readings.end() && reading->first == year) {
+                    BethYw::writeCSVNumber(os, reading->second);
+                    ++reading;
+                }
+            }
+            os.put('\n');
+        }
+    }
+}
+
+/*
+  Write this Areas object as an Apache Arrow IPC stream, with one row per
+  reading in the columns area and measure (both dictionary-encoded strings),
+  year (uint32) and value (float64). Rows are ordered the same way as toCSV().
+
+  @param os
+    The output stream to write to, which should be opened in binary mode
+
+  @example
+    Areas data = Areas();
+    ...
+    std::ofstream file("data.arrows", std::ios::binary);
+    data.toArrow(file);
+*/
+void Areas::toArrow(std::ostream& os) const {
+    BethYw::ArrowColumns columns;
+
+    //Key = measure codename | Value = index in the measure dictionary
+    std::map<std::string, std::int32_t> measureIndices;
+    std::size_t rows = 0;
+    for (auto const& area : areas) {
+        for (auto const& measure : area.second.getMeasures()) {
+            measureIndices.insert({measure.first, 0});
+            rows += measure.second.size();
+        }
+    }
+    for (auto& measure : measureIndices) {
+        measure.second = static_cast<std::int32_t>(columns.measureCodes.size());
+        columns.measureCodes.push_back(measure.first);
+    }
+
+    columns.areas.reserve(rows);
+    columns.measures.reserve(rows);
+    columns.years.reserve(rows);
+    columns.values.reserve(rows);
+
+    for (auto const& area : areas) {
+        auto areaIndex = static_cast<std::int32_t>(columns.areaCodes.size());
+        columns.areaCodes.push_back(area.first);
+
+        for (auto const& measure : area.second.getMeasures()) {
+            auto measureIndex = measureIndices.at(measure.first);
+            for (auto const& reading : measure.second.getReadings()) {
+                columns.areas.push_back(areaIndex);
+                columns.measures.push_back(measureIndex);
+                columns.years.push_back(static_cast<std::uint32_t>(reading.first));
+                columns.values.push_back(reading.second);
+            }
+        }
+    }
 
-  return j.dump();
+    BethYw::writeArrowStream(os, columns);
 }
 
 /*
@@ -31,6 +31,8 @@
 #include <vector>
 #include "datasets.h"
 #include "area.h"
+#include "correlation.h"
+#include "sketch.h"
 
 
 /*
@@ -52,6 +54,28 @@ using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
 
 using AreasContainer = std::map<std::string, Area>;
 
+/*
+  An alias for the extended statistics of every Measure in an Areas object.
+  Key = local authority code | Value = (Key = measure codename |
+  Value = the statistics for that Measure)
+*/
+using StatisticsContainer = std::map<std::string, std::map<std::string, BethYw::Statistics>>;
+
+/*
+  One place in a ranking of Areas by the value of a Measure in one year. The
+  Area is pointed to rather than copied, so it is only valid while the Areas
+  object it was ranked from is unchanged.
+*/
+struct RankedArea {
+  const Area* area;
+  double value;
+};
+
+/*
+  An alias for the Areas in a ranking, in rank order.
+*/
+using Ranking = std::vector<RankedArea>;
+
 /*
   Areas is a class that stores all the data categorised by area. The 
   underlying Standard Library container is customisable using the alias above.
@@ -63,8 +87,18 @@ private:
     //Key Local authority code | Value Area objects
     AreasContainer areas;
 
+    //Approximate statistics of each measure across every Area, only kept
+    //up to date while importing when sketching is turned on
+    bool sketching = false;
+    BethYw::SketchContainer sketches;
+
     /*----Helper----*/
     std::string getVariableCSV(std::string& line);
+    void sketchReading(const std::string& localAuthorityCode,
+                       const std::string& codename,
+                       const std::string& label,
+                       unsigned int year,
+                       double value);
 
 public:
   /*----Constructors----*/
@@ -72,9 +106,21 @@ public:
 
   /*----Setters---*/
   void setArea(std::string localAuthorityCode, Area area);
+  void setSketching(bool sketching);
+  void merge(Areas other, const BethYw::SourceDataType& type);
+  unsigned int defineMeasure(const std::string& definition) noexcept(false);
+  void addTransforms(const BethYw::Transforms& transforms);
 
   /*----Getters---*/
   Area& getArea(std::string localAuthorityCode);
+  const AreasContainer& getAreas() const;
+  const BethYw::SketchContainer& getSketches() const;
+  StatisticsContainer getStatistics() const;
+  Ranking rank(const std::string& codename, unsigned int year, std::size_t n, bool highest = true) const;
+  BethYw::CorrelationMatrix correlate(BethYw::CorrelationMethod method, unsigned int threads = 0) const;
+  Areas select(const StringFilterSet * const areasFilter,
+               const StringFilterSet * const measuresFilter,
+               const YearFilterTuple * const yearsFilter) const;
 
 /*----Populate----*/
   void populate(
@@ -109,6 +155,11 @@ public:
 
   /*----Miscellaneous---*/
   std::string toJSON() const;
+  void toJSON(std::ostream& os) const;
+  void toCSV(std::ostream& os, char delimiter = ',') const;
+  void toWideCSV(std::ostream& os, char delimiter = ',') const;
+  void toArrow(std::ostream& os) const;
+  void toNDJSON(std::ostream& os, bool perMeasure = false) const;
   unsigned int size() const;
   bool isFilterEmpty(const StringFilterSet * const filter) const;
   bool filterContains(const StringFilterSet * const filter, std::string value);
@@ -0,0 +1,412 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the Apache Arrow IPC stream
+  writer. See the header file for additional comments.
+
+  An Arrow IPC stream is a series of messages, each made up of:
+    0xFFFFFFFF, the length of the metadata, the metadata, then the body
+  where the metadata is a FlatBuffers-encoded Message (see Message.fbs and
+  Schema.fbs in the Arrow repository) and the body holds the column buffers.
+  The stream is ended by 0xFFFFFFFF followed by a length of 0.
+
+  We write a Schema message, one DictionaryBatch for each dictionary-encoded
+  column, and then a single RecordBatch with every row.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow.h"
+
+namespace {
+
+/*
+  Append a little-endian integer to the end of a string.
+*/
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+    auto bits = static_cast<std::uint64_t>(value);
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+}
+
+/*
+  A minimal FlatBuffers builder, with just enough of the format to write
+  Arrow's metadata: tables of scalars and offsets, strings, and vectors of
+  offsets or of 16 byte structs.
+
+  Like the official builder it works from the back of the buffer to the
+  front, so every object must be created before the object that refers to
+  it. Positions are measured as the number of bytes from the end of the
+  buffer, which doesn't change as more bytes are added to the front.
+*/
+class FlatBufferBuilder {
+private:
+    //the bytes written so far, which end up at the end of the finished buffer
+    std::string buffer;
+
+    //the largest alignment needed by anything in the buffer
+    std::size_t minAlign = 1;
+
+    //where the table currently being built starts
+    std::uint32_t tableStart = 0;
+
+    //Key = field id | Value = position the field was written at
+    std::vector<std::pair<std::uint16_t, std::uint32_t>> fields;
+
+    void prepend(const std::string& bytes) {
+        buffer.insert(0, bytes);
+    }
+
+    //pad so that once `extra` more bytes are added, the size is aligned
+    void preAlign(std::size_t extra, std::size_t alignment) {
+        if (alignment > minAlign)
+            minAlign = alignment;
+        buffer.insert(0, (alignment - (buffer.size() + extra) % alignment) % alignment, '\0');
+    }
+
+    template <typename T>
+    void prependScalar(T value) {
+        preAlign(sizeof(T), sizeof(T));
+        std::string bytes;
+        appendLittleEndian(bytes, value);
+        prepend(bytes);
+    }
+
+    //an offset is stored relative to where it is written
+    void prependOffset(std::uint32_t position) {
+        preAlign(sizeof(std::uint32_t), sizeof(std::uint32_t));
+        prependScalar<std::uint32_t>(size() + sizeof(std::uint32_t) - position);
+    }
+
+public:
+    std::uint32_t size() const {
+        return static_cast<std::uint32_t>(buffer.size());
+    }
+
+    void startTable() {
+        fields.clear();
+        tableStart = size();
+    }
+
+    template <typename T>
+    void addScalar(std::uint16_t id, T value) {
+        prependScalar(value);
+        fields.emplace_back(id, size());
+    }
+
+    void addOffset(std::uint16_t id, std::uint32_t position) {
+        prependOffset(position);
+        fields.emplace_back(id, size());
+    }
+
+    /*
+      Finish the current table by writing its vtable (the offset of each
+      field from the start of the table) directly in front of it.
+    */
+    std::uint32_t endTable() {
+        prependScalar<std::int32_t>(0);
+        std::uint32_t table = size();
+
+        std::uint16_t numFields = 0;
+        for (auto const& field : fields)
+            if (field.first + 1 > numFields)
+                numFields = field.first + 1;
+
+        std::vector<std::uint16_t> vtable(numFields, 0);
+        for (auto const& field : fields)
+            vtable[field.first] = static_cast<std::uint16_t>(table - field.second);
+
+        for (std::size_t i = numFields; i-- > 0;)
+            prependScalar<std::uint16_t>(vtable[i]);
+        prependScalar<std::uint16_t>(static_cast<std::uint16_t>(table - tableStart));
+        prependScalar<std::uint16_t>(static_cast<std::uint16_t>((numFields + 2) * sizeof(std::uint16_t)));
+
+        //the table starts with the (signed) distance back to its vtable
+        std::string distance;
+        appendLittleEndian<std::int32_t>(distance, static_cast<std::int32_t>(size() - table));
+        buffer.replace(buffer.size() - table, distance.size(), distance);
+
+        fields.clear();
+        return table;
+    }
+
+    std::uint32_t createString(const std::string& value) {
+        preAlign(value.size() + 1, sizeof(std::uint32_t));
+        buffer.insert(0, 1, '\0');
+        prepend(value);
+        prependScalar<std::uint32_t>(static_cast<std::uint32_t>(value.size()));
+        return size();
+    }
+
+    std::uint32_t createOffsetVector(const std::vector<std::uint32_t>& positions) {
+        preAlign(positions.size() * sizeof(std::uint32_t), sizeof(std::uint32_t));
+        for (std::size_t i = positions.size(); i-- > 0;)
+            prependOffset(positions[i]);
+        prependScalar<std::uint32_t>(static_cast<std::uint32_t>(positions.size()));
+        return size();
+    }
+
+    //Arrow's FieldNode and Buffer structs are both a pair of int64s
+    std::uint32_t createStructVector(const std::vector<std::pair<std::int64_t, std::int64_t>>& structs) {
+        const std::size_t bytes = structs.size() * 2 * sizeof(std::int64_t);
+        preAlign(bytes, sizeof(std::uint32_t));
+        preAlign(bytes, sizeof(std::int64_t));
+        for (std::size_t i = structs.size(); i-- > 0;) {
+            prependScalar<std::int64_t>(structs[i].second);
+            prependScalar<std::int64_t>(structs[i].first);
+        }
+        prependScalar<std::uint32_t>(static_cast<std::uint32_t>(structs.size()));
+        return size();
+    }
+
+    /*
+      Write the offset to the root table at the very front and return the
+      finished buffer.
+    */
+    std::string finish(std::uint32_t root) {
+        preAlign(sizeof(std::uint32_t), minAlign);
+        prependOffset(root);
+        return buffer;
+    }
+};
+
+/*
+  The body of a message: column buffers, each padded to 8 bytes, along with
+  the offset and length of each buffer for the RecordBatch metadata.
+*/
+struct MessageBody {
+    std::string bytes;
+    std::vector<std::pair<std::int64_t, std::int64_t>> buffers;
+
+    void addBuffer(const std::string& data) {
+        buffers.emplace_back(bytes.size(), data.size());
+        bytes += data;
+        bytes.append((8 - bytes.size() % 8) % 8, '\0');
+    }
+
+    //a validity bitmap can be left out when a column has no nulls
+    void addEmptyBuffer() {
+        buffers.emplace_back(bytes.size(), 0);
+    }
+};
+
+//values from the enums and unions in Schema.fbs and Message.fbs
+const std::int16_t METADATA_V5 = 4;
+const std::uint8_t HEADER_SCHEMA = 1;
+const std::uint8_t HEADER_DICTIONARY_BATCH = 2;
+const std::uint8_t HEADER_RECORD_BATCH = 3;
+const std::uint8_t TYPE_INT = 2;
+const std::uint8_t TYPE_FLOATING_POINT = 3;
+const std::uint8_t TYPE_UTF8 = 5;
+const std::int16_t PRECISION_DOUBLE = 2;
+
+std::uint32_t createIntType(FlatBufferBuilder& fbb, std::int32_t bitWidth, bool isSigned) {
+    fbb.startTable();
+    fbb.addScalar<std::int32_t>(0, bitWidth);
+    fbb.addScalar<std::uint8_t>(1, isSigned ? 1 : 0);
+    return fbb.endTable();
+}
+
+std::uint32_t createEmptyTable(FlatBufferBuilder& fbb) {
+    fbb.startTable();
+    return fbb.endTable();
+}
+
+std::uint32_t createField(FlatBufferBuilder& fbb,
+                          const std::string& name,
+                          std::uint8_t typeType,
+                          std::uint32_t type,
+                          std::uint32_t dictionary) {
+    std::uint32_t nameString = fbb.createString(name);
+    std::uint32_t children = fbb.createOffsetVector({});
+
+    fbb.startTable();
+    fbb.addOffset(0, nameString);
+    fbb.addScalar<std::uint8_t>(1, 0);
+    fbb.addScalar<std::uint8_t>(2, typeType);
+    fbb.addOffset(3, type);
+    if (dictionary != 0)
+        fbb.addOffset(4, dictionary);
+    fbb.addOffset(5, children);
+    return fbb.endTable();
+}
+
+std::uint32_t createDictionaryField(FlatBufferBuilder& fbb, const std::string& name, std::int64_t id) {
+    std::uint32_t utf8 = createEmptyTable(fbb);
+    std::uint32_t indexType = createIntType(fbb, 32, true);
+
+    fbb.startTable();
+    fbb.addScalar<std::int64_t>(0, id);
+    fbb.addOffset(1, indexType);
+    std::uint32_t encoding = fbb.endTable();
+
+    return createField(fbb, name, TYPE_UTF8, utf8, encoding);
+}
+
+std::uint32_t createRecordBatch(FlatBufferBuilder& fbb,
+                                std::int64_t length,
+                                const std::vector<std::pair<std::int64_t, std::int64_t>>& nodes,
+                                const MessageBody& body) {
+    std::uint32_t nodesVector = fbb.createStructVector(nodes);
+    std::uint32_t buffersVector = fbb.createStructVector(body.buffers);
+
+    fbb.startTable();
+    fbb.addScalar<std::int64_t>(0, length);
+    fbb.addOffset(1, nodesVector);
+    fbb.addOffset(2, buffersVector);
+    return fbb.endTable();
+}
+
+std::string finishMessage(FlatBufferBuilder& fbb,
+                          std::uint8_t headerType,
+                          std::uint32_t header,
+                          std::int64_t bodyLength) {
+    fbb.startTable();
+    fbb.addScalar<std::int16_t>(0, METADATA_V5);
+    fbb.addScalar<std::uint8_t>(1, headerType);
+    fbb.addOffset(2, header);
+    fbb.addScalar<std::int64_t>(3, bodyLength);
+    return fbb.finish(fbb.endTable());
+}
+
+/*
+  Write one encapsulated message: the continuation marker, the length of the
+  (8 byte padded) metadata, the metadata, and then the body.
+*/
+void writeMessage(std::ostream& os, std::string metadata, const std::string& body) {
+    metadata.append((8 - metadata.size() % 8) % 8, '\0');
+
+    std::string prefix;
+    appendLittleEndian<std::uint32_t>(prefix, 0xFFFFFFFF);
+    appendLittleEndian<std::int32_t>(prefix, static_cast<std::int32_t>(metadata.size()));
+
+    os.write(prefix.data(), prefix.size());
+    os.write(metadata.data(), metadata.size());
+    os.write(body.data(), body.size());
+}
+
+void writeSchema(std::ostream& os) {
+    FlatBufferBuilder fbb;
+
+    std::uint32_t area = createDictionaryField(fbb, "area", 0);
+    std::uint32_t measure = createDictionaryField(fbb, "measure", 1);
+    std::uint32_t year = createField(fbb, "year", TYPE_INT, createIntType(fbb, 32, false), 0);
+
+    fbb.startTable();
+    fbb.addScalar<std::int16_t>(0, PRECISION_DOUBLE);
+    std::uint32_t doubleType = fbb.endTable();
+    std::uint32_t value = createField(fbb, "value", TYPE_FLOATING_POINT, doubleType, 0);
+
+    std::uint32_t fields = fbb.createOffsetVector({area, measure, year, value});
+
+    fbb.startTable();
+    fbb.addOffset(1, fields);
+    std::uint32_t schema = fbb.endTable();
+
+    writeMessage(os, finishMessage(fbb, HEADER_SCHEMA, schema, 0), "");
+}
+
+void writeDictionary(std::ostream& os, std::int64_t id, const std::vector<std::string>& strings) {
+    std::string offsets;
+    std::string data;
+    appendLittleEndian<std::int32_t>(offsets, 0);
+    for (auto const& string : strings) {
+        data += string;
+        appendLittleEndian<std::int32_t>(offsets, static_cast<std::int32_t>(data.size()));
+    }
+
+    MessageBody body;
+    body.addEmptyBuffer();
+    body.addBuffer(offsets);
+    body.addBuffer(data);
+
+    const std::int64_t length = strings.size();
+
+    FlatBufferBuilder fbb;
+    std::uint32_t batch = createRecordBatch(fbb, length, {{length, 0}}, body);
+
+    fbb.startTable();
+    fbb.addScalar<std::int64_t>(0, id);
+    fbb.addOffset(1, batch);
+    std::uint32_t dictionary = fbb.endTable();
+
+    writeMessage(os, finishMessage(fbb, HEADER_DICTIONARY_BATCH, dictionary, body.bytes.size()), body.bytes);
+}
+
+template <typename T>
+std::string columnBuffer(const std::vector<T>& column) {
+    std::string bytes;
+    bytes.reserve(column.size() * sizeof(T));
+    for (auto const& value : column)
+        appendLittleEndian<T>(bytes, value);
+    return bytes;
+}
+
+std::string columnBuffer(const std::vector<double>& column) {
+    std::string bytes;
+    bytes.reserve(column.size() * sizeof(double));
+    for (double value : column) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        appendLittleEndian<std::uint64_t>(bytes, bits);
+    }
+    return bytes;
+}
+
+} // namespace
+
+/*
+  Write a table as an Apache Arrow IPC stream.
+
+  @param os
+    The output stream to write to, which should be opened in binary mode
+
+  @param columns
+    The dictionaries and row columns of the table
+
+  @example
+    BethYw::ArrowColumns columns;
+    columns.areaCodes = {"W06000011"};
+    columns.measureCodes = {"pop"};
+    columns.areas = {0};
+    columns.measures = {0};
+    columns.years = {1991};
+    columns.values = {69123};
+    BethYw::writeArrowStream(std::cout, columns);
+*/
+void BethYw::writeArrowStream(std::ostream& os, const ArrowColumns& columns) {
+    writeSchema(os);
+    writeDictionary(os, 0, columns.areaCodes);
+    writeDictionary(os, 1, columns.measureCodes);
+
+    MessageBody body;
+    body.addEmptyBuffer();
+    body.addBuffer(columnBuffer(columns.areas));
+    body.addEmptyBuffer();
+    body.addBuffer(columnBuffer(columns.measures));
+    body.addEmptyBuffer();
+    body.addBuffer(columnBuffer(columns.years));
+    body.addEmptyBuffer();
+    body.addBuffer(columnBuffer(columns.values));
+
+    const std::int64_t length = columns.values.size();
+
+    FlatBufferBuilder fbb;
+    std::uint32_t batch = createRecordBatch(fbb, length, {{length, 0}, {length, 0}, {length, 0}, {length, 0}}, body);
+    writeMessage(os, finishMessage(fbb, HEADER_RECORD_BATCH, batch, body.bytes.size()), body.bytes);
+
+    //end of stream
+    std::string end;
+    appendLittleEndian<std::uint32_t>(end, 0xFFFFFFFF);
+    appendLittleEndian<std::int32_t>(end, 0);
+    os.write(end.data(), end.size());
+}
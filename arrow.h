@@ -0,0 +1,53 @@
+#ifndef ARROW_H_
+#define ARROW_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for writing data as an Apache Arrow IPC
+  stream (https://arrow.apache.org/docs/format/Columnar.html), which tools
+  such as pandas, Polars and DuckDB can read without parsing any text.
+
+  The stream has a single table of four columns:
+    area     dictionary-encoded utf8 (int32 indices)
+    measure  dictionary-encoded utf8 (int32 indices)
+    year     uint32
+    value    float64
+
+  The Arrow metadata is encoded with a small FlatBuffers builder in arrow.cpp,
+  so nothing outside this repository is needed.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace BethYw {
+
+/*
+  The columns of the table written to an Arrow stream. areas and measures are
+  indices into areaCodes and measureCodes respectively, and all four row
+  columns must be the same length.
+*/
+struct ArrowColumns {
+  // the dictionaries of the two dictionary-encoded columns
+  std::vector<std::string> areaCodes;
+  std::vector<std::string> measureCodes;
+
+  // one entry per row
+  std::vector<std::int32_t> areas;
+  std::vector<std::int32_t> measures;
+  std::vector<std::uint32_t> years;
+  std::vector<double> values;
+};
+
+void writeArrowStream(std::ostream& os, const ArrowColumns& columns);
+
+} // namespace BethYw
+
+#endif // ARROW_H_
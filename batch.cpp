@@ -0,0 +1,195 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of --batch mode. See the header file
+  for additional comments.
+
+  Every query is answered by BethYw::answerQuery(), the same function --serve
+  uses, so a batch file gives exactly what the same queries sent to a server
+  (or, for program arguments, the command line) would.
+ */
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "bethyw.h"
+#include "batch.h"
+#include "datasets.h"
+#include "parallel.h"
+#include "query.h"
+#include "server.h"
+
+/*
+  Read a batch file: one job per line, the output file first (in quotes if it
+  has spaces) and then the query. Blank lines and lines starting with # are
+  skipped. Each output file can only be named once, as the jobs are run at
+  the same time.
+
+  @param in
+    The stream to read the batch file from
+
+  @return
+    The jobs, in the order of the file
+
+  @throws
+    std::invalid_argument if a line has an output file but no query, an
+    unclosed quote around the file, or an output file already named by an
+    earlier line
+
+  @example
+    std::ifstream file("queries.txt");
+    auto jobs = BethYw::readBatch(file);
+*/
+std::vector<BethYw::BatchJob> BethYw::readBatch(std::istream& in) {
+    std::vector<BatchJob> jobs;
+    std::map<std::string, unsigned int> files;
+    std::string line;
+    unsigned int number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        BatchJob job;
+        std::size_t end;
+        if (line[start] == '"' || line[start] == '\'') {
+            end = line.find(line[start], start + 1);
+            if (end == std::string::npos)
+                throw std::invalid_argument("Invalid batch line " + std::to_string(number) + ": unclosed quote");
+            job.file = line.substr(start + 1, end - start - 1);
+            end++;
+        } else {
+            end = line.find_first_of(" \t", start);
+            job.file = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        }
+
+        std::size_t query = end == std::string::npos ? end : line.find_first_not_of(" \t", end);
+        if (query == std::string::npos || job.file.empty())
+            throw std::invalid_argument("Invalid batch line " + std::to_string(number)
+                                        + ": expected an output file and a query");
+        job.query = line.substr(query);
+
+        auto named = files.emplace(job.file, number);
+        if (!named.second)
+            throw std::invalid_argument("Invalid batch line " + std::to_string(number) + ": output file "
+                                        + job.file + " is already written by line "
+                                        + std::to_string(named.first->second));
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+/*
+  Work out every dataset the jobs need between them, so each can be imported
+  once before any query is answered. A query that isn't valid needs nothing
+  (its answer will be the error).
+
+  @param jobs
+    The jobs of a batch file
+
+  @return
+    The codes of the datasets needed, in the order of the DATASETS array in
+    datasets.h
+
+  @example
+    auto codes = BethYw::batchDatasets(jobs);
+    catalogue.load(BethYw::findDatasets(codes));
+*/
+std::vector<std::string> BethYw::batchDatasets(const std::vector<BatchJob>& jobs) {
+    std::set<std::string> needed;
+    for (auto const& job : jobs) {
+        try {
+            std::vector<std::string> codes;
+            if (BethYw::isQuery(job.query)) {
+                BethYw::Query query(job.query);
+                if (!query.isExplain() && !query.isEmpty())
+                    codes = query.getSelection().datasets;
+            } else {
+                auto args = BethYw::parseArguments(BethYw::splitArguments(job.query));
+                codes = BethYw::parseSelection(args).datasets;
+            }
+            for (auto const& dataset : BethYw::findDatasets(codes))
+                needed.insert(dataset.CODE);
+        } catch (const std::exception&) {
+            continue;
+        }
+    }
+
+    std::vector<std::string> codes;
+    for (auto const& dataset : InputFiles::DATASETS)
+        if (needed.find(dataset.CODE) != needed.end())
+            codes.push_back(dataset.CODE);
+    return codes;
+}
+
+/*
+  Run a batch: import every dataset the jobs need into the Catalogue at once,
+  then answer the queries on a pool of threads, writing each answer to its
+  file. A job whose query fails (or whose file can't be written) writes
+  nothing, and gets a line starting with its file name in the log instead.
+
+  @param catalogue
+    The datasets in memory
+
+  @param jobs
+    The jobs to run
+
+  @param log
+    The stream for the errors and the line saying how many files were written
+
+  @param threads
+    The number of threads to answer queries on, or 0 for one per core
+
+  @return
+    The number of jobs that failed
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    std::ifstream file("queries.txt");
+    BethYw::runBatch(catalogue, BethYw::readBatch(file), std::cerr);
+*/
+unsigned int BethYw::runBatch(Catalogue& catalogue,
+                              const std::vector<BatchJob>& jobs,
+                              std::ostream& log,
+                              unsigned int threads) {
+    //if this fails, the queries that need the dataset will say so themselves
+    try {
+        catalogue.load(BethYw::findDatasets(BethYw::batchDatasets(jobs)));
+    } catch (const std::exception& error) {
+        log << "Error importing dataset: " << error.what() << '\n';
+    }
+
+    std::vector<std::string> errors(jobs.size());
+    BethYw::parallelFor(jobs.size(), [&](std::size_t i) {
+        std::ostringstream answer;
+        if (!BethYw::answerQuery(catalogue, jobs[i].query, answer)) {
+            errors[i] = answer.str();
+            return;
+        }
+
+        std::ofstream file(jobs[i].file, std::ios::binary);
+        std::string text = answer.str();
+        if (!file || !file.write(text.data(), text.size()))
+            errors[i] = "Error: Failed to write file " + jobs[i].file + '\n';
+    }, threads);
+
+    unsigned int failed = 0;
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        if (!errors[i].empty()) {
+            log << jobs[i].file << ": " << errors[i];
+            failed++;
+        }
+    }
+    log << "Wrote " << jobs.size() - failed << " of " << jobs.size() << " files\n";
+    return failed;
+}
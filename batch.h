@@ -0,0 +1,51 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for --batch mode, which runs a file of
+  queries against one import of the datasets. Each line of the file is the
+  file to write the answer to, then the query, in either form --serve takes
+  (program arguments, or a SELECT from query.h):
+
+    # comments and blank lines are skipped
+    swansea.json   -d popden -a W06000011 -j
+    top-dens.csv   SELECT area, value FROM popden WHERE measure = dens
+                   AND year = 2015 ORDER BY value DESC LIMIT 10 FORMAT CSV
+
+  (each query on one line). The datasets every query needs are worked out
+  first and imported once, in parallel, into a Catalogue; then the queries
+  are answered in parallel from it, each written to its own file.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catalogue.h"
+
+namespace BethYw {
+
+/*
+  One line of a batch file: where to write the answer, and the query.
+*/
+struct BatchJob {
+  std::string file;
+  std::string query;
+};
+
+std::vector<BatchJob> readBatch(std::istream& in) noexcept(false);
+std::vector<std::string> batchDatasets(const std::vector<BatchJob>& jobs);
+unsigned int runBatch(Catalogue& catalogue,
+                      const std::vector<BatchJob>& jobs,
+                      std::ostream& log,
+                      unsigned int threads = 0);
+
+} // namespace BethYw
+
+#endif // BATCH_H_
@@ -0,0 +1,225 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Benchmarks of the parsers, the output and the statistics, run on the
+  bundled datasets. Build with ./build.sh bench (which turns on the
+  optimiser) and run:
+
+    ./bin/bethyw-bench [repetitions] [datasets directory]
+
+  Each benchmark is run once to warm up and then the given number of times
+  (10 by default). The median time is reported with the standard deviation
+  and the interquartile range, along with the rows per second (readings of
+  an area, measure and year, or areas for areas.csv) and, where there is a
+  file or text to go through, the MB per second.
+
+  The files are read into memory first, so the parsers are timed without the
+  disk.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../statistics.h"
+
+namespace {
+
+struct BenchResult {
+  std::string name;
+  std::string input;
+  std::vector<double> seconds;
+  std::size_t rows;
+  std::size_t bytes;
+};
+
+struct ParsedDataset {
+  BethYw::InputFileSource source;
+  std::string contents;
+  Areas data;
+};
+
+// written to after each run so the optimiser can't leave the work out
+volatile std::size_t sink = 0;
+
+/*
+  Read a whole file into memory.
+*/
+std::string readFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Failed to open " + path);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+/*
+  The number of readings in every measure of every area.
+*/
+std::size_t countReadings(const Areas& data) {
+  std::size_t readings = 0;
+  for (auto const& area : data.getAreas())
+    for (auto const& measure : area.second.getMeasures())
+      readings += measure.second.size();
+  return readings;
+}
+
+/*
+  Name the parser Areas::populate() hands a type of file to.
+*/
+std::string parserName(BethYw::SourceDataType type) {
+  switch (type) {
+    case BethYw::AuthorityCodeCSV:
+      return "populateFromAuthorityCodeCSV";
+    case BethYw::WelshStatsJSON:
+      return "populateFromWelshStatsJSON";
+    case BethYw::AuthorityByYearCSV:
+      return "populateFromAuthorityByYearCSV";
+    default:
+      return "populate";
+  }
+}
+
+/*
+  Parse a file already in memory with no filters.
+*/
+Areas parse(const ParsedDataset& dataset) {
+  const StringFilterSet all;
+  const YearFilterTuple allYears(0, 0);
+  std::istringstream is(dataset.contents);
+  Areas data = Areas();
+  data.populate(is, dataset.source.PARSER, dataset.source.COLS, &all, &all, &allYears);
+  return data;
+}
+
+/*
+  Run some work once to warm up, then time it the given number of times.
+*/
+template <typename Work>
+BenchResult run(const std::string& name,
+                const std::string& input,
+                std::size_t rows,
+                std::size_t bytes,
+                unsigned int repetitions,
+                Work work) {
+  BenchResult result{name, input, {}, rows, bytes};
+  work();
+  for (unsigned int i = 0; i < repetitions; i++) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    auto end = std::chrono::steady_clock::now();
+    result.seconds.push_back(std::chrono::duration<double>(end - start).count());
+  }
+  return result;
+}
+
+/*
+  Write one line of the report: the median time with its spread, and the
+  throughput at the median.
+*/
+void report(std::ostream& os, const BenchResult& result) {
+  std::vector<unsigned int> runs(result.seconds.size());
+  for (std::size_t i = 0; i < runs.size(); i++)
+    runs[i] = static_cast<unsigned int>(i);
+  auto statistics = BethYw::calculateStatistics(runs.data(), result.seconds.data(), runs.size());
+
+  os << std::left << std::setw(32) << result.name << std::setw(30) << result.input << std::right
+     << std::fixed << std::setprecision(3)
+     << std::setw(10) << statistics.median * 1000
+     << std::setw(10) << statistics.standardDeviation * 1000
+     << std::setw(10) << (statistics.upperQuartile - statistics.lowerQuartile) * 1000
+     << std::setprecision(0)
+     << std::setw(14) << result.rows / statistics.median;
+  if (result.bytes > 0)
+    os << std::setprecision(1) << std::setw(10) << result.bytes / statistics.median / (1024 * 1024);
+  else
+    os << std::setw(10) << "-";
+  os << '\n';
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  unsigned int repetitions = argc > 1 ? std::stoul(argv[1]) : 10;
+  std::string dir = argc > 2 ? std::string(argv[2]) + "/" : "datasets/";
+  if (repetitions == 0)
+    throw std::invalid_argument("The number of repetitions must be at least 1");
+
+  std::vector<ParsedDataset> datasets;
+  datasets.push_back({BethYw::InputFiles::AREAS, readFile(dir + BethYw::InputFiles::AREAS.FILE), Areas()});
+  for (auto const& source : BethYw::InputFiles::DATASETS)
+    datasets.push_back({source, readFile(dir + source.FILE), Areas()});
+
+  std::cout << repetitions << " runs of each after one to warm up (times in ms)\n\n"
+            << std::left << std::setw(32) << "benchmark" << std::setw(30) << "input" << std::right
+            << std::setw(10) << "median" << std::setw(10) << "stddev" << std::setw(10) << "iqr"
+            << std::setw(14) << "rows/s" << std::setw(10) << "MB/s" << '\n';
+
+  //the parsers, on each file
+  std::size_t totalBytes = 0;
+  for (auto& dataset : datasets) {
+    dataset.data = parse(dataset);
+    totalBytes += dataset.contents.size();
+    std::size_t rows = dataset.source.PARSER == BethYw::AuthorityCodeCSV
+                       ? dataset.data.size()
+                       : countReadings(dataset.data);
+    report(std::cout, run(parserName(dataset.source.PARSER), dataset.source.FILE, rows,
+                          dataset.contents.size(), repetitions, [&]() {
+      sink = parse(dataset).size();
+    }));
+  }
+
+  //merging every dataset into one, area by area
+  Areas all = Areas();
+  for (auto const& dataset : datasets)
+    for (auto const& area : dataset.data.getAreas())
+      all.setArea(area.first, area.second);
+  std::size_t readings = countReadings(all);
+  report(std::cout, run("setArea/setMeasure merge", "all", readings, 0, repetitions, [&]() {
+    Areas merged = Areas();
+    for (auto const& dataset : datasets)
+      for (auto const& area : dataset.data.getAreas())
+        merged.setArea(area.first, area.second);
+    sink = merged.size();
+  }));
+
+  //the output, of everything merged
+  std::size_t jsonBytes = all.toJSON().size();
+  report(std::cout, run("Areas::toJSON", "all", readings, jsonBytes, repetitions, [&]() {
+    sink = all.toJSON().size();
+  }));
+
+  std::ostringstream table;
+  table << all;
+  std::size_t tableBytes = table.str().size();
+  report(std::cout, run("operator<<", "all", readings, tableBytes, repetitions, [&]() {
+    std::ostringstream os;
+    os << all;
+    sink = os.str().size();
+  }));
+
+  //the statistics of every measure
+  report(std::cout, run("Measure::getStatistics", "all", readings, 0, repetitions, [&]() {
+    std::size_t count = 0;
+    for (auto const& area : all.getAreas())
+      for (auto const& measure : area.second.getMeasures())
+        count += measure.second.getStatistics().count;
+    sink = count;
+  }));
+
+  std::cout << "\nparsed " << totalBytes << " bytes of " << datasets.size() << " files into "
+            << all.size() << " areas and " << readings << " readings\n";
+  return 0;
+}
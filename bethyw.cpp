@@ -15,18 +15,42 @@
   calling a series of helper functions.
 */
 
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #include "lib_cxxopts.hpp"
 
+#include "areaindex.h"
 #include "areas.h"
+#include "batch.h"
+#include "catalogue.h"
 #include "datasets.h"
 #include "bethyw.h"
 #include "input.h"
+#include "measureindex.h"
+#include "output.h"
+#include "parallel.h"
+#include "query.h"
+#include "repl.h"
+#include "resultcache.h"
+#include "server.h"
+#include "snapshot.h"
+#include "watch.h"
 
 /*
   Run Beth Yw?, parsing the command line arguments, importing the data,
@@ -57,6 +81,72 @@ int BethYw::run(int argc, char *argv[]) {
 
   // Parse data directory argument
   std::string dir = args["dir"].as<std::string>() + DIR_SEP;
+  std::string cacheDir = args.count("cache") ? args["cache"].as<std::string>() + DIR_SEP : "";
+
+  // Keep the datasets loaded and answer queries from a socket until killed
+  if (args.count("serve")) {
+    BethYw::Catalogue catalogue(dir, cacheDir);
+    catalogue.load(BethYw::parseDatasetsArg(args));
+    std::unique_ptr<BethYw::Watcher> watcher;
+    if (args.count("watch"))
+      watcher = std::make_unique<BethYw::Watcher>(catalogue, dir, std::cerr);
+    std::size_t budget = args["result-cache"].as<unsigned int>();
+    BethYw::ResultCache cache(budget * 1024 * 1024);
+    BethYw::serve(catalogue, args["serve"].as<std::string>(), 0, budget > 0 ? &cache : nullptr);
+    return 0;
+  }
+
+  // Import what a file of queries needs once, then answer them all from it
+  if (args.count("batch")) {
+    std::string path = args["batch"].as<std::string>();
+    std::ifstream file(path);
+    if (!file)
+      throw std::runtime_error("Failed to open batch file " + path);
+    BethYw::Catalogue catalogue(dir, cacheDir);
+    BethYw::runBatch(catalogue, BethYw::readBatch(file), std::cerr);
+    return 0;
+  }
+
+  // Keep the datasets loaded and take commands from the standard input
+  if (args.count("repl")) {
+    BethYw::Catalogue catalogue(dir, cacheDir);
+    std::unique_ptr<BethYw::Watcher> watcher;
+    if (args.count("watch"))
+      watcher = std::make_unique<BethYw::Watcher>(catalogue, dir, std::cerr);
+    BethYw::runRepl(catalogue, BethYw::parseSelection(args), std::cin, std::cout, &std::cerr);
+    return 0;
+  }
+
+  // Run a query, importing only what its plan says it needs
+  if (args.count("query")) {
+    BethYw::Query query(args["query"].as<std::string>());
+    Areas data = Areas();
+    if (!query.isExplain() && !query.isEmpty()) {
+      auto const& selection = query.getSelection();
+      if (query.needsNames())
+        BethYw::loadAreas(data, dir, selection.areasFilter);
+      BethYw::loadDatasets(data,
+                           dir,
+                           BethYw::findDatasets(selection.datasets),
+                           selection.areasFilter,
+                           selection.measuresFilter,
+                           selection.yearsFilter,
+                           cacheDir);
+    }
+
+    auto format = BethYw::QueryFormat::Table;
+    if (args.count("json"))
+      format = BethYw::QueryFormat::JSON;
+    else if (args.count("csv"))
+      format = BethYw::QueryFormat::CSV;
+    else if (args.count("tsv"))
+      format = BethYw::QueryFormat::TSV;
+
+    BethYw::OutputBuffer buffer(stdout);
+    std::ostream out(&buffer);
+    query.run(data, out, format);
+    return 0;
+  }
 
   // Parse other arguments and import data
 
@@ -66,6 +156,7 @@ int BethYw::run(int argc, char *argv[]) {
    auto yearsFilter      = BethYw::parseYearsArg(args);
 
   Areas data = Areas();
+  data.setSketching(args.count("sketch") > 0);
 
   BethYw::loadAreas(data, dir, areasFilter);
 
@@ -74,16 +165,115 @@ int BethYw::run(int argc, char *argv[]) {
                         datasetsToImport,
                         areasFilter,
                         measuresFilter,
-                        yearsFilter);
+                        yearsFilter,
+                        cacheDir);
+
+  // Arrow is binary, so stdout mustn't turn each '\n' byte into "\r\n"
+#ifdef _WIN32
+  if (args.count("arrow"))
+    ::_setmode(::_fileno(stdout), _O_BINARY);
+#endif
+
+  // Collect the output in one large buffer rather than many small writes
+  BethYw::OutputBuffer buffer(stdout);
+  std::ostream out(&buffer);
+  BethYw::writeOutput(data, args, out);
+  return 0;
+}
 
-  if (args.count("json")) {
-    // The output as JSON
-    std::cout << data.toJSON() << std::endl;
+/*
+  Write the imported data to a stream in the form asked for by the program
+  arguments: the derived measures and transforms are added first, then it is
+  written as sketches, a correlation matrix, a ranking, JSON, NDJSON, Arrow,
+  CSV/TSV or (by default) tables. This is the output half of run(), shared
+  with the --serve server, which writes to a socket instead of stdout.
+
+  @param data
+    The imported data (derived measures and transforms are added to it)
+
+  @param args
+    Parsed program arguments
+
+  @param out
+    The stream to write to
+
+  @throws
+    std::invalid_argument if an output argument is not valid
+
+  @example
+    auto args = cxxopts.parse(argc, argv);
+    Areas data = Areas();
+    ...
+    BethYw::writeOutput(data, args, std::cout);
+*/
+void BethYw::writeOutput(Areas& data, cxxopts::ParseResult& args, std::ostream& out) {
+  // Derived measures are only defined here, and calculated when output
+  if (args.count("derive"))
+    for (auto const& definition : args["derive"].as<std::vector<std::string>>())
+      data.defineMeasure(definition);
+
+  // Moving averages, year-over-year changes etc. of every measure
+  data.addTransforms(BethYw::parseTransformsArg(args));
+
+  if (args.count("stats"))
+    out << BethYw::withStatistics;
+
+  if (args.count("sketch")) {
+    // Approximate statistics of each measure, from the sketches
+    if (args.count("json")) {
+      BethYw::writeSketchJSON(out, data.getSketches());
+      out << std::endl;
+    } else {
+      BethYw::writeSketchTable(out, data.getSketches());
+    }
+  } else if (args.count("correlate")) {
+    // How every measure varies with every other, across areas and years
+    auto method = args["correlate"].as<std::string>();
+    if (!BethYw::insensitiveEquals(method, "pearson") && !BethYw::insensitiveEquals(method, "spearman"))
+      throw std::invalid_argument("Invalid input for correlate argument");
+    auto matrix = data.correlate(BethYw::insensitiveEquals(method, "spearman")
+                                     ? BethYw::CorrelationMethod::Spearman
+                                     : BethYw::CorrelationMethod::Pearson);
+    if (args.count("json")) {
+      BethYw::writeCorrelationJSON(out, matrix);
+      out << std::endl;
+    } else {
+      BethYw::writeCorrelationTable(out, matrix);
+    }
+  } else if (args.count("top") || args.count("bottom")) {
+    // Only the highest or lowest few Areas for one measure and year
+    bool highest = args.count("top") > 0;
+    auto n = args[highest ? "top" : "bottom"].as<unsigned int>();
+    if (!args.count("by") || !args.count("year"))
+      throw std::invalid_argument("Ranking needs both the --by and --year arguments");
+    auto codename = BethYw::convertToLower(args["by"].as<std::string>());
+    auto year = BethYw::validateYear(args["year"].as<std::string>());
+    BethYw::printRanking(out, data.rank(codename, year, n, highest), codename,
+                         year, highest, args.count("json") > 0);
+  } else if (args.count("json")) {
+    // The output as JSON, streamed without building a json object first
+    data.toJSON(out);
+    out << std::endl;
+  } else if (args.count("ndjson")) {
+    // The output as one JSON document per line
+    auto per = args["ndjson"].as<std::string>();
+    if (!BethYw::insensitiveEquals(per, "area") && !BethYw::insensitiveEquals(per, "measure"))
+      throw std::invalid_argument("Invalid input for ndjson argument");
+    data.toNDJSON(out, BethYw::insensitiveEquals(per, "measure"));
+  } else if (args.count("arrow")) {
+    // The output as an Arrow IPC stream of binary columns
+    data.toArrow(out);
+  } else if (args.count("csv") || args.count("tsv")) {
+    // The output as comma or tab separated values
+    char delimiter = args.count("csv") ? ',' : '\t';
+    if (args.count("wide"))
+      data.toWideCSV(out, delimiter);
+    else
+      data.toCSV(out, delimiter);
   } else {
     // The output as tables
-    std::cout << data << std::endl;
+    out << data;
   }
-  return 0;
 }
 
 /*
@@ -129,15 +319,156 @@ cxxopts::Options BethYw::cxxoptsSetup() {
       "inclusive range of years (YYYY-ZZZZ)",
       cxxopts::value<std::string>()->default_value("0"))(
 
+      "derive",
+      "Add a measure calculated from other measures, as codename=expression "
+      "using measure codenames, numbers, + - * / and brackets "
+      "(e.g. popden=pop/area).",
+      cxxopts::value<std::vector<std::string>>())(
+
+      "transform",
+      "Add derived series of every measure as a comma-separated list of: "
+      "ma (3-year moving average) or maN (N-year), yoy (change on the "
+      "previous year), yoypct (% change on the previous year), and cumsum "
+      "(cumulative sum).",
+      cxxopts::value<std::vector<std::string>>())(
+
+      "sketch",
+      "Print approximate statistics of each measure across all areas "
+      "(readings, distinct areas, min, quartiles, 99th percentile, max) from "
+      "sketches built while importing.")(
+
+      "correlate",
+      "Print the correlation of every measure with every other measure over "
+      "the areas and years they both have values for, using Pearson's "
+      "correlation or, with --correlate=spearman, Spearman's.",
+      cxxopts::value<std::string>()->implicit_value("pearson"))(
+
       "j,json",
       "Print the output as JSON instead of tables.")(
 
+      "stats",
+      "Include extra statistics (median, quartiles, standard deviation, "
+      "growth rate, trend, and the years of the lowest and highest values) "
+      "in the table and JSON output.")(
+
+      "csv",
+      "Print the output as comma-separated values, one row per value "
+      "(area,measure,year,value).")(
+
+      "tsv",
+      "Print the output as tab-separated values, one row per value "
+      "(area,measure,year,value).")(
+
+      "ndjson",
+      "Print the output as newline-delimited JSON, one line per area, or "
+      "one line per measure in each area with --ndjson=measure.",
+      cxxopts::value<std::string>()->implicit_value("area"))(
+
+      "arrow",
+      "Write the output as an Apache Arrow IPC stream instead of text.")(
+
+      "wide",
+      "With --csv or --tsv, print one row per area and measure with a "
+      "column for each year.")(
+
+      "top",
+      "Print only the N areas with the highest value of the --by measure in "
+      "the --year year.",
+      cxxopts::value<unsigned int>())(
+
+      "bottom",
+      "Print only the N areas with the lowest value of the --by measure in "
+      "the --year year.",
+      cxxopts::value<unsigned int>())(
+
+      "by",
+      "The measure codename to rank areas by with --top or --bottom.",
+      cxxopts::value<std::string>())(
+
+      "year",
+      "The year (YYYY) to rank areas in with --top or --bottom.",
+      cxxopts::value<std::string>())(
+
+      "serve",
+      "Load the datasets once and keep them in memory, answering queries sent "
+      "to a Unix domain socket at this path. Each query is one line of the "
+      "same arguments as the command line (e.g. -d popden -a W06000011 -j) "
+      "and gets the same output back.",
+      cxxopts::value<std::string>())(
+
+      "result-cache",
+      "With --serve, keep the answers already sent in up to this many MB of "
+      "memory, and send them again for the same query instead of working "
+      "them out again. 0 keeps nothing.",
+      cxxopts::value<unsigned int>()->default_value("64"))(
+
+      "batch",
+      "Run every query in this file against one import of the datasets. "
+      "Each line is the file to write the answer to, then the query (program "
+      "arguments, or a SELECT as with --query), e.g. \"swansea.json -d popden "
+      "-a W06000011 -j\".",
+      cxxopts::value<std::string>())(
+
+      "query",
+      "Run a query, e.g. \"SELECT area, value FROM popden WHERE year = 2015 "
+      "ORDER BY value DESC LIMIT 5\". Only the datasets, areas, measures and "
+      "years the query can match are imported. Start it with EXPLAIN to print "
+      "the plan instead. -j, --csv or --tsv set the format if it has no FORMAT.",
+      cxxopts::value<std::string>())(
+
+      "repl",
+      "Start an interactive shell that keeps the datasets loaded and takes "
+      "commands (filter, show, rank, stats, export; type help for more). "
+      "The datasets and filters given are where it starts.")(
+
+      "cache",
+      "Keep a binary snapshot of each dataset in this directory once it has "
+      "been parsed, and use it instead of parsing the file again while the "
+      "file is unchanged. What is in each dataset, and where each area's "
+      "records are, is kept there too, so that with -a, -m or -y only the "
+      "datasets (and with -a, the records) that can match are read.",
+      cxxopts::value<std::string>())(
+
+      "watch",
+      "With --serve or --repl, import a dataset again as soon as its file in "
+      "--dir changes, without restarting. Other datasets are not imported "
+      "again. Linux only.")(
+
       "h,help",
       "Print usage.");
 
   return cxxopts;
 }
 
+/*
+  Parse a list of arguments that didn't come from the command line (e.g. a
+  query sent to --serve, or a command typed into --repl) in the same way as
+  the program arguments.
+
+  @param arguments
+    The arguments, without the program name
+
+  @return
+    The parsed arguments
+
+  @throws
+    cxxopts::OptionException if an argument is not valid
+
+  @example
+    auto args = BethYw::parseArguments({"-d", "popden", "-j"});
+*/
+cxxopts::ParseResult BethYw::parseArguments(std::vector<std::string> arguments) {
+  arguments.insert(arguments.begin(), "bethyw");
+  std::vector<char*> argv;
+  for (auto& argument : arguments)
+    argv.push_back(&argument[0]);
+  int argc = argv.size();
+  char** argvData = argv.data();
+
+  auto cxxopts = BethYw::cxxoptsSetup();
+  return cxxopts.parse(argc, argvData);
+}
+
 /*
  *
 
@@ -173,52 +504,62 @@ cxxopts::Options BethYw::cxxoptsSetup() {
 
 std::vector<BethYw::InputFileSource> BethYw::parseDatasetsArg(
     cxxopts::ParseResult& args) {
-  // This function is incomplete, but to get you started...
-  // You may want to delete much of these // comments too!
+  if(args.count("datasets") == 0)
+      return BethYw::findDatasets({"all"});
+
+  try{
+      return BethYw::findDatasets(args["datasets"].as<std::vector<std::string>>());
+  }catch(const std::invalid_argument& error){
+      std::cerr << error.what();
+      exit(0);
+  }
+}
 
-  // Retrieve all valid datasets, see datasets.h
-  size_t numDatasets = InputFiles::NUM_DATASETS;
-  auto &allDatasets = InputFiles::DATASETS;
+/*
+  Look up datasets by their codes in the DATASETS array in the InputFiles
+  namespace in datasets.h, in the order given. The code "all" (any case)
+  selects every dataset. This is parseDatasetsArg() without the program
+  arguments or the exit, for places that must carry on after a bad code
+  (e.g. a request to a --serve server).
 
-  // Create the container for the return type
-  std::vector<InputFileSource> datasetsToImport;
+  @param codes
+    The dataset codes
 
-  // You can get the std::vector of arguments from cxxopts like this.
-  // Note that this function will throw an exception if datasets is not set as 
-  // an argument. Check the documentation! Read it and understand it.
-  if(args.count("datasets") == 0){
-      for(unsigned int i = 0; i < numDatasets; i++){
-          datasetsToImport.push_back(allDatasets[i]);
-      }
-      return datasetsToImport;
-  }
-  auto inputDatasets = args["datasets"].as<std::vector<std::string>>();
-  for(auto input = inputDatasets.begin(); input != inputDatasets.end(); input++) {
+  @return
+    A std::vector of BethYw::InputFileSource instances to import
+
+  @throws
+    std::invalid_argument if a code doesn't match a dataset, with the message:
+    No dataset matches key: <input code>
 
-      std::string &inputString = *input;
+  @example
+    auto datasets = BethYw::findDatasets({"popden", "trains"});
+*/
+std::vector<BethYw::InputFileSource> BethYw::findDatasets(
+    const std::vector<std::string>& codes) {
+  size_t numDatasets = InputFiles::NUM_DATASETS;
+  auto &allDatasets = InputFiles::DATASETS;
 
-      if(BethYw::insensitiveEquals(inputString, "all")) {
+  std::vector<InputFileSource> datasetsToImport;
+  for(auto const& code : codes) {
+      if(BethYw::insensitiveEquals(code, "all")) {
           datasetsToImport.clear();
-          for(unsigned int i = 0; i < numDatasets; i++){
+          for(unsigned int i = 0; i < numDatasets; i++)
               datasetsToImport.push_back(allDatasets[i]);
-          }
           return datasetsToImport;
       }
+
       bool found = false;
-      for (unsigned int x = 0; x < numDatasets; x++) {
-          if (inputString == allDatasets[x].CODE) {
+      for(unsigned int x = 0; x < numDatasets; x++) {
+          if(code == allDatasets[x].CODE) {
               datasetsToImport.push_back(allDatasets[x]);
               found = true;
           }
       }
-
-      if(!found) {
-          std::cerr << "No dataset matches key: " << inputString;
-          exit(0);
-      }
-
-    }
-    return datasetsToImport;
+      if(!found)
+          throw std::invalid_argument("No dataset matches key: " + code);
+  }
+  return datasetsToImport;
 }
 
 /*
@@ -297,7 +638,7 @@ std::unordered_set<std::string> BethYw::parseMeasuresArg(cxxopts::ParseResult& a
 
     for(unsigned int i = 0; i < measuresArgs.size(); i++) {
         if(!BethYw::insensitiveEquals(measuresArgs[i], "all")){
-            measures.insert(measuresArgs[i]);
+            measures.insert(BethYw::convertToLower(measuresArgs[i]));
         }else{
             measures.clear();
         }
@@ -307,6 +648,96 @@ std::unordered_set<std::string> BethYw::parseMeasuresArg(cxxopts::ParseResult& a
 
 }
 
+/*
+  Parse the transform command line argument, which is optional. Each value
+  adds one derived series of every measure: "ma" for a 3-year moving average
+  (or "ma" followed by a number of years, e.g. "ma5"), "yoy" for the change on
+  the previous year, "yoypct" for the % change on the previous year, and
+  "cumsum" for the cumulative sum. Values are case insensitive.
+
+  @param args
+    Parsed program arguments
+
+  @return
+    The transforms to apply, with none set if the argument isn't given
+
+  @throws
+    std::invalid_argument if the argument contains an invalid transform with
+    the message: Invalid input for transform argument
+
+  @example
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args = cxxopts.parse(argc, argv);
+
+    auto transforms = BethYw::parseTransformsArg(args);
+*/
+BethYw::Transforms BethYw::parseTransformsArg(cxxopts::ParseResult& args){
+    BethYw::Transforms transforms;
+    if(args.count("transform") == 0)
+        return transforms;
+
+    for(auto const& arg : args["transform"].as<std::vector<std::string>>()){
+        std::string transform = BethYw::convertToLower(arg);
+        if(transform == "yoy"){
+            transforms.change = true;
+        }else if(transform == "yoypct"){
+            transforms.percentChange = true;
+        }else if(transform == "cumsum"){
+            transforms.cumulativeSum = true;
+        }else if(transform.compare(0, 2, "ma") == 0){
+            std::string window = transform.substr(2);
+            if(window.size() > 2 || !std::all_of(window.begin(), window.end(), ::isdigit)
+               || (!window.empty() && std::stoi(window) == 0))
+                throw std::invalid_argument("Invalid input for transform argument");
+            transforms.movingAverage = true;
+            transforms.window = window.empty() ? 3 : std::stoi(window);
+        }else{
+            throw std::invalid_argument("Invalid input for transform argument");
+        }
+    }
+    return transforms;
+}
+
+/*
+  Parse the datasets, areas, measures and years arguments into a Selection,
+  for the modes that answer queries from a Catalogue. Any of the four that
+  isn't given is copied from base instead (by default: everything), so a
+  Selection can be changed one argument at a time. Unlike parseDatasetsArg(),
+  a bad dataset code throws rather than exiting.
+
+  @param args
+    Parsed arguments
+
+  @param base
+    The Selection to take any arguments that weren't given from
+
+  @return
+    The Selection
+
+  @throws
+    std::invalid_argument if a dataset code, or the years, are not valid
+
+  @example
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args = cxxopts.parse(argc, argv);
+
+    auto selection = BethYw::parseSelection(args);
+*/
+BethYw::Selection BethYw::parseSelection(cxxopts::ParseResult& args, const Selection& base){
+    BethYw::Selection selection = base;
+    if(args.count("datasets")){
+        selection.datasets = args["datasets"].as<std::vector<std::string>>();
+        BethYw::findDatasets(selection.datasets);
+    }
+    if(args.count("areas"))
+        selection.areasFilter = BethYw::parseAreasArg(args);
+    if(args.count("measures"))
+        selection.measuresFilter = BethYw::parseMeasuresArg(args);
+    if(args.count("years"))
+        selection.yearsFilter = BethYw::parseYearsArg(args);
+    return selection;
+}
+
 /*
  *TODO::
   Parse the years command line argument. Years is either a four digit year 
@@ -407,6 +838,11 @@ void BethYw::loadAreas(Areas &areas, std::string dir, std::unordered_set<std::st
   The actual filtering will be done by the Areas::populate() function, thus 
   you need to merely pass pointers on to these flters.
 
+  The datasets are imported at the same time on a pool of threads, each into
+  its own Areas object, which are then merged into `areas` in the order of
+  `datasetsToImport` (see Areas::merge()), so the result is the same as
+  importing them one after the other.
+
   This function should promise not to throw an exception. If there is an
   error/exception thrown in any function called by thus function, catch it and
   output 'Error importing dataset:', followed by a new line and then the output
@@ -427,11 +863,19 @@ void BethYw::loadAreas(Areas &areas, std::string dir, std::unordered_set<std::st
 
   @param measuresFilter
     An unordered set of measures (as measure codes encoded in std::strings)
-    to filter, or empty to import all measures
+    to filter, or empty to import all measures. Datasets with none of these
+    measures (see measureindex.h) are not opened at all
 
   @param yearsFilter
     An two-pair tuple of unsigned ints corresponding to the range of years 
-    to import, which should both be 0 to import all years.
+    to import, which should both be 0 to import all years. As with the
+    measures, datasets with no readings for these areas and years are not
+    opened at all
+
+  @param cacheDir
+    The directory to keep binary snapshots of the datasets, their manifests
+    and area indexes in (see snapshot.h, measureindex.h and areaindex.h),
+    ending in DIR_SEP, or empty to always parse the files
 
   @return
     void
@@ -452,19 +896,119 @@ void BethYw::loadDatasets(Areas &areas,
                         std::vector<InputFileSource>  datasetsToImport,
                           const StringFilterSet areasFilter,
                           const StringFilterSet measuresFilter,
-                          const YearFilterTuple yearsFilter){
+                          const YearFilterTuple yearsFilter,
+                          const std::string& cacheDir){
+
+        //datasets that can't have a reading left after the filters aren't
+        //opened at all
+        datasetsToImport = BethYw::datasetsMatching(dir, datasetsToImport, areasFilter,
+                                                    measuresFilter, yearsFilter, cacheDir);
+
+        //each dataset is imported into its own Areas on the thread pool
+        std::vector<Areas> imported(datasetsToImport.size());
+        std::vector<std::exception_ptr> errors(datasetsToImport.size());
+        BethYw::parallelFor(datasetsToImport.size(), [&](std::size_t i) {
+            auto const& dataset = datasetsToImport[i];
+            try{
+                std::string records;
+                if(BethYw::readAreaRecords(dir, dataset, areasFilter, cacheDir, records)){
+                    //only the records of the areas wanted, found by the area index
+                    std::istringstream recordsStream(records);
+                    imported[i].populate(recordsStream, dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+                    return;
+                }
+                if(!cacheDir.empty()){
+                    //the whole dataset from its snapshot, then filtered
+                    imported[i] = BethYw::importDataset(dir, dataset, cacheDir)
+                                      .select(&areasFilter, &measuresFilter, &yearsFilter);
+                    return;
+                }
+                InputFile datasetFile(dir + dataset.FILE);
+                imported[i].populate(datasetFile.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+            }catch(...){
+                errors[i] = std::current_exception();
+            }
+        });
 
-        for(auto const& dataset : datasetsToImport) {
-            InputFile areasFile(dir + dataset.FILE);
+        //then merged in order, so later datasets still take precedence and
+        //the first dataset to fail is the one reported
+        for(std::size_t i = 0; i < datasetsToImport.size(); i++) {
             try{
-                areas.populate(areasFile.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+                if(errors[i])
+                    std::rethrow_exception(errors[i]);
             }catch(const std::runtime_error & error) {
                 std::cerr << "Error importing dataset: " << std::endl << error.what();
                 exit(0);
             }
+            areas.merge(std::move(imported[i]), datasetsToImport[i].PARSER);
         }
 }
 
+/*
+  Print a ranking of Areas, either as a table with one numbered line per Area
+  or, for JSON, as an array of objects with the local authority code and the
+  value. Nothing is printed but the heading (or an empty array) when no Area
+  has a value for the year.
+
+  @param os
+    The stream to print to
+
+  @param ranking
+    The ranking, as returned by Areas::rank()
+
+  @param codename
+    The codename of the Measure the Areas were ranked by
+
+  @param year
+    The year the Areas were ranked in
+
+  @param highest
+    Whether the ranking is of the highest values (true) or the lowest (false)
+
+  @param json
+    Print JSON instead of a table
+
+  @example
+    auto top = data.rank("dens", 2019, 5);
+    BethYw::printRanking(std::cout, top, "dens", 2019, true, false);
+*/
+void BethYw::printRanking(std::ostream& os,
+                          const Ranking& ranking,
+                          const std::string& codename,
+                          unsigned int year,
+                          bool highest,
+                          bool json){
+    if(json){
+        os.put('[');
+        for(auto place = ranking.begin(); place != ranking.end(); place++){
+            if(place != ranking.begin())
+                os.put(',');
+            os.write("{\"area\":", 8);
+            BethYw::writeJSONString(os, place->area->getLocalAuthorityCode());
+            os.write(",\"value\":", 9);
+            BethYw::writeJSONNumber(os, place->value);
+            os.put('}');
+        }
+        os << "]" << std::endl;
+        return;
+    }
+
+    std::string label = codename;
+    if(!ranking.empty())
+        label = ranking.front().area->getMeasures().at(codename).getLabel() + " (" + codename + ")";
+    os << label << ", " << (highest ? "highest" : "lowest") << " in " << year << '\n';
+
+    char buffer[BethYw::FIXED_BUFFER_SIZE];
+    unsigned int place = 1;
+    for(auto const& entry : ranking){
+        char* end = BethYw::formatFixed(buffer, entry.value);
+        os << place++ << ". " << entry.area->getDisplayName()
+           << " (" << entry.area->getLocalAuthorityCode() << ") ";
+        os.write(buffer, end - buffer);
+        os.put('\n');
+    }
+}
+
 /*
  * Compares two string cap insensitively.
 
@@ -18,6 +18,7 @@
 #include "lib_cxxopts.hpp"
 #include "datasets.h"
 #include "areas.h"
+#include "catalogue.h"
 
 const char DIR_SEP =
 #ifdef _WIN32
@@ -35,6 +36,16 @@ const std::string STUDENT_NUMBER = "976789";
 */
 int run(int argc, char *argv[]);
 
+/*
+  Parse a list of arguments (without the program name) with cxxoptsSetup().
+*/
+cxxopts::ParseResult parseArguments(std::vector<std::string> arguments);
+
+/*
+  Write the imported data in the form asked for by the program arguments.
+*/
+void writeOutput(Areas& data, cxxopts::ParseResult& args, std::ostream& out);
+
 /*
   Create a cxxopts instance.
 */
@@ -47,6 +58,12 @@ cxxopts::Options cxxoptsSetup();
 std::vector<BethYw::InputFileSource> parseDatasetsArg(
   cxxopts::ParseResult& args);
 
+/*
+  Look up datasets by code, throwing rather than exiting on a bad code.
+*/
+std::vector<BethYw::InputFileSource> findDatasets(
+  const std::vector<std::string>& codes);
+
 /*
   Parse the areas argument and return a std::unordered_set of all the
   areas to import, or an empty set if all areas should be imported.
@@ -57,6 +74,15 @@ std::unordered_set<std::string> parseMeasuresArg(cxxopts::ParseResult& args);
 
 std::tuple<unsigned int, unsigned int> parseYearsArg(cxxopts::ParseResult& args);
 
+BethYw::Transforms parseTransformsArg(cxxopts::ParseResult& args);
+
+/*
+  Parse the datasets, areas, measures and years arguments into a Selection,
+  throwing rather than exiting on a bad dataset code. Arguments that weren't
+  given are taken from base.
+*/
+Selection parseSelection(cxxopts::ParseResult& args, const Selection& base = Selection());
+
 void loadAreas(Areas &areas, std::string dir, std::unordered_set<std::string> areasFilter);
 
 unsigned int validateYear(std::string yearSting);
@@ -71,8 +97,18 @@ void loadDatasets(Areas &areas,
                               std::vector<InputFileSource>  datasetsToImport,
                               const StringFilterSet areasFilter,
                               const StringFilterSet  measuresFilter,
-                              const YearFilterTuple  yearsFilter) noexcept(false);
+                              const YearFilterTuple  yearsFilter,
+                              const std::string& cacheDir = "") noexcept(false);
 
+/*
+  Print the Areas ranked by Areas::rank(), as a table or as JSON.
+*/
+void printRanking(std::ostream& os,
+                  const Ranking& ranking,
+                  const std::string& codename,
+                  unsigned int year,
+                  bool highest,
+                  bool json);
 
 std::string getVariableCSV(std::string& line);
 } // namespace BethYw
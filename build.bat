@@ -2,9 +2,12 @@
 
 SET bin_dir=bin
 SET tests_dir=tests
-SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp
+SET bench_dir=bench
+SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp output.cpp arrow.cpp statistics.cpp expression.cpp correlation.cpp sketch.cpp parallel.cpp catalogue.cpp server.cpp repl.cpp query.cpp batch.cpp watch.cpp measureindex.cpp snapshot.cpp resultcache.cpp areaindex.cpp fileutil.cpp
 SET main_file=main.cpp
 SET executable=%bin_dir%\bethyw.exe
+SET libs=-pthread
+SET optimise=
 
 COPY bin\bethyw2.exe bin\bethyw.exe
 
@@ -21,10 +24,15 @@ IF %testStr%==test (
      g++ --std=c++11 -c lib_catch_main.cpp -o %bin_dir%\catch.o
   )
 )
+IF "%1"=="bench" (
+  SET main_file=%bench_dir%\bench.cpp
+  SET executable=%bin_dir%\bethyw-bench.exe
+  SET optimise=-O2
+)
 
 :compile
 IF NOT EXIST %bin_dir% MKDIR %bin_dir%
 IF EXIST %executable% DEL %executable%
-g++ --std=c++14 -Wall %source_files% %main_file% -o %executable%
+g++ --std=c++14 -Wall %optimise% %source_files% %main_file% %libs% -o %executable%
 
 :end
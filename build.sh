@@ -2,15 +2,18 @@
 
 BIN_DIR="bin"
 TESTS_DIR="tests"
-SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp"
+BENCH_DIR="bench"
+SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp output.cpp arrow.cpp statistics.cpp expression.cpp correlation.cpp sketch.cpp parallel.cpp catalogue.cpp server.cpp repl.cpp query.cpp batch.cpp watch.cpp measureindex.cpp snapshot.cpp resultcache.cpp areaindex.cpp fileutil.cpp"
 MAIN_FILE="main.cpp"
 EXECUTABLE="./${BIN_DIR}/bethyw"
+LIBS="-pthread"
+OPTIMISE=""
 
 set -x
 cd "${0%/*}"
 
 if [ $# -gt 1 ]; then
-  echo "Unknown arguments!" "Only one argument accepted, and must begin with test"
+  echo "Unknown arguments!" "Only one argument accepted, and must begin with test or be bench"
   exit
 elif [ $# -eq 1 ]; then
   if [[ $1 == test* ]]; then
@@ -22,9 +25,14 @@ elif [ $# -eq 1 ]; then
     if [ ! -f ./${BIN_DIR}/catch.o ]; then
       g++ --std=c++11 -c ./lib_catch_main.cpp -o ./${BIN_DIR}/catch.o
     fi
+  elif [[ $1 == bench ]]; then
+    # Benchmarks are only worth running with the optimiser on
+    MAIN_FILE="./${BENCH_DIR}/bench.cpp"
+    EXECUTABLE="./${BIN_DIR}/bethyw-bench"
+    OPTIMISE="-O2"
   fi
 fi
 
 mkdir -p ${BIN_DIR}
 rm ${EXECUTABLE} 2> /dev/null
-g++ --std=c++14 -pedantic -Wall ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
+g++ --std=c++14 -pedantic -Wall ${OPTIMISE} ${SOURCE_FILES} ${MAIN_FILE} ${LIBS} -o ${EXECUTABLE}
\ No newline at end of file
@@ -0,0 +1,305 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the Catalogue. See the header file
+  for additional comments.
+ */
+
+#include <exception>
+#include <utility>
+
+#include "bethyw.h"
+#include "catalogue.h"
+#include "input.h"
+#include "measureindex.h"
+#include "parallel.h"
+#include "snapshot.h"
+
+/*
+  Construct an empty Catalogue, which imports from the given directory.
+
+  @param dir
+    The directory the datasets are in, ending in DIR_SEP
+
+  @param cacheDir
+    The directory to keep snapshots of the datasets in (see snapshot.h),
+    ending in DIR_SEP, or empty to always parse the files
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+*/
+BethYw::Catalogue::Catalogue(const std::string& dir, const std::string& cacheDir)
+    : dir(dir), cacheDir(cacheDir) {}
+
+/*
+  Check whether a dataset has been imported yet.
+
+  @param code
+    The dataset's code, e.g. popden
+
+  @return
+    true if the dataset is in memory
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    catalogue.load(BethYw::findDatasets({"popden"}));
+    catalogue.isLoaded("popden"); // returns true
+*/
+bool BethYw::Catalogue::isLoaded(const std::string& code) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return datasets.find(code) != datasets.end();
+}
+
+/*
+  Get the generation of the data in memory, which goes up by one every time
+  a file is imported again by reload(). Anything worked out from the data
+  while the generation was the same is still right.
+
+  @return
+    The generation, starting at 0
+
+  @example
+    auto before = catalogue.getGeneration();
+    catalogue.reload("popu1009.json");
+    catalogue.getGeneration(); // returns before + 1
+*/
+std::uint64_t BethYw::Catalogue::getGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation;
+}
+
+/*
+  Import the datasets that aren't in memory yet (and areas.csv, the first
+  time), at the same time on the thread pool and with no filters. Datasets
+  already imported are left as they are, so this is cheap to call before
+  every query.
+
+  @param datasetsToLoad
+    The datasets that must be in memory
+
+  @throws
+    std::runtime_error (or whatever the parser threw) for the first dataset,
+    in the order given, that couldn't be imported; the others are kept
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    catalogue.load(BethYw::findDatasets({"all"}));
+*/
+void BethYw::Catalogue::load(const std::vector<InputFileSource>& datasetsToLoad) {
+    std::vector<const InputFileSource*> missing;
+    bool namesMissing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        namesMissing = names == nullptr;
+        for (auto const& dataset : datasetsToLoad)
+            if (datasets.find(dataset.CODE) == datasets.end())
+                missing.push_back(&dataset);
+    }
+
+    if (namesMissing) {
+        auto imported = importSource(InputFiles::AREAS);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (names == nullptr)
+            names = std::move(imported);
+    }
+
+    std::vector<std::shared_ptr<const Areas>> imported(missing.size());
+    std::vector<std::exception_ptr> errors(missing.size());
+    BethYw::parallelFor(missing.size(), [&](std::size_t i) {
+        try {
+            imported[i] = importSource(*missing[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = 0; i < missing.size(); i++) {
+            if (errors[i]) {
+                if (!error)
+                    error = errors[i];
+                continue;
+            }
+            datasets.emplace(missing[i]->CODE, std::move(imported[i]));
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/*
+  Import the file of a dataset again after it has changed, and swap the new
+  copy in for the old one. Queries already running keep reading the copy
+  they started with (they hold their own pointer to it), and queries after
+  this read the new one. Other datasets are left alone. A file that isn't
+  in memory (or isn't a dataset at all) is ignored, since it will be
+  imported fresh when something needs it.
+
+  @param file
+    The name of the file in the datasets directory, e.g. popu1009.json or
+    areas.csv
+
+  @return
+    true if a dataset (or the names in areas.csv) was imported again
+
+  @throws
+    std::runtime_error (or whatever the parser threw) if the file couldn't be
+    imported, in which case the old copy is kept
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    catalogue.load(BethYw::findDatasets({"popden"}));
+    ...
+    catalogue.reload("popu1009.json"); // returns true
+*/
+bool BethYw::Catalogue::reload(const std::string& file) {
+    if (file == InputFiles::AREAS.FILE) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (names == nullptr)
+                return false;
+        }
+        auto imported = importSource(InputFiles::AREAS);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        names = std::move(imported);
+        generation++;
+        return true;
+    }
+
+    for (auto const& dataset : InputFiles::DATASETS) {
+        if (dataset.FILE != file)
+            continue;
+        if (!isLoaded(dataset.CODE))
+            return false;
+        auto imported = importSource(dataset);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        datasets[dataset.CODE] = std::move(imported);
+        generation++;
+        return true;
+    }
+    return false;
+}
+
+/*
+  Import the whole of one file, with nothing filtered out so that any query
+  can be answered from it later.
+*/
+std::shared_ptr<const Areas> BethYw::Catalogue::importSource(const InputFileSource& source) const {
+    if (!cacheDir.empty() && source.PARSER != BethYw::SourceDataType::AuthorityCodeCSV)
+        return std::make_shared<Areas>(BethYw::importDataset(dir, source, cacheDir));
+
+    auto imported = std::make_shared<Areas>();
+    InputFile sourceFile(dir + source.FILE);
+    if (source.PARSER == BethYw::SourceDataType::AuthorityCodeCSV) {
+        imported->populateFromAuthorityCodeCSV(sourceFile.open(), source.COLS);
+        return imported;
+    }
+
+    const StringFilterSet all;
+    const YearFilterTuple allYears(0, 0);
+    imported->populate(sourceFile.open(), source.PARSER, source.COLS, &all, &all, &allYears);
+    return imported;
+}
+
+/*
+  Build the Areas a run of the program with these datasets and filters would
+  have imported, from the copies in memory: the areas.csv names and then each
+  dataset in order, filtered by Areas::select() and merged by Areas::merge().
+  The datasets must have been loaded already. Any number of threads can call
+  this at the same time.
+
+  @param datasetsToSelect
+    The datasets to include, in the order to merge them
+
+  @param areasFilter
+    The local authority codes of the Areas to include, or empty for all
+
+  @param measuresFilter
+    The (lowercase) codenames of the Measures to include, or empty for all
+
+  @param yearsFilter
+    The first and last year to include, or 0, 0 for all
+
+  @param sketching
+    Whether to sketch the readings selected (see Areas::setSketching())
+
+  @return
+    A new Areas object with the data
+
+  @throws
+    std::out_of_range if one of the datasets hasn't been loaded
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    auto datasets = BethYw::findDatasets({"popden"});
+    catalogue.load(datasets);
+    Areas data = catalogue.select(datasets, {"W06000011"}, {}, std::make_tuple(0, 0));
+*/
+Areas BethYw::Catalogue::select(const std::vector<InputFileSource>& datasetsToSelect,
+                                const StringFilterSet& areasFilter,
+                                const StringFilterSet& measuresFilter,
+                                const YearFilterTuple& yearsFilter,
+                                bool sketching) const {
+    std::shared_ptr<const Areas> selectedNames;
+    std::vector<std::shared_ptr<const Areas>> selected;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        selectedNames = names;
+        for (auto const& dataset : datasetsToSelect) {
+            auto found = datasets.find(dataset.CODE);
+            if (found == datasets.end() || names == nullptr)
+                throw std::out_of_range("Catalogue::select: Dataset not loaded: " + dataset.CODE);
+            selected.push_back(found->second);
+        }
+    }
+
+    Areas data = Areas();
+    data.setSketching(sketching);
+    if (selectedNames != nullptr)
+        data.merge(selectedNames->select(&areasFilter, nullptr, nullptr), InputFiles::AREAS.PARSER);
+    for (std::size_t i = 0; i < selected.size(); i++)
+        data.merge(selected[i]->select(&areasFilter, &measuresFilter, &yearsFilter), datasetsToSelect[i].PARSER);
+    return data;
+}
+
+/*
+  Answer a Selection: import any of its datasets that aren't in memory yet and
+  then select() its data. As with loadDatasets(), datasets that can't have a
+  reading left after the filters (see datasetsMatching()) are left out.
+
+  @param selection
+    The datasets and filters
+
+  @param sketching
+    Whether to sketch the readings selected (see Areas::setSketching())
+
+  @return
+    A new Areas object with the data
+
+  @throws
+    std::invalid_argument if a dataset code is not valid, or whatever load()
+    throws if a dataset couldn't be imported
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::Selection selection;
+    selection.datasets = {"popden"};
+    Areas data = catalogue.query(selection);
+*/
+Areas BethYw::Catalogue::query(const Selection& selection, bool sketching) {
+    auto datasetsToSelect = BethYw::datasetsMatching(dir, BethYw::findDatasets(selection.datasets),
+                                                     selection.areasFilter, selection.measuresFilter,
+                                                     selection.yearsFilter, cacheDir);
+    load(datasetsToSelect);
+    return select(datasetsToSelect, selection.areasFilter, selection.measuresFilter,
+                  selection.yearsFilter, sketching);
+}
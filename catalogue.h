@@ -0,0 +1,90 @@
+#ifndef CATALOGUE_H_
+#define CATALOGUE_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declaration of the Catalogue: every dataset imported
+  so far, each kept in memory in its own Areas object with nothing filtered
+  out, so that any number of queries with different filters can be answered
+  without importing the files again.
+
+  Each query gets its own Areas built from copies of the data it asks for
+  (see Areas::select()), merged in the same way and order as loadDatasets()
+  merges them, so the answer is the same as running the program with those
+  arguments.
+ */
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+#include "datasets.h"
+
+namespace BethYw {
+
+/*
+  What a query selects: the datasets (by code, in the order to merge them,
+  or "all") and the same area, measure and year filters as the command line.
+*/
+struct Selection {
+  std::vector<std::string> datasets = {"all"};
+  StringFilterSet areasFilter;
+  StringFilterSet measuresFilter;
+  YearFilterTuple yearsFilter = YearFilterTuple(0, 0);
+};
+
+class Catalogue {
+private:
+  // the directory the datasets are imported from, ending in DIR_SEP
+  std::string dir;
+
+  // the directory of dataset snapshots (see snapshot.h), or empty for none
+  std::string cacheDir;
+
+  // the areas.csv names, or null until the first dataset is loaded
+  std::shared_ptr<const Areas> names;
+
+  // Key = dataset code | Value = everything imported from that dataset
+  std::map<std::string, std::shared_ptr<const Areas>> datasets;
+
+  // how many times a file has been imported again (see reload()), so answers
+  // kept from before can be told apart
+  std::uint64_t generation = 0;
+
+  // guards names, datasets and generation; queries only hold it to copy the
+  // pointers
+  mutable std::mutex mutex;
+
+  std::shared_ptr<const Areas> importSource(const InputFileSource& source) const noexcept(false);
+
+public:
+  /*----Constructor----*/
+  explicit Catalogue(const std::string& dir, const std::string& cacheDir = "");
+
+  /*----Getters----*/
+  bool isLoaded(const std::string& code) const;
+  std::uint64_t getGeneration() const;
+
+  /*----Miscellaneous----*/
+  void load(const std::vector<InputFileSource>& datasetsToLoad) noexcept(false);
+  bool reload(const std::string& file) noexcept(false);
+  Areas select(const std::vector<InputFileSource>& datasetsToSelect,
+               const StringFilterSet& areasFilter,
+               const StringFilterSet& measuresFilter,
+               const YearFilterTuple& yearsFilter,
+               bool sketching = false) const;
+  Areas query(const Selection& selection, bool sketching = false) noexcept(false);
+};
+
+} // namespace BethYw
+
+#endif // CATALOGUE_H_
@@ -0,0 +1,313 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the correlation matrix. See the
+  header file for additional comments.
+
+  Every column is centred on its own mean before the pairs are compared, so
+  the one pass sums of squares and products for each pair don't lose their
+  precision to large values (e.g. populations) cancelling each other out.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "correlation.h"
+#include "output.h"
+#include "parallel.h"
+
+namespace {
+
+// columns per block; 8 columns of a few thousand rows fit in the L2 cache
+const std::size_t BLOCK = 8;
+
+const double MISSING = std::numeric_limits<double>::quiet_NaN();
+
+/*
+  Pearson's correlation of the rows of two centred columns where both have a
+  value, from one pass of sums.
+*/
+double pearson(const double* x, const double* y, std::size_t rows, std::size_t& n) {
+    double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+    n = 0;
+    for (std::size_t row = 0; row < rows; row++) {
+        if (std::isnan(x[row]) || std::isnan(y[row]))
+            continue;
+        n++;
+        sx += x[row];
+        sy += y[row];
+        sxx += x[row] * x[row];
+        syy += y[row] * y[row];
+        sxy += x[row] * y[row];
+    }
+    if (n < 2)
+        return MISSING;
+
+    double vx = sxx - sx * sx / n;
+    double vy = syy - sy * sy / n;
+    if (vx <= 0 || vy <= 0)
+        return MISSING;
+
+    double r = (sxy - sx * sy / n) / std::sqrt(vx * vy);
+    return std::max(-1.0, std::min(1.0, r));
+}
+
+/*
+  Replace values with their rank (from 1), giving tied values the average of
+  their ranks.
+*/
+void rank(std::vector<double>& values, std::vector<std::size_t>& order) {
+    order.resize(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&values](std::size_t a, std::size_t b) {
+        return values[a] < values[b];
+    });
+
+    std::size_t i = 0;
+    while (i < order.size()) {
+        std::size_t j = i + 1;
+        while (j < order.size() && values[order[j]] == values[order[i]])
+            j++;
+        double average = (i + j + 1) / 2.0;
+        for (std::size_t k = i; k < j; k++)
+            values[order[k]] = average;
+        i = j;
+    }
+}
+
+/*
+  Spearman's correlation: Pearson's correlation of the ranks of the rows both
+  columns have a value in, ranked among just those rows.
+*/
+double spearman(const double* x, const double* y, std::size_t rows, std::size_t& n) {
+    static thread_local std::vector<double> xs, ys;
+    static thread_local std::vector<std::size_t> order;
+    xs.clear();
+    ys.clear();
+    for (std::size_t row = 0; row < rows; row++) {
+        if (!std::isnan(x[row]) && !std::isnan(y[row])) {
+            xs.push_back(x[row]);
+            ys.push_back(y[row]);
+        }
+    }
+    rank(xs, order);
+    rank(ys, order);
+    return pearson(xs.data(), ys.data(), xs.size(), n);
+}
+
+/*
+  Write an object of objects, with a key for each measure at both levels and
+  the values written by writeValue(row, column).
+*/
+template <typename WriteValue>
+void writeJSONMatrix(std::ostream& os, const BethYw::CorrelationMatrix& matrix, WriteValue writeValue) {
+    const std::size_t size = matrix.measures.size();
+    os.put('{');
+    for (std::size_t row = 0; row < size; row++) {
+        if (row > 0)
+            os.put(',');
+        BethYw::writeJSONString(os, matrix.measures[row]);
+        os.write(":{", 2);
+        for (std::size_t column = 0; column < size; column++) {
+            if (column > 0)
+                os.put(',');
+            BethYw::writeJSONString(os, matrix.measures[column]);
+            os.put(':');
+            writeValue(row, column);
+        }
+        os.put('}');
+    }
+    os.put('}');
+}
+
+} // namespace
+
+/*
+  Retrieve the correlation coefficient of two measures.
+
+  @param row
+    The index of the first measure in measures
+
+  @param column
+    The index of the second measure in measures
+
+  @return
+    The coefficient, from -1 to 1, or NaN if it couldn't be calculated
+
+  @example
+    auto matrix = data.correlate(BethYw::CorrelationMethod::Pearson);
+    double r = matrix.getCoefficient(0, 1);
+*/
+double BethYw::CorrelationMatrix::getCoefficient(std::size_t row, std::size_t column) const {
+    return coefficients[row * measures.size() + column];
+}
+
+/*
+  Retrieve the number of (area, year) values two measures had in common.
+
+  @param row
+    The index of the first measure in measures
+
+  @param column
+    The index of the second measure in measures
+
+  @return
+    The number of values the coefficient was calculated from
+
+  @example
+    auto matrix = data.correlate(BethYw::CorrelationMethod::Pearson);
+    auto n = matrix.getCount(0, 1);
+*/
+std::size_t BethYw::CorrelationMatrix::getCount(std::size_t row, std::size_t column) const {
+    return counts[row * measures.size() + column];
+}
+
+/*
+  Correlate every pair of columns, using the rows both have a value (not NaN)
+  in. The pairs are split into BLOCK x BLOCK blocks of columns and the blocks
+  are handed out to the threads one at a time, so each thread works through
+  a few columns at once and no two threads write to the same pair.
+
+  @param columns
+    count columns of rows values each, one column after another
+
+  @param rows
+    The number of rows in each column
+
+  @param count
+    The number of columns
+
+  @param method
+    Pearson's (linear) or Spearman's (rank) correlation
+
+  @param coefficients
+    Output: count x count coefficients, row-major
+
+  @param counts
+    Output: count x count numbers of rows used for each coefficient
+
+  @param threads
+    The number of threads to use, or 0 for one per hardware thread
+
+  @example
+    double columns[] = {1, 2, 3,   2, 4, 7};
+    double r[4];
+    std::size_t n[4];
+    BethYw::correlateColumns(columns, 3, 2, BethYw::CorrelationMethod::Pearson, r, n);
+*/
+void BethYw::correlateColumns(const double* columns,
+                              std::size_t rows,
+                              std::size_t count,
+                              CorrelationMethod method,
+                              double* coefficients,
+                              std::size_t* counts,
+                              unsigned int threads) {
+    if (count == 0)
+        return;
+
+    std::vector<double> centred(columns, columns + rows * count);
+    for (std::size_t column = 0; column < count; column++) {
+        double* values = centred.data() + column * rows;
+        double sum = 0;
+        std::size_t n = 0;
+        for (std::size_t row = 0; row < rows; row++) {
+            if (!std::isnan(values[row])) {
+                sum += values[row];
+                n++;
+            }
+        }
+        double mean = n == 0 ? 0 : sum / n;
+        for (std::size_t row = 0; row < rows; row++)
+            values[row] -= mean;
+    }
+
+    //the blocks on and above the diagonal, as (first row block, first column block)
+    const std::size_t blocks = (count + BLOCK - 1) / BLOCK;
+    std::vector<std::pair<std::size_t, std::size_t>> work;
+    for (std::size_t i = 0; i < blocks; i++)
+        for (std::size_t j = i; j < blocks; j++)
+            work.emplace_back(i * BLOCK, j * BLOCK);
+
+    BethYw::parallelFor(work.size(), [&](std::size_t block) {
+        std::size_t rowEnd = std::min(work[block].first + BLOCK, count);
+        std::size_t columnEnd = std::min(work[block].second + BLOCK, count);
+
+        for (std::size_t i = work[block].first; i < rowEnd; i++) {
+            for (std::size_t j = std::max(i, work[block].second); j < columnEnd; j++) {
+                const double* x = centred.data() + i * rows;
+                const double* y = centred.data() + j * rows;
+                std::size_t n = 0;
+                double r = method == CorrelationMethod::Spearman ? spearman(x, y, rows, n)
+                                                                  : pearson(x, y, rows, n);
+                coefficients[i * count + j] = coefficients[j * count + i] = r;
+                counts[i * count + j] = counts[j * count + i] = n;
+            }
+        }
+    }, threads);
+}
+
+/*
+  Write a correlation matrix as tables, one for each measure with a column for
+  every measure it was correlated with, like the tables of a Measure's values.
+
+  @param os
+    The output stream to write to
+
+  @param matrix
+    The correlation matrix
+
+  @example
+    auto matrix = data.correlate(BethYw::CorrelationMethod::Spearman);
+    BethYw::writeCorrelationTable(std::cout, matrix);
+*/
+void BethYw::writeCorrelationTable(std::ostream& os, const CorrelationMatrix& matrix) {
+    const char* method = matrix.method == CorrelationMethod::Spearman ? "Spearman" : "Pearson";
+    if (matrix.measures.empty()) {
+        os << "<no measures>\n";
+        return;
+    }
+
+    TableWriter table;
+    for (std::size_t row = 0; row < matrix.measures.size(); row++) {
+        os << method << " correlation with " << matrix.measures[row] << '\n';
+        table.clear();
+        for (std::size_t column = 0; column < matrix.measures.size(); column++)
+            table.addColumn(matrix.measures[column], matrix.getCoefficient(row, column));
+        table.write(os);
+        os.put('\n');
+    }
+}
+
+/*
+  Write a correlation matrix as JSON: an object with the method, and for each
+  measure an object of its coefficient with every measure (null where it
+  couldn't be calculated) and the number of values each was calculated from.
+
+  @param os
+    The output stream to write to
+
+  @param matrix
+    The correlation matrix
+
+  @example
+    auto matrix = data.correlate(BethYw::CorrelationMethod::Pearson);
+    BethYw::writeCorrelationJSON(std::cout, matrix);
+    // {"coefficients":{"dens":{"dens":1.0,...},...},"counts":{...},"method":"pearson"}
+*/
+void BethYw::writeCorrelationJSON(std::ostream& os, const CorrelationMatrix& matrix) {
+    os.write("{\"coefficients\":", 16);
+    writeJSONMatrix(os, matrix, [&os, &matrix](std::size_t row, std::size_t column) {
+        writeJSONNumber(os, matrix.getCoefficient(row, column));
+    });
+    os.write(",\"counts\":", 10);
+    writeJSONMatrix(os, matrix, [&os, &matrix](std::size_t row, std::size_t column) {
+        os << matrix.getCount(row, column);
+    });
+    os << ",\"method\":\"" << (matrix.method == CorrelationMethod::Spearman ? "spearman" : "pearson") << "\"}";
+}
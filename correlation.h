@@ -0,0 +1,65 @@
+#ifndef CORRELATION_H_
+#define CORRELATION_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for correlating every measure with every
+  other measure, across all areas and years.
+
+  The values are laid out as one column per measure and one row per (area,
+  year), with NaN where a measure has no value for that area and year, so each
+  pair of measures is compared over the rows both have a value in. Pairs are
+  worked through in square blocks of columns, so the columns of a block stay in
+  the cache while every pair in it is done, and the blocks are shared out
+  between threads.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace BethYw {
+
+enum class CorrelationMethod { Pearson, Spearman };
+
+/*
+  The correlation coefficient of every pair of measures, and the number of
+  (area, year) values they had in common. A coefficient is NaN when there
+  were fewer than two common values or one of the measures didn't vary.
+*/
+struct CorrelationMatrix {
+  CorrelationMethod method = CorrelationMethod::Pearson;
+
+  // the codename of the measure in each row/column
+  std::vector<std::string> measures;
+
+  // row-major, measures.size() x measures.size()
+  std::vector<double> coefficients;
+  std::vector<std::size_t> counts;
+
+  double getCoefficient(std::size_t row, std::size_t column) const;
+  std::size_t getCount(std::size_t row, std::size_t column) const;
+};
+
+/*----Kernels----*/
+void correlateColumns(const double* columns,
+                      std::size_t rows,
+                      std::size_t count,
+                      CorrelationMethod method,
+                      double* coefficients,
+                      std::size_t* counts,
+                      unsigned int threads = 0);
+
+/*----Output----*/
+void writeCorrelationTable(std::ostream& os, const CorrelationMatrix& matrix);
+void writeCorrelationJSON(std::ostream& os, const CorrelationMatrix& matrix);
+
+} // namespace BethYw
+
+#endif // CORRELATION_H_
@@ -0,0 +1,286 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of derived measure expressions. See
+  the header file for additional comments.
+
+  Expressions are parsed by recursive descent (sum, then product, then unary
+  minus, then numbers, codenames and brackets), with each rule appending its
+  steps to the program after its operands, which leaves them in postfix order.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "bethyw.h"
+#include "expression.h"
+
+namespace {
+
+void skipSpaces(const std::string& text, std::size_t& pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        pos++;
+}
+
+bool isCodenameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isCodenameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::invalid_argument invalidExpression(const std::string& text) {
+    return std::invalid_argument("Invalid measure expression: " + text);
+}
+
+} // namespace
+
+/*
+  Parse an expression over measure codenames. Codenames are case insensitive
+  and made of letters, digits and underscores (not starting with a digit), and
+  the expression must use at least one of them.
+
+  @param text
+    The expression, e.g. "pop / area"
+
+  @throws
+    std::invalid_argument if the expression is not valid, with the message:
+    Invalid measure expression: <text>
+    or if brackets and unary minus are nested more than MAX_EXPRESSION_DEPTH
+    deep, with the message:
+    Invalid measure expression (nested too deeply): <text>
+
+  @example
+    BethYw::Expression expression("pop / area");
+*/
+BethYw::Expression::Expression(const std::string& text) : text(text) {
+    std::size_t pos = 0;
+    parseSum(pos, 0);
+    skipSpaces(text, pos);
+    if (pos != text.size() || measures.empty())
+        throw invalidExpression(text);
+}
+
+void BethYw::Expression::push(Step::Op op, double constant, std::size_t measure) {
+    Step step;
+    step.op = op;
+    step.constant = constant;
+    step.measure = measure;
+    program.push_back(step);
+}
+
+void BethYw::Expression::parseSum(std::size_t& pos, unsigned int depth) {
+    parseProduct(pos, depth);
+    for (;;) {
+        skipSpaces(text, pos);
+        if (pos == text.size() || (text[pos] != '+' && text[pos] != '-'))
+            return;
+        Step::Op op = text[pos++] == '+' ? Step::ADD : Step::SUBTRACT;
+        parseProduct(pos, depth);
+        push(op);
+    }
+}
+
+void BethYw::Expression::parseProduct(std::size_t& pos, unsigned int depth) {
+    parseUnary(pos, depth);
+    for (;;) {
+        skipSpaces(text, pos);
+        if (pos == text.size() || (text[pos] != '*' && text[pos] != '/'))
+            return;
+        Step::Op op = text[pos++] == '*' ? Step::MULTIPLY : Step::DIVIDE;
+        parseUnary(pos, depth);
+        push(op);
+    }
+}
+
+void BethYw::Expression::parseUnary(std::size_t& pos, unsigned int depth) {
+    if (depth > BethYw::MAX_EXPRESSION_DEPTH)
+        throw std::invalid_argument("Invalid measure expression (nested too deeply): " + text);
+
+    skipSpaces(text, pos);
+    if (pos < text.size() && text[pos] == '-') {
+        pos++;
+        parseUnary(pos, depth + 1);
+        push(Step::NEGATE);
+        return;
+    }
+    parsePrimary(pos, depth);
+}
+
+void BethYw::Expression::parsePrimary(std::size_t& pos, unsigned int depth) {
+    skipSpaces(text, pos);
+    if (pos == text.size())
+        throw invalidExpression(text);
+
+    char c = text[pos];
+    if (c == '(') {
+        pos++;
+        parseSum(pos, depth + 1);
+        skipSpaces(text, pos);
+        if (pos == text.size() || text[pos] != ')')
+            throw invalidExpression(text);
+        pos++;
+    } else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        double constant = std::strtod(start, &end);
+        if (end == start)
+            throw invalidExpression(text);
+        pos += end - start;
+        push(Step::CONSTANT, constant);
+    } else if (isCodenameStart(c)) {
+        std::size_t start = pos;
+        while (pos < text.size() && isCodenameChar(text[pos]))
+            pos++;
+        std::string codename = BethYw::convertToLower(text.substr(start, pos - start));
+
+        auto found = std::find(measures.begin(), measures.end(), codename);
+        std::size_t index = found - measures.begin();
+        if (found == measures.end())
+            measures.push_back(codename);
+        push(Step::MEASURE, 0, index);
+    } else {
+        throw invalidExpression(text);
+    }
+}
+
+/*
+  Retrieve the text the expression was parsed from.
+
+  @return
+    The expression as it was written
+
+  @example
+    BethYw::Expression expression("pop / area");
+    auto text = expression.getText(); // returns "pop / area"
+*/
+const std::string& BethYw::Expression::getText() const {
+    return text;
+}
+
+/*
+  Retrieve the (lowercase) codenames of the measures used in the expression,
+  each once, in the order they first appear. The values passed to evaluate()
+  must be in this order.
+
+  @return
+    The codenames of the measures the expression uses
+
+  @example
+    BethYw::Expression expression("pop / area");
+    auto measures = expression.getMeasures(); // returns {"pop", "area"}
+*/
+const std::vector<std::string>& BethYw::Expression::getMeasures() const {
+    return measures;
+}
+
+/*
+  Evaluate the expression for one set of values of its measures.
+
+  @param values
+    The value of each measure, in the order of getMeasures()
+
+  @return
+    The value of the expression (which may be infinite or NaN, e.g. after a
+    division by zero)
+
+  @example
+    BethYw::Expression expression("pop / area");
+    double values[] = {188771, 2370.2762};
+    auto density = expression.evaluate(values); // returns 79.64093...
+*/
+double BethYw::Expression::evaluate(const double* values) const {
+    static thread_local std::vector<double> stack;
+    stack.clear();
+
+    for (auto const& step : program) {
+        if (step.op == Step::CONSTANT) {
+            stack.push_back(step.constant);
+            continue;
+        }
+        if (step.op == Step::MEASURE) {
+            stack.push_back(values[step.measure]);
+            continue;
+        }
+        if (step.op == Step::NEGATE) {
+            stack.back() = -stack.back();
+            continue;
+        }
+
+        double rhs = stack.back();
+        stack.pop_back();
+        double& lhs = stack.back();
+        switch (step.op) {
+            case Step::ADD:      lhs += rhs; break;
+            case Step::SUBTRACT: lhs -= rhs; break;
+            case Step::MULTIPLY: lhs *= rhs; break;
+            default:             lhs /= rhs; break;
+        }
+    }
+    return stack.back();
+}
+
+/*
+  Construct a Derivation from its codename and expression.
+
+  @param codename
+    The codename to store the derived measure under (converted to lowercase)
+
+  @param expression
+    The expression to parse
+
+  @throws
+    std::invalid_argument if the expression is not valid
+
+  @example
+    BethYw::Derivation derivation("popden", "pop / area");
+*/
+BethYw::Derivation::Derivation(const std::string& codename, const std::string& expression)
+    : codename(BethYw::convertToLower(codename)), expression(expression) {}
+
+/*
+  Parse the definition of a derived measure, written as a codename, an equals
+  sign, and an expression.
+
+  @param definition
+    The definition, e.g. "popden = pop / area"
+
+  @return
+    The Derivation
+
+  @throws
+    std::invalid_argument if the codename or the expression is not valid, with
+    the message: Invalid derived measure: <definition>
+
+  @example
+    auto derivation = BethYw::parseDerivation("popden = pop / area");
+*/
+BethYw::Derivation BethYw::parseDerivation(const std::string& definition) {
+    std::size_t equals = definition.find('=');
+    if (equals == std::string::npos)
+        throw std::invalid_argument("Invalid derived measure: " + definition);
+
+    std::size_t start = 0;
+    skipSpaces(definition, start);
+    std::size_t end = start;
+    while (end < equals && isCodenameChar(definition[end]))
+        end++;
+    std::size_t rest = end;
+    skipSpaces(definition, rest);
+    if (end == start || !isCodenameStart(definition[start]) || rest != equals)
+        throw std::invalid_argument("Invalid derived measure: " + definition);
+
+    std::size_t first = equals + 1;
+    skipSpaces(definition, first);
+    std::size_t last = definition.size();
+    while (last > first && std::isspace(static_cast<unsigned char>(definition[last - 1])))
+        last--;
+    return Derivation(definition.substr(start, end - start), definition.substr(first, last - first));
+}
@@ -0,0 +1,92 @@
+#ifndef EXPRESSION_H_
+#define EXPRESSION_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for derived measures: measures that are
+  not imported from a dataset but defined as an arithmetic expression over
+  other measures, e.g.
+
+    popden = pop / area
+
+  The expression is parsed once into a small postfix (reverse Polish) program
+  that is shared by every Area, and each Area evaluates it when the derived
+  Measure is defined and again whenever one of its inputs is set (see
+  Area::defineMeasure()), so reading an Area never changes it.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace BethYw {
+
+/*
+  How deep brackets and unary minus can be nested in an expression. The
+  parser recurses once per level, so without a limit a long enough
+  "((((...))))" would overflow the stack.
+*/
+constexpr unsigned int MAX_EXPRESSION_DEPTH = 256;
+
+/*
+  An arithmetic expression over measure codenames and numbers, using + - * /,
+  unary minus and brackets, e.g. "(rail + bus) / pop * 1000".
+*/
+class Expression {
+private:
+  struct Step {
+    enum Op { CONSTANT, MEASURE, ADD, SUBTRACT, MULTIPLY, DIVIDE, NEGATE };
+    Op op;
+    // the number for CONSTANT, or the index into measures for MEASURE
+    double constant;
+    std::size_t measure;
+  };
+
+  std::string text;
+
+  // the steps in postfix order, run on a stack
+  std::vector<Step> program;
+
+  // lowercase codenames of the measures used, in order of first use
+  std::vector<std::string> measures;
+
+  /*----Parser----*/
+  void parseSum(std::size_t& pos, unsigned int depth);
+  void parseProduct(std::size_t& pos, unsigned int depth);
+  void parseUnary(std::size_t& pos, unsigned int depth);
+  void parsePrimary(std::size_t& pos, unsigned int depth);
+  void push(Step::Op op, double constant = 0, std::size_t measure = 0);
+
+public:
+  /*----Constructor----*/
+  explicit Expression(const std::string& text) noexcept(false);
+
+  /*----Getters----*/
+  const std::string& getText() const;
+  const std::vector<std::string>& getMeasures() const;
+
+  /*----Evaluation----*/
+  double evaluate(const double* values) const;
+};
+
+/*
+  A derived measure: the codename it is stored under and its expression.
+*/
+struct Derivation {
+  std::string codename;
+  Expression expression;
+
+  Derivation(const std::string& codename, const std::string& expression);
+};
+
+/*----Parser----*/
+Derivation parseDerivation(const std::string& definition) noexcept(false);
+
+} // namespace BethYw
+
+#endif // EXPRESSION_H_
@@ -0,0 +1,187 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the file helpers. See the header
+  file for additional comments.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "fileutil.h"
+
+namespace {
+
+// numbers the temporary files written by this process
+std::atomic<unsigned long> temporaryCount(0);
+
+/*
+  A name for a temporary file next to a file that no other thread or
+  process will use at the same time: the path with the process ID and a
+  count on the end.
+*/
+std::string temporaryPath(const std::string& path) {
+#ifdef _WIN32
+    long pid = ::_getpid();
+#else
+    long pid = static_cast<long>(::getpid());
+#endif
+    return path + "." + std::to_string(pid) + "-" + std::to_string(temporaryCount++) + ".tmp";
+}
+
+} // namespace
+
+/*
+  Get the size and modified time of a file. The modified time is as precise
+  as the file system keeps it (nanoseconds on Linux and macOS, 100ns on
+  Windows), so a file rewritten with the same size in the same second still
+  gets a new stamp.
+
+  @param path
+    The path of the file
+
+  @param size
+    Where to put its size in bytes
+
+  @param modified
+    Where to put its modified time, in nanoseconds since the epoch
+
+  @return
+    true, or false if the file can't be found (and size and modified are
+    left alone)
+
+  @example
+    unsigned long long size;
+    long long modified;
+    if (BethYw::stampFile("datasets/popu1009.json", size, modified)) {
+      ...
+    }
+*/
+bool BethYw::stampFile(const std::string& path, unsigned long long& size, long long& modified) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!::GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+        return false;
+    size = (static_cast<unsigned long long>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    //100ns ticks since 1601
+    long long ticks = static_cast<long long>((static_cast<unsigned long long>(info.ftLastWriteTime.dwHighDateTime) << 32)
+                                             | info.ftLastWriteTime.dwLowDateTime);
+    modified = (ticks - 116444736000000000LL) * 100;
+#else
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0)
+        return false;
+    size = static_cast<unsigned long long>(info.st_size);
+#ifdef __APPLE__
+    const struct timespec& time = info.st_mtimespec;
+#else
+    const struct timespec& time = info.st_mtim;
+#endif
+    modified = static_cast<long long>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+#endif
+    return true;
+}
+
+/*
+  64-bit FNV-1a hash of some bytes.
+
+  @param bytes
+    The bytes to hash
+
+  @param length
+    How many there are
+
+  @return
+    The hash
+
+  @example
+    std::string path = "datasets/popu1009.json";
+    auto hash = BethYw::hashBytes(path.data(), path.size());
+*/
+std::uint64_t BethYw::hashBytes(const char* bytes, std::size_t length) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+  Make a directory, if it isn't there already. Failing to make it is not an
+  error here: writing a file in it will fail instead.
+
+  @param dir
+    The path of the directory
+
+  @example
+    BethYw::makeDirectory("cache/");
+*/
+void BethYw::makeDirectory(const std::string& dir) {
+#ifdef _WIN32
+    ::_mkdir(dir.c_str());
+#else
+    ::mkdir(dir.c_str(), 0755);
+#endif
+}
+
+/*
+  Write a file by writing a temporary file next to it (named so that no other
+  writer of the same file uses it too) and renaming that over it, so no other
+  process reads half of it. On Windows std::rename() won't replace a file
+  that is already there, so if it fails for that reason the old file is
+  removed and the rename tried again. The temporary file is removed if the
+  file can't be written.
+
+  @param path
+    The path of the file
+
+  @param contents
+    The bytes to write to it
+
+  @return
+    true if the file was written, false otherwise
+
+  @example
+    BethYw::writeFileAtomically("datasets/.bethyw-measures", index);
+*/
+bool BethYw::writeFileAtomically(const std::string& path, const std::string& contents) {
+    std::string temporary = temporaryPath(path);
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file || !file.write(contents.data(), contents.size())) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) == 0)
+        return true;
+#ifdef _WIN32
+    if (errno == EEXIST) {
+        std::remove(path.c_str());
+        if (std::rename(temporary.c_str(), path.c_str()) == 0)
+            return true;
+    }
+#endif
+    std::remove(temporary.c_str());
+    return false;
+}
@@ -0,0 +1,31 @@
+#ifndef FILEUTIL_H_
+#define FILEUTIL_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations of the small file helpers shared by
+  the caches of the datasets (the measure index, the area index and the
+  snapshots): the size and modified time they check a dataset by, the hash
+  they name their files and check contents by, making the cache directory,
+  and writing a cache file so no other process reads half of it.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BethYw {
+
+bool stampFile(const std::string& path, unsigned long long& size, long long& modified);
+std::uint64_t hashBytes(const char* bytes, std::size_t length);
+void makeDirectory(const std::string& dir);
+bool writeFileAtomically(const std::string& path, const std::string& contents);
+
+} // namespace BethYw
+
+#endif // FILEUTIL_H_
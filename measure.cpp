@@ -15,17 +15,15 @@
 #include <stdexcept>
 #include <string>
 #include <numeric>
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <sstream>
+#include <vector>
 
 #include "measure.h"
 #include "bethyw.h"
-#include "lib_json.hpp"
-
-
-/*
-  An alias for the imported JSON parsing library.
-*/
-using json = nlohmann::json;
+#include "output.h"
 
 /*
   Construct a single Measure, that has values across many years.
@@ -45,11 +43,7 @@ using json = nlohmann::json;
     Measure measure(codename, label);
 */
 Measure::Measure(std::string codename, const std::string &label) {
-    std::string temp;
-    for(char& c : codename) {
-       temp += std::tolower(c);
-    }
-    this->codename = codename;
+    this->codename = BethYw::convertToLower(codename);
     this->label = label;
 }
 
@@ -163,9 +157,25 @@ double Measure::getValue(unsigned int key){
     measure.setValue(1999, 12345678.9);
 */
 void Measure::setValue(unsigned int key, double value){
-    if(this->readings.find(key) != this->readings.end())
-        this->readings.find(key)->second = value;
-    this->readings.insert(std::pair<unsigned int, double>(key,value));
+    auto existing = readings.find(key);
+    if(existing == readings.end()){
+        readings.insert(std::pair<unsigned int, double>(key,value));
+        addToTotals(value);
+        return;
+    }
+
+    double old = existing->second;
+    existing->second = value;
+    addToSum(-old);
+    addToSum(value);
+
+    //only a replaced minimum/maximum that moved inwards needs a rescan
+    if((old == minimum && value > old) || (old == maximum && value < old)){
+        recalculateRange();
+    }else{
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
 }
 
 /*
@@ -204,6 +214,8 @@ unsigned int Measure::size() const{
     auto diff = measure.getDifference(); // returns 1.0
 */
 double Measure::getDifference() const{
+    if(readings.empty())
+        return 0;
     return  ( readings.rbegin()->second - readings.begin()->second);
 }
 
@@ -223,15 +235,17 @@ double Measure::getDifference() const{
     auto diff = measure.getDifferenceAsPercentage();
 */
 double Measure::getDifferenceAsPercentage() const{
-    if(getDifference() == 0)
+    double difference = getDifference();
+    if(difference == 0 || readings.begin()->second == 0)
         return 0;
-    return ((getDifference()/readings.begin()->second) * 100);
+    return ((difference/readings.begin()->second) * 100);
 }
 
 /*
   Calculate the average/mean value for all the values. This function should be
   callable from a constant context and must promise to not change the state of 
-  the instance or throw an exception.
+  the instance or throw an exception. The sum is kept up to date as values are
+  set, so this doesn't need to walk the readings.
 
   @return
     The average value for all the years, or 0 if it cannot be calculated
@@ -247,11 +261,119 @@ double Measure::getAverage() const{
     if(readings.size() == 0)
         return 0;
 
-    double sum = 0;
-    for (auto const& reading : readings)
-        sum += reading.second;
+    return ((sum + sumCompensation)/readings.size());
+}
+
+/*
+  Retrieve the smallest value across all the years. This function is callable
+  from a constant context and will not throw an exception.
+
+  @return
+    The smallest value, or 0 if there are no readings
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto min = measure.getMinimum(); // returns 12345678.9
+*/
+double Measure::getMinimum() const{
+    return minimum;
+}
+
+/*
+  Retrieve the largest value across all the years. This function is callable
+  from a constant context and will not throw an exception.
+
+  @return
+    The largest value, or 0 if there are no readings
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto max = measure.getMaximum(); // returns 12345679.9
+*/
+double Measure::getMaximum() const{
+    return maximum;
+}
+
+/*
+  Retrieve the first year there is a reading for. This function is callable
+  from a constant context and will not throw an exception.
+
+  @return
+    The first year, or 0 if there are no readings
 
-    return (sum/readings.size());
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto year = measure.getFirstYear(); // returns 1999
+*/
+unsigned int Measure::getFirstYear() const{
+    return readings.empty() ? 0 : readings.begin()->first;
+}
+
+/*
+  Retrieve the last year there is a reading for. This function is callable
+  from a constant context and will not throw an exception.
+
+  @return
+    The last year, or 0 if there are no readings
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto year = measure.getLastYear(); // returns 2001
+*/
+unsigned int Measure::getLastYear() const{
+    return readings.empty() ? 0 : readings.rbegin()->first;
+}
+
+/*
+  Calculate the extended statistics (median, quartiles, standard deviation,
+  growth rate, trend, and the years of the smallest and largest values) for
+  this Measure. This function is callable from a constant context.
+
+  @return
+    The BethYw::Statistics for the readings
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto median = measure.getStatistics().median; // returns 12345679.4
+*/
+BethYw::Statistics Measure::getStatistics() const{
+    //the kernels work on plain arrays, reused between calls
+    static thread_local std::vector<unsigned int> years;
+    static thread_local std::vector<double> values;
+    years.clear();
+    values.clear();
+    for(auto const& reading : readings){
+        years.push_back(reading.first);
+        values.push_back(reading.second);
+    }
+    return BethYw::calculateStatistics(years.data(), values.data(), readings.size());
+}
+
+/*
+  Retrieve all of the Measure's readings, ordered by year, without copying
+  them. This function is callable from a constant context.
+
+  @return
+    A reference to the map of year to value
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    for (auto const& reading : measure.getReadings())
+      std::cout << reading.first << ": " << reading.second;
+*/
+const std::map<unsigned int, double>& Measure::getReadings() const{
+    return readings;
 }
 
 /*
@@ -269,7 +391,12 @@ double Measure::getAverage() const{
   If there is no data in this measure, print the name and code, and 
   on the next line print: <no data>
 
-  See the coursework specification for more information.
+  See the coursework specification for more information. Each heading is
+  right-aligned to the width of the value below it, and values are formatted
+  into a reusable BethYw::TableWriter rather than one std::string each.
+
+  If the stream has BethYw::withStatistics set, a second table of the
+  extended statistics (see statistics.h) is printed below the values.
 
   @param os
     The output stream to write to
@@ -292,15 +419,44 @@ double Measure::getAverage() const{
     <value 1>  <year 2> <year 3> ... <value n> <mean 2> <diff 2> <diffp 2>
 */
 std::ostream &operator<<(std::ostream &os, const Measure &measure) {
-    std::string tab = "    ";
-    os << measure.label << tab << '(' << measure.codename << ')' << std::endl;
-    for (auto const &reading : measure.readings)
-        os << tab << reading.first;
-    os << tab << "Average" << tab << "Diff." << tab <<" % Diff." << std::endl;
+    os << measure.label << " (" << measure.codename << ") \n";
+
+    if(measure.readings.empty()){
+        os << "<no data>\n\n";
+        return os;
+    }
+
+    //reused between calls so printing a table doesn't allocate
+    static thread_local BethYw::TableWriter table;
+    table.clear();
+
     for (auto const &reading : measure.readings)
-        os << std::to_string(reading.second) << ' ';
-    os << std::to_string(measure.getAverage()) << tab << std::to_string(measure.getDifference()) << tab
-    << std::to_string(measure.getDifferenceAsPercentage()) << std::endl;
+        table.addColumn(reading.first, reading.second);
+
+    static const std::string average = "Average";
+    static const std::string difference = "Diff.";
+    static const std::string percentage = "% Diff.";
+    table.addColumn(average, measure.getAverage());
+    table.addColumn(difference, measure.getDifference());
+    table.addColumn(percentage, measure.getDifferenceAsPercentage());
+
+    table.write(os);
+
+    if(BethYw::showStatistics(os)){
+        auto stats = measure.getStatistics();
+        table.clear();
+        table.addColumn("Median", stats.median);
+        table.addColumn("Lower Q.", stats.lowerQuartile);
+        table.addColumn("Upper Q.", stats.upperQuartile);
+        table.addColumn("Std. Dev.", stats.standardDeviation);
+        table.addColumn("Growth %/yr", stats.growthRate);
+        table.addColumn("Trend/yr", stats.trend);
+        table.addColumn("Min. Year", stats.minimumYear);
+        table.addColumn("Max. Year", stats.maximumYear);
+        table.write(os);
+    }
+
+    os.put('\n');
     return os;
 }
 
@@ -344,7 +500,57 @@ bool operator==(const Measure& lhs, const Measure& rhs){
     measure1.merge(measure2);
 */
 void Measure::merge(Measure measureNew){
-    readings.insert(measureNew.readings.begin(), measureNew.readings.end());
+    for(auto const& reading : measureNew.readings){
+        if(readings.insert(reading).second)
+            addToTotals(reading.second);
+    }
+}
+
+/*
+  Add (or, with a negative value, take away) a value to the running sum,
+  keeping the rounding error in sumCompensation (Neumaier summation).
+
+  @param value
+    The value to add
+*/
+void Measure::addToSum(double value){
+    double total = sum + value;
+    if(std::fabs(sum) >= std::fabs(value))
+        sumCompensation += (sum - total) + value;
+    else
+        sumCompensation += (value - total) + sum;
+    sum = total;
+}
+
+/*
+  Update the running totals for a reading that has just been added.
+
+  @param value
+    The value of the new reading
+*/
+void Measure::addToTotals(double value){
+    addToSum(value);
+    if(readings.size() == 1){
+        minimum = value;
+        maximum = value;
+    }else{
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+}
+
+/*
+  Find the minimum and maximum again by walking the readings, for when the
+  old minimum or maximum has been replaced by a value further inside the
+  range.
+*/
+void Measure::recalculateRange(){
+    minimum = readings.begin()->second;
+    maximum = minimum;
+    for(auto const& reading : readings){
+        minimum = std::min(minimum, reading.second);
+        maximum = std::max(maximum, reading.second);
+    }
 }
 
 /*
@@ -354,10 +560,39 @@ void Measure::merge(Measure measureNew){
     std::string
 */
 std::string Measure::toJSON() const{
-    json j;
-    for (auto const& reading : readings)
-        j[std::to_string(reading.first)] = reading.second;
-
-    return j.dump();
+    std::ostringstream os;
+    toJSON(os);
+    return os.str();
 }
 
+/*
+  Write this Measure's readings straight to an output stream as a JSON object
+  of year to value, e.g. {"1991":711.6801,"1992":711.6801}. A Measure with no
+  readings is written as null. The output is the same as dumping the readings
+  with lib_json.hpp, without building a json object first.
+
+  @param os
+    The output stream to write to
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.toJSON(std::cout); // {"1999":12345678.9}
+*/
+void Measure::toJSON(std::ostream& os) const{
+    if(readings.empty()){
+        os.write("null", 4);
+        return;
+    }
+
+    char sep = '{';
+    for (auto const& reading : readings){
+        os.put(sep);
+        os.put('"');
+        os << reading.first;
+        os.write("\":", 2);
+        BethYw::writeJSONNumber(os, reading.second);
+        sep = ',';
+    }
+    os.put('}');
+}
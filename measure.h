@@ -16,6 +16,7 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include "statistics.h"
 
 /*
   The Measure class contains a measure code, label, and a container for readings
@@ -35,6 +36,19 @@ private:
     //Key = the year for the data | Value = the data
     std::map<unsigned int, double> readings;
 
+    //Running totals of the readings, kept up to date by setValue() and
+    //merge() so the summary statistics don't need to walk the readings.
+    //The sum is compensated (Neumaier) so it doesn't drift as values change
+    double sum = 0;
+    double sumCompensation = 0;
+    double minimum = 0;
+    double maximum = 0;
+
+    /*----Helper----*/
+    void addToSum(double value);
+    void addToTotals(double value);
+    void recalculateRange();
+
 public:
   /*----Constructor----*/
   Measure() = default;
@@ -51,11 +65,18 @@ public:
   double getDifference() const;
   double getDifferenceAsPercentage() const;
   double getAverage() const;
+  double getMinimum() const;
+  double getMaximum() const;
+  unsigned int getFirstYear() const;
+  unsigned int getLastYear() const;
+  BethYw::Statistics getStatistics() const;
+  const std::map<unsigned int, double>& getReadings() const;
 
   /*----Miscellaneous----*/
   unsigned int size() const;
   void merge(Measure measureNew);
   std::string toJSON() const;
+  void toJSON(std::ostream& os) const;
 
   /*----Overrides----*/
   friend bool operator==(const Measure& lhs, const Measure& rhs);
@@ -0,0 +1,462 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the measure index. See the header
+  file for additional comments.
+ */
+
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "bethyw.h"
+#include "fileutil.h"
+#include "input.h"
+#include "measureindex.h"
+#include "parallel.h"
+#include "snapshot.h"
+
+namespace {
+
+struct IndexEntry {
+  unsigned long long size;
+  long long modified;
+  BethYw::DatasetManifest manifest;
+};
+
+using Index = std::map<std::string, IndexEntry>;
+
+// an index file as it was last read or written by this process
+struct CachedIndex {
+  bool exists = false;
+  unsigned long long size = 0;
+  long long modified = 0;
+  Index index;
+};
+
+// the index in each cache directory, kept in memory so that a query (e.g. on
+// one of the threads of --serve) only stats the files instead of reading the
+// index file again, unless another process has changed it. Without a cache
+// directory (""), it is only kept in memory.
+std::map<std::string, CachedIndex> indexes;
+
+// guards indexes and the writing of the index files; never held while a
+// dataset is being scanned
+std::mutex indexMutex;
+
+/*
+  Split a comma-separated field of the index into a set.
+*/
+std::set<std::string> readCodes(const std::string& field) {
+    std::set<std::string> codes;
+    std::istringstream stream(field);
+    std::string code;
+    while (std::getline(stream, code, ','))
+        if (!code.empty())
+            codes.insert(code);
+    return codes;
+}
+
+/*
+  Join a set into a comma-separated field of the index.
+*/
+void writeCodes(std::ostream& os, const std::set<std::string>& codes) {
+    bool first = true;
+    for (auto const& code : codes) {
+        os << (first ? "" : ",") << code;
+        first = false;
+    }
+}
+
+/*
+  Read the index file in a cache directory, skipping any line that isn't
+  valid (a missing file is an empty index, and a line from before the years,
+  rows and areas were kept is read again).
+*/
+Index readIndex(const std::string& cacheDir) {
+    Index index;
+    std::ifstream file(cacheDir + BethYw::INDEX_FILE);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name, areas, measures;
+        IndexEntry entry;
+        auto& manifest = entry.manifest;
+        if (!std::getline(fields, name, '\t')
+            || !(fields >> entry.size >> entry.modified >> manifest.firstYear >> manifest.lastYear >> manifest.rows))
+            continue;
+        fields.ignore(1);
+        if (!std::getline(fields, areas, '\t'))
+            continue;
+        std::getline(fields, measures);
+        manifest.areas = readCodes(areas);
+        manifest.measures = readCodes(measures);
+        manifest.scanned = true;
+        index[name] = entry;
+    }
+    return index;
+}
+
+/*
+  Write the index file in a cache directory (see
+  BethYw::writeFileAtomically). Failing to write it is not an error.
+*/
+void writeIndex(const std::string& cacheDir, const Index& index) {
+    std::ostringstream contents;
+    for (auto const& entry : index) {
+        auto const& manifest = entry.second.manifest;
+        contents << entry.first << '\t' << entry.second.size << '\t' << entry.second.modified << '\t'
+                 << manifest.firstYear << '\t' << manifest.lastYear << '\t' << manifest.rows << '\t';
+        writeCodes(contents, manifest.areas);
+        contents << '\t';
+        writeCodes(contents, manifest.measures);
+        contents << '\n';
+    }
+    BethYw::makeDirectory(cacheDir);
+    BethYw::writeFileAtomically(cacheDir + BethYw::INDEX_FILE, contents.str());
+}
+
+/*
+  The index in a cache directory, read again from its file if this process
+  hasn't read it yet or the file has changed since. indexMutex must be held.
+*/
+CachedIndex& currentIndex(const std::string& cacheDir) {
+    if (cacheDir.empty())
+        return indexes[cacheDir];
+
+    CachedIndex now;
+    now.exists = BethYw::stampFile(cacheDir + BethYw::INDEX_FILE, now.size, now.modified);
+    auto cached = indexes.find(cacheDir);
+    if (cached != indexes.end() && cached->second.exists == now.exists
+        && cached->second.size == now.size && cached->second.modified == now.modified)
+        return cached->second;
+
+    now.index = readIndex(cacheDir);
+    return indexes[cacheDir] = std::move(now);
+}
+
+/*
+  Import a dataset with no filters and collect its measures, areas, years
+  and number of readings. With a cache directory it is imported through its
+  snapshot (see snapshot.h), which is then there for the import that follows,
+  so the dataset is only parsed once.
+*/
+BethYw::DatasetManifest scanDataset(const std::string& dir,
+                                    const BethYw::InputFileSource& dataset,
+                                    const std::string& cacheDir) {
+    Areas imported = Areas();
+    if (!cacheDir.empty()) {
+        imported = BethYw::importDataset(dir, dataset, cacheDir);
+    } else {
+        const StringFilterSet all;
+        const YearFilterTuple allYears(0, 0);
+        InputFile datasetFile(dir + dataset.FILE);
+        imported.populate(datasetFile.open(), dataset.PARSER, dataset.COLS, &all, &all, &allYears);
+    }
+
+    BethYw::DatasetManifest manifest;
+    manifest.scanned = true;
+    for (auto const& area : imported.getAreas()) {
+        manifest.areas.insert(area.first);
+        for (auto const& measure : area.second.getMeasures()) {
+            manifest.measures.insert(measure.first);
+            if (measure.second.size() == 0)
+                continue;
+            unsigned int first = measure.second.getFirstYear();
+            unsigned int last = measure.second.getLastYear();
+            if (manifest.rows == 0 || first < manifest.firstYear)
+                manifest.firstYear = first;
+            if (manifest.rows == 0 || last > manifest.lastYear)
+                manifest.lastYear = last;
+            manifest.rows += measure.second.size();
+        }
+    }
+    return manifest;
+}
+
+/*
+  The manifest of each dataset: from the index if it is up to date, or else
+  (if scan is true) by scanning it, on the thread pool with the index
+  unlocked so other queries aren't held up, and adding it to the index. If
+  only the measures are needed, a dataset with a single measure gets it from
+  datasets.h and isn't read at all. known says which manifests were found,
+  and a dataset that couldn't be scanned gets its exception in errors.
+*/
+std::vector<BethYw::DatasetManifest> lookupManifests(const std::string& dir,
+                                                     const std::string& cacheDir,
+                                                     const std::vector<BethYw::InputFileSource>& datasets,
+                                                     bool measuresOnly,
+                                                     bool scan,
+                                                     std::vector<bool>& known,
+                                                     std::vector<std::exception_ptr>& errors) {
+    std::vector<BethYw::DatasetManifest> manifests(datasets.size());
+    known.assign(datasets.size(), false);
+    errors.assign(datasets.size(), nullptr);
+
+    //the stamps are taken before the index is looked at, so a file that
+    //changes while it is being scanned is scanned again next time
+    std::vector<std::size_t> toLookUp;
+    std::vector<IndexEntry> stamps(datasets.size());
+    std::vector<bool> stamped(datasets.size(), false);
+    for (std::size_t i = 0; i < datasets.size(); i++) {
+        auto single = datasets[i].COLS.find(BethYw::SINGLE_MEASURE_CODE);
+        if (measuresOnly && single != datasets[i].COLS.end()) {
+            manifests[i].measures.insert(BethYw::convertToLower(single->second));
+            known[i] = true;
+            continue;
+        }
+        stamped[i] = BethYw::stampFile(dir + datasets[i].FILE, stamps[i].size, stamps[i].modified);
+        toLookUp.push_back(i);
+    }
+    if (toLookUp.empty())
+        return manifests;
+
+    std::vector<std::size_t> toScan;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        auto const& index = currentIndex(cacheDir).index;
+        for (std::size_t i : toLookUp) {
+            auto found = index.find(dir + datasets[i].FILE);
+            if (stamped[i] && found != index.end() && found->second.size == stamps[i].size
+                && found->second.modified == stamps[i].modified) {
+                manifests[i] = found->second.manifest;
+                known[i] = true;
+            } else {
+                toScan.push_back(i);
+            }
+        }
+    }
+    if (toScan.empty() || !scan)
+        return manifests;
+
+    BethYw::parallelFor(toScan.size(), [&](std::size_t j) {
+        std::size_t i = toScan[j];
+        try {
+            manifests[i] = scanDataset(dir, datasets[i], cacheDir);
+            known[i] = true;
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto& cached = currentIndex(cacheDir);
+    auto& index = cached.index;
+    bool changed = false;
+    for (std::size_t i : toScan) {
+        if (errors[i] || !stamped[i])
+            continue;
+        stamps[i].manifest = manifests[i];
+        index[dir + datasets[i].FILE] = stamps[i];
+        changed = true;
+    }
+    if (changed && !cacheDir.empty()) {
+        writeIndex(cacheDir, index);
+        cached.exists = BethYw::stampFile(cacheDir + BethYw::INDEX_FILE, cached.size, cached.modified);
+    }
+    return manifests;
+}
+
+/*
+  Whether any of a set of codes is in a filter (an empty filter has them
+  all).
+*/
+bool anyWanted(const std::set<std::string>& codes, const StringFilterSet& filter) {
+    if (filter.empty())
+        return true;
+    for (auto const& code : codes)
+        if (filter.find(code) != filter.end())
+            return true;
+    return false;
+}
+
+} // namespace
+
+/*
+  Find what is in a dataset: its measures, areas, years and number of
+  readings. The index (see the header file) is used so a dataset is only
+  read if it changed since it was last indexed.
+
+  @param dir
+    The directory the dataset is in, ending in DIR_SEP
+
+  @param dataset
+    The dataset
+
+  @param cacheDir
+    The directory to keep the index (and the snapshot the dataset is read
+    through) in, ending in DIR_SEP, or empty to only keep it in memory
+
+  @return
+    The manifest of the dataset
+
+  @throws
+    std::runtime_error (or whatever the parser threw) if the dataset had to
+    be read and couldn't be
+
+  @example
+    auto manifest = BethYw::datasetManifest("datasets/", InputFiles::TRAINS, "cache/");
+    // manifest.firstYear is 1995
+*/
+BethYw::DatasetManifest BethYw::datasetManifest(const std::string& dir,
+                                                const InputFileSource& dataset,
+                                                const std::string& cacheDir) {
+    std::vector<bool> known;
+    std::vector<std::exception_ptr> errors;
+    auto manifests = lookupManifests(dir, cacheDir, {dataset}, false, true, known, errors);
+    if (errors[0])
+        std::rethrow_exception(errors[0]);
+    return manifests[0];
+}
+
+/*
+  Find the codenames of the measures in a dataset, using the index (see the
+  header file) so a dataset is only read if it changed since it was last
+  indexed.
+
+  @param dir
+    The directory the dataset is in, ending in DIR_SEP
+
+  @param dataset
+    The dataset
+
+  @param cacheDir
+    The directory to keep the index in, ending in DIR_SEP, or empty to only
+    keep it in memory
+
+  @return
+    The (lowercase) codenames of its measures
+
+  @throws
+    std::runtime_error (or whatever the parser threw) if the dataset had to
+    be read and couldn't be
+
+  @example
+    auto measures = BethYw::datasetMeasures("datasets/", InputFiles::POPDEN, "cache/");
+    // measures is {"area", "dens", "pop"}
+*/
+std::set<std::string> BethYw::datasetMeasures(const std::string& dir,
+                                              const InputFileSource& dataset,
+                                              const std::string& cacheDir) {
+    std::vector<bool> known;
+    std::vector<std::exception_ptr> errors;
+    auto manifests = lookupManifests(dir, cacheDir, {dataset}, true, true, known, errors);
+    if (errors[0])
+        std::rethrow_exception(errors[0]);
+    return manifests[0].measures;
+}
+
+/*
+  Leave out the datasets that have none of the measures in a measures
+  filter, since importing them would only add areas with no readings. A
+  dataset whose measures can't be found (e.g. its file is missing, or it
+  isn't indexed and there is no cache directory) is kept, so importing it
+  reports the error as usual.
+
+  @param dir
+    The directory the datasets are in, ending in DIR_SEP
+
+  @param datasets
+    The datasets to import
+
+  @param measuresFilter
+    The (lowercase) codenames of the measures wanted, or empty for all
+
+  @param cacheDir
+    The directory the index is kept in, ending in DIR_SEP, or empty to
+    only use what datasets.h says
+
+  @return
+    The datasets that can have readings of the measures, in the same order
+
+  @example
+    auto datasets = BethYw::datasetsWithMeasures("datasets/", BethYw::findDatasets({"all"}), {"pop"}, "cache/");
+    // datasets is POPDEN and COMPLETE_POP
+*/
+std::vector<BethYw::InputFileSource> BethYw::datasetsWithMeasures(
+        const std::string& dir,
+        const std::vector<InputFileSource>& datasets,
+        const StringFilterSet& measuresFilter,
+        const std::string& cacheDir) {
+    return BethYw::datasetsMatching(dir, datasets, StringFilterSet(), measuresFilter, YearFilterTuple(0, 0),
+                                    cacheDir);
+}
+
+/*
+  Leave out the datasets that can't have a reading left after the filters:
+  those with none of the measures wanted, none of the areas wanted, or no
+  readings in the years wanted. Importing them would only add areas (or
+  measures) with no readings. A dataset whose manifest can't be found (e.g.
+  its file is missing) is kept, so importing it reports the error as usual.
+
+  Only the measures are needed for a measures filter alone, so a dataset
+  with a single measure is only read when there is an areas or years filter.
+  Without a cache directory, no dataset is read just to find its manifest:
+  that would parse it twice (once here and once to import it) on every run,
+  so only the datasets whose measures datasets.h gives can be left out.
+
+  @param dir
+    The directory the datasets are in, ending in DIR_SEP
+
+  @param datasets
+    The datasets to import
+
+  @param areasFilter
+    The codes of the areas wanted, or empty for all
+
+  @param measuresFilter
+    The (lowercase) codenames of the measures wanted, or empty for all
+
+  @param yearsFilter
+    The first and last years wanted, or (0, 0) for all
+
+  @param cacheDir
+    The directory to keep the index and the snapshots in, ending in DIR_SEP,
+    or empty to read no datasets
+
+  @return
+    The datasets that can have readings left, in the same order
+
+  @example
+    auto datasets = BethYw::datasetsMatching("datasets/", BethYw::findDatasets({"all"}),
+                                             {}, {}, YearFilterTuple(2019, 2019), "cache/");
+    // datasets leaves out trains, whose years end before 2019
+*/
+std::vector<BethYw::InputFileSource> BethYw::datasetsMatching(
+        const std::string& dir,
+        const std::vector<InputFileSource>& datasets,
+        const StringFilterSet& areasFilter,
+        const StringFilterSet& measuresFilter,
+        const YearFilterTuple& yearsFilter,
+        const std::string& cacheDir) {
+    unsigned int yearStart = std::get<0>(yearsFilter);
+    unsigned int yearEnd = std::get<1>(yearsFilter);
+    bool allYears = yearStart == 0 && yearEnd == 0;
+    if (areasFilter.empty() && measuresFilter.empty() && allYears)
+        return datasets;
+
+    std::vector<bool> known;
+    std::vector<std::exception_ptr> errors;
+    auto manifests = lookupManifests(dir, cacheDir, datasets, areasFilter.empty() && allYears,
+                                     !cacheDir.empty(), known, errors);
+
+    std::vector<BethYw::InputFileSource> kept;
+    for (std::size_t i = 0; i < datasets.size(); i++) {
+        auto const& manifest = manifests[i];
+        bool wanted = !known[i]
+                      || (anyWanted(manifest.measures, measuresFilter)
+                          && (!manifest.scanned || anyWanted(manifest.areas, areasFilter))
+                          && (!manifest.scanned || allYears
+                              || (manifest.rows > 0 && manifest.lastYear >= yearStart
+                                  && manifest.firstYear <= yearEnd)));
+        if (wanted)
+            kept.push_back(datasets[i]);
+    }
+    return kept;
+}
@@ -0,0 +1,78 @@
+#ifndef MEASUREINDEX_H_
+#define MEASUREINDEX_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for the measure index, a manifest of
+  each dataset file, so that with a measures (-m), areas (-a) or years (-y)
+  filter only the datasets that can have a reading left after it are
+  imported.
+
+  A dataset is imported once with no filters to find its measures, areas,
+  first and last years and number of readings, and what was found is kept
+  in a small file in the cache directory (--cache, INDEX_FILE), one line per
+  dataset file:
+
+    datasets/popu1009.json<TAB>size<TAB>modified time<TAB>1991<TAB>2019<TAB>rows<TAB>W06000001,...<TAB>area,dens,pop
+
+  The import goes through the dataset's snapshot in the same directory (see
+  snapshot.h), so the import that follows doesn't parse the file again. A
+  line is only used while the size and modified time of the file still
+  match, so a replaced dataset is read again. The index is also kept in
+  memory, so a process only reads the file again if another one changed it.
+
+  Without a cache directory, no dataset is read just to find its manifest,
+  as it would then be parsed twice on every run: only a measures filter can
+  leave datasets out, using the SINGLE_MEASURE_CODE in datasets.h of those
+  with a single measure.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+#include "datasets.h"
+
+namespace BethYw {
+
+const std::string INDEX_FILE = ".bethyw-measures";
+
+/*
+  What is in one dataset file. If it hasn't been scanned (a single-measure
+  dataset when only its measures were needed), only the measures are set.
+*/
+struct DatasetManifest {
+  bool scanned = false;
+  std::set<std::string> measures;
+  std::set<std::string> areas;
+  unsigned int firstYear = 0;
+  unsigned int lastYear = 0;
+  unsigned long long rows = 0;
+};
+
+DatasetManifest datasetManifest(const std::string& dir,
+                                const InputFileSource& dataset,
+                                const std::string& cacheDir = "") noexcept(false);
+std::set<std::string> datasetMeasures(const std::string& dir,
+                                      const InputFileSource& dataset,
+                                      const std::string& cacheDir = "") noexcept(false);
+std::vector<InputFileSource> datasetsWithMeasures(const std::string& dir,
+                                                  const std::vector<InputFileSource>& datasets,
+                                                  const StringFilterSet& measuresFilter,
+                                                  const std::string& cacheDir = "");
+std::vector<InputFileSource> datasetsMatching(const std::string& dir,
+                                              const std::vector<InputFileSource>& datasets,
+                                              const StringFilterSet& areasFilter,
+                                              const StringFilterSet& measuresFilter,
+                                              const YearFilterTuple& yearsFilter,
+                                              const std::string& cacheDir = "");
+
+} // namespace BethYw
+
+#endif // MEASUREINDEX_H_
@@ -0,0 +1,833 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the output helpers. See the header
+  file for additional comments.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "output.h"
+
+namespace {
+
+/*
+  The shortest decimal digits of a double, by Grisu2 (Loitsch, "Printing
+  Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010),
+  the same algorithm and cached powers of ten lib_json.hpp dumps numbers
+  with, so the JSON written here is the same as the library's. Kept here so
+  the output doesn't depend on the library's internals.
+*/
+
+// a number f * 2^e, with a 64-bit significand
+struct DiyFp {
+    std::uint64_t f;
+    int e;
+};
+
+// an approximation f * 2^e of 10^k
+struct CachedPower {
+    std::uint64_t f;
+    int e;
+    int k;
+};
+
+const int GRISU_ALPHA = -60;
+
+// 10^-300, 10^-292, ... 10^324
+const CachedPower CACHED_POWERS[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C,  -980, -276},
+    {0xD3515C2831559A83,  -954, -268},
+    {0x9D71AC8FADA6C9B5,  -927, -260},
+    {0xEA9C227723EE8BCB,  -901, -252},
+    {0xAECC49914078536D,  -874, -244},
+    {0x823C12795DB6CE57,  -847, -236},
+    {0xC21094364DFB5637,  -821, -228},
+    {0x9096EA6F3848984F,  -794, -220},
+    {0xD77485CB25823AC7,  -768, -212},
+    {0xA086CFCD97BF97F4,  -741, -204},
+    {0xEF340A98172AACE5,  -715, -196},
+    {0xB23867FB2A35B28E,  -688, -188},
+    {0x84C8D4DFD2C63F3B,  -661, -180},
+    {0xC5DD44271AD3CDBA,  -635, -172},
+    {0x936B9FCEBB25C996,  -608, -164},
+    {0xDBAC6C247D62A584,  -582, -156},
+    {0xA3AB66580D5FDAF6,  -555, -148},
+    {0xF3E2F893DEC3F126,  -529, -140},
+    {0xB5B5ADA8AAFF80B8,  -502, -132},
+    {0x87625F056C7C4A8B,  -475, -124},
+    {0xC9BCFF6034C13053,  -449, -116},
+    {0x964E858C91BA2655,  -422, -108},
+    {0xDFF9772470297EBD,  -396, -100},
+    {0xA6DFBD9FB8E5B88F,  -369,  -92},
+    {0xF8A95FCF88747D94,  -343,  -84},
+    {0xB94470938FA89BCF,  -316,  -76},
+    {0x8A08F0F8BF0F156B,  -289,  -68},
+    {0xCDB02555653131B6,  -263,  -60},
+    {0x993FE2C6D07B7FAC,  -236,  -52},
+    {0xE45C10C42A2B3B06,  -210,  -44},
+    {0xAA242499697392D3,  -183,  -36},
+    {0xFD87B5F28300CA0E,  -157,  -28},
+    {0xBCE5086492111AEB,  -130,  -20},
+    {0x8CBCCC096F5088CC,  -103,  -12},
+    {0xD1B71758E219652C,   -77,   -4},
+    {0x9C40000000000000,   -50,    4},
+    {0xE8D4A51000000000,   -24,   12},
+    {0xAD78EBC5AC620000,     3,   20},
+    {0x813F3978F8940984,    30,   28},
+    {0xC097CE7BC90715B3,    56,   36},
+    {0x8F7E32CE7BEA5C70,    83,   44},
+    {0xD5D238A4ABE98068,   109,   52},
+    {0x9F4F2726179A2245,   136,   60},
+    {0xED63A231D4C4FB27,   162,   68},
+    {0xB0DE65388CC8ADA8,   189,   76},
+    {0x83C7088E1AAB65DB,   216,   84},
+    {0xC45D1DF942711D9A,   242,   92},
+    {0x924D692CA61BE758,   269,  100},
+    {0xDA01EE641A708DEA,   295,  108},
+    {0xA26DA3999AEF774A,   322,  116},
+    {0xF209787BB47D6B85,   348,  124},
+    {0xB454E4A179DD1877,   375,  132},
+    {0x865B86925B9BC5C2,   402,  140},
+    {0xC83553C5C8965D3D,   428,  148},
+    {0x952AB45CFA97A0B3,   455,  156},
+    {0xDE469FBD99A05FE3,   481,  164},
+    {0xA59BC234DB398C25,   508,  172},
+    {0xF6C69A72A3989F5C,   534,  180},
+    {0xB7DCBF5354E9BECE,   561,  188},
+    {0x88FCF317F22241E2,   588,  196},
+    {0xCC20CE9BD35C78A5,   614,  204},
+    {0x98165AF37B2153DF,   641,  212},
+    {0xE2A0B5DC971F303A,   667,  220},
+    {0xA8D9D1535CE3B396,   694,  228},
+    {0xFB9B7CD9A4A7443C,   720,  236},
+    {0xBB764C4CA7A44410,   747,  244},
+    {0x8BAB8EEFB6409C1A,   774,  252},
+    {0xD01FEF10A657842C,   800,  260},
+    {0x9B10A4E5E9913129,   827,  268},
+    {0xE7109BFBA19C0C9D,   853,  276},
+    {0xAC2820D9623BF429,   880,  284},
+    {0x80444B5E7AA7CF85,   907,  292},
+    {0xBF21E44003ACDD2D,   933,  300},
+    {0x8E679C2F5E44FF8F,   960,  308},
+    {0xD433179D9C8CB841,   986,  316},
+    {0x9E19DB92B4E31BA9,  1013,  324},
+};
+
+/*
+  x * y, rounded to the upper 64 bits of the significand.
+*/
+DiyFp multiply(const DiyFp& x, const DiyFp& y) {
+    const std::uint64_t xLow = x.f & 0xFFFFFFFFu, xHigh = x.f >> 32;
+    const std::uint64_t yLow = y.f & 0xFFFFFFFFu, yHigh = y.f >> 32;
+    const std::uint64_t low = xLow * yLow;
+    const std::uint64_t middle1 = xLow * yHigh;
+    const std::uint64_t middle2 = xHigh * yLow;
+    const std::uint64_t high = xHigh * yHigh;
+
+    std::uint64_t carry = (low >> 32) + (middle1 & 0xFFFFFFFFu) + (middle2 & 0xFFFFFFFFu);
+    carry += std::uint64_t{1} << 31;
+    return {high + (middle1 >> 32) + (middle2 >> 32) + (carry >> 32), x.e + y.e + 64};
+}
+
+/*
+  x shifted left until the top bit of its significand is set.
+*/
+DiyFp normalise(DiyFp x) {
+    while((x.f >> 63) == 0) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/*
+  Step the last digit down while that brings the digits closer to the
+  double and keeps them inside its boundaries.
+*/
+void roundDigits(char* digits, int length, std::uint64_t distance, std::uint64_t delta,
+                 std::uint64_t rest, std::uint64_t tenK) {
+    while(rest < distance && delta - rest >= tenK
+          && (rest + tenK < distance || distance - rest > rest + tenK - distance)) {
+        digits[length - 1]--;
+        rest += tenK;
+    }
+}
+
+/*
+  Write the shortest digits of a finite double greater than 0, and the power
+  of ten they are multiplied by.
+*/
+void grisu2(double value, char* digits, int& length, int& exponent) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint64_t hiddenBit = std::uint64_t{1} << 52;
+    const std::uint64_t biased = bits >> 52;
+    const std::uint64_t fraction = bits & (hiddenBit - 1);
+
+    //the double, and the boundaries half way to its neighbours
+    const DiyFp v = biased == 0 ? DiyFp{fraction, 1 - 1075}
+                                : DiyFp{fraction + hiddenBit, static_cast<int>(biased) - 1075};
+    const bool lowerIsCloser = fraction == 0 && biased > 1;
+    const DiyFp plus = normalise(DiyFp{2 * v.f + 1, v.e - 1});
+    DiyFp minus = lowerIsCloser ? DiyFp{4 * v.f - 1, v.e - 2} : DiyFp{2 * v.f - 1, v.e - 1};
+    minus = DiyFp{minus.f << (minus.e - plus.e), plus.e};
+    const DiyFp w = normalise(v);
+
+    //scale by a cached power of ten so the exponent is between -60 and -32
+    const int f = GRISU_ALPHA - plus.e - 1;
+    const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+    const CachedPower& cached = CACHED_POWERS[(300 + k + 7) / 8];
+    const DiyFp c = {cached.f, cached.e};
+    const DiyFp scaled = multiply(w, c);
+    const DiyFp scaledMinus = multiply(minus, c);
+    const DiyFp scaledPlus = multiply(plus, c);
+    const DiyFp low = {scaledMinus.f + 1, scaledMinus.e};
+    const DiyFp high = {scaledPlus.f - 1, scaledPlus.e};
+    exponent = -cached.k;
+
+    //the digits of the integer part, then of the fraction, until they are
+    //inside the boundaries
+    std::uint64_t delta = high.f - low.f;
+    std::uint64_t distance = high.f - scaled.f;
+    const int shift = -high.e;
+    const std::uint64_t one = std::uint64_t{1} << shift;
+    auto integer = static_cast<std::uint32_t>(high.f >> shift);
+    std::uint64_t fractional = high.f & (one - 1);
+
+    std::uint32_t power = 1;
+    int n = 1;
+    while(n < 10 && integer >= power * 10) {
+        power *= 10;
+        n++;
+    }
+
+    length = 0;
+    while(n > 0) {
+        digits[length++] = static_cast<char>('0' + integer / power);
+        integer %= power;
+        n--;
+        const std::uint64_t rest = (std::uint64_t{integer} << shift) + fractional;
+        if(rest <= delta) {
+            exponent += n;
+            roundDigits(digits, length, distance, delta, rest, std::uint64_t{power} << shift);
+            return;
+        }
+        power /= 10;
+    }
+
+    int m = 0;
+    for(;;) {
+        fractional *= 10;
+        digits[length++] = static_cast<char>('0' + (fractional >> shift));
+        fractional &= one - 1;
+        m++;
+        delta *= 10;
+        distance *= 10;
+        if(fractional <= delta)
+            break;
+    }
+    exponent -= m;
+    roundDigits(digits, length, distance, delta, fractional, one);
+}
+
+} // namespace
+
+/*
+  Construct an OutputBuffer that writes to an already open C FILE.
+
+  @param file
+    The FILE to write to, e.g. stdout
+
+  @param capacity
+    The number of bytes collected before they are written to the FILE
+
+  @example
+    BethYw::OutputBuffer buffer(stdout);
+    std::ostream out(&buffer);
+    out << "Hello";
+*/
+BethYw::OutputBuffer::OutputBuffer(std::FILE* file, std::size_t capacity)
+    : file(file), buffer(capacity == 0 ? 1 : capacity) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+/*
+  Write anything left in the buffer to the FILE before it goes away.
+*/
+BethYw::OutputBuffer::~OutputBuffer() {
+    flushBuffer();
+    std::fflush(file);
+}
+
+/*
+  Write the used part of the buffer to the FILE and start filling it from
+  the beginning again.
+
+  @return
+    true if everything was written, false otherwise
+*/
+bool BethYw::OutputBuffer::flushBuffer() {
+    std::size_t used = pptr() - pbase();
+    if(used != 0 && std::fwrite(pbase(), 1, used, file) != used)
+        return false;
+
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return true;
+}
+
+/*
+  Called by std::streambuf when the buffer is full.
+
+  @param ch
+    The character that did not fit into the buffer
+
+  @return
+    Anything but traits_type::eof() when successful
+*/
+BethYw::OutputBuffer::int_type BethYw::OutputBuffer::overflow(int_type ch) {
+    if(!flushBuffer())
+        return traits_type::eof();
+
+    if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+/*
+  Write a block of characters. Blocks larger than the buffer skip it and go
+  to the FILE directly.
+
+  @param s
+    The characters to write
+
+  @param count
+    The number of characters to write
+
+  @return
+    The number of characters written
+*/
+std::streamsize BethYw::OutputBuffer::xsputn(const char* s, std::streamsize count) {
+    std::streamsize space = epptr() - pptr();
+    if(count <= space) {
+        traits_type::copy(pptr(), s, count);
+        pbump(static_cast<int>(count));
+        return count;
+    }
+
+    if(!flushBuffer())
+        return 0;
+
+    if(static_cast<std::size_t>(count) >= buffer.size())
+        return std::fwrite(s, 1, count, file);
+
+    traits_type::copy(pptr(), s, count);
+    pbump(static_cast<int>(count));
+    return count;
+}
+
+/*
+  Called when the stream is flushed (e.g. by std::flush or std::endl).
+
+  @return
+    0 when successful, -1 otherwise
+*/
+int BethYw::OutputBuffer::sync() {
+    if(!flushBuffer())
+        return -1;
+    return std::fflush(file) == 0 ? 0 : -1;
+}
+
+/*
+  Empty both rows, keeping the memory they have already grown to.
+
+  @example
+    BethYw::TableWriter table;
+    table.addColumn(1991, 711.6801);
+    ...
+    table.clear();
+*/
+void BethYw::TableWriter::clear() {
+    headings.clear();
+    values.clear();
+}
+
+/*
+  Add a column, with the heading right-aligned to the width of the already
+  formatted value. Each column in both rows is followed by a single space.
+
+  @param heading
+    The characters of the heading
+
+  @param headingLength
+    The number of characters in the heading
+
+  @param value
+    The characters of the value
+
+  @param valueLength
+    The number of characters in the value
+*/
+void BethYw::TableWriter::addColumn(const char* heading, std::size_t headingLength,
+                                   const char* value, std::size_t valueLength) {
+    if(headingLength < valueLength)
+        headings.append(valueLength - headingLength, ' ');
+    headings.append(heading, headingLength);
+    headings.push_back(' ');
+
+    values.append(value, valueLength);
+    values.push_back(' ');
+}
+
+/*
+  Add a column with a year as its heading, and the value formatted like
+  std::to_string(double).
+
+  @param heading
+    The year for the column
+
+  @param value
+    The value for the column
+
+  @example
+    BethYw::TableWriter table;
+    table.addColumn(1991, 711.6801);
+*/
+void BethYw::TableWriter::addColumn(unsigned int heading, double value) {
+    char year[16];
+    const char* yearEnd = formatUnsigned(year, heading);
+    char number[FIXED_BUFFER_SIZE];
+    const char* numberEnd = formatFixed(number, value);
+    addColumn(year, yearEnd - year, number, numberEnd - number);
+}
+
+/*
+  Add a column with a text heading, and the value formatted like
+  std::to_string(double).
+
+  @param heading
+    The heading for the column
+
+  @param value
+    The value for the column
+
+  @example
+    BethYw::TableWriter table;
+    table.addColumn("Average", 711.6801);
+*/
+void BethYw::TableWriter::addColumn(const std::string& heading, double value) {
+    char number[FIXED_BUFFER_SIZE];
+    const char* end = formatFixed(number, value);
+    addColumn(heading.data(), heading.size(), number, end - number);
+}
+
+/*
+  Add a column with a text heading and a whole number value, e.g. a year.
+
+  @param heading
+    The heading for the column
+
+  @param value
+    The value for the column
+
+  @example
+    BethYw::TableWriter table;
+    table.addColumn("Min. Year", 1991u);
+*/
+void BethYw::TableWriter::addColumn(const std::string& heading, unsigned int value) {
+    char number[16];
+    const char* end = formatUnsigned(number, value);
+    addColumn(heading.data(), heading.size(), number, end - number);
+}
+
+/*
+  Write both rows to an output stream, each followed by a new line.
+
+  @param os
+    The output stream to write to
+
+  @example
+    BethYw::TableWriter table;
+    table.addColumn(1991, 711.6801);
+    table.write(std::cout);
+    //    1991
+    // 711.680100
+*/
+void BethYw::TableWriter::write(std::ostream& os) const {
+    os.write(headings.data(), headings.size());
+    os.put('\n');
+    os.write(values.data(), values.size());
+    os.put('\n');
+}
+
+/*
+  Format a double with six decimal places, giving exactly the same characters
+  as std::to_string(double) (i.e. printf's "%f") but without allocating a
+  std::string. Values of the size found in our datasets are formatted with
+  integer arithmetic, anything else (or anything too close to a rounding
+  boundary to be sure) falls back to std::snprintf.
+
+  @param first
+    The start of a buffer of at least FIXED_BUFFER_SIZE characters
+
+  @param value
+    The value to format
+
+  @return
+    A pointer one past the last character written (no '\0' is written)
+
+  @example
+    char buffer[BethYw::FIXED_BUFFER_SIZE];
+    char* end = BethYw::formatFixed(buffer, 711.6801); // "711.680100"
+*/
+char* BethYw::formatFixed(char* first, double value) {
+    //below 2^45 the error in scaling is far smaller than our 1/64 margin
+    const double scaled = std::fabs(value) * 1e6;
+    if(scaled < 35184372088832.0) {
+        double whole = std::floor(scaled);
+        double fraction = scaled - whole;
+
+        if(std::fabs(fraction - 0.5) > 1.0 / 64) {
+            unsigned long long micros = static_cast<unsigned long long>(whole) + (fraction > 0.5 ? 1 : 0);
+
+            if(std::signbit(value))
+                *first++ = '-';
+
+            //digits come out backwards, so write them to a scratch buffer first
+            char digits[24];
+            char* digit = digits + sizeof(digits);
+            for(int i = 0; i < 6; i++) {
+                *--digit = static_cast<char>('0' + micros % 10);
+                micros /= 10;
+            }
+            *--digit = '.';
+            do {
+                *--digit = static_cast<char>('0' + micros % 10);
+                micros /= 10;
+            } while(micros != 0);
+
+            std::size_t length = digits + sizeof(digits) - digit;
+            std::memcpy(first, digit, length);
+            return first + length;
+        }
+    }
+
+    int length = std::snprintf(first, FIXED_BUFFER_SIZE, "%f", value);
+    return first + (length < 0 ? 0 : length);
+}
+
+/*
+  Format an unsigned int, e.g. a year, in decimal.
+
+  @param first
+    The start of a buffer of at least 10 characters
+
+  @param value
+    The value to format
+
+  @return
+    A pointer one past the last character written (no '\0' is written)
+
+  @example
+    char buffer[16];
+    char* end = BethYw::formatUnsigned(buffer, 1991); // "1991"
+*/
+char* BethYw::formatUnsigned(char* first, unsigned int value) {
+    char digits[16];
+    char* digit = digits + sizeof(digits);
+    do {
+        *--digit = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+
+    std::size_t length = digits + sizeof(digits) - digit;
+    std::memcpy(first, digit, length);
+    return first + length;
+}
+
+/*
+  Format a finite double using the fewest digits that still read back as the
+  same double (found by grisu2() above), laid out the way lib_json.hpp dumps
+  numbers: plain decimals while the decimal point is from 4 places left of
+  the digits to 15 places right of the first, so whole numbers end in ".0",
+  and otherwise an exponent of at least two digits, e.g. "1e-05" or
+  "1.5e+20".
+
+  @param first
+    The start of a buffer of at least 64 characters
+
+  @param value
+    The value to format, which must not be NaN or infinite
+
+  @return
+    A pointer one past the last character written (no '\0' is written)
+
+  @example
+    char buffer[64];
+    char* end = BethYw::formatShortest(buffer, 711.6801); // "711.6801"
+*/
+char* BethYw::formatShortest(char* first, double value) {
+    if(std::signbit(value)) {
+        *first++ = '-';
+        value = -value;
+    }
+    if(value == 0) {
+        std::memcpy(first, "0.0", 3);
+        return first + 3;
+    }
+
+    char digits[20];
+    int length = 0;
+    int exponent = 0;
+    grisu2(value, digits, length, exponent);
+    //where the decimal point goes, counted from the start of the digits
+    int point = length + exponent;
+
+    if(length <= point && point <= 15) {
+        //digits, then zeros up to the point, then ".0"
+        std::memcpy(first, digits, length);
+        std::memset(first + length, '0', point - length);
+        std::memcpy(first + point, ".0", 2);
+        return first + point + 2;
+    }
+    if(0 < point && point <= 15) {
+        std::memcpy(first, digits, point);
+        first[point] = '.';
+        std::memcpy(first + point + 1, digits + point, length - point);
+        return first + length + 1;
+    }
+    if(-4 < point && point <= 0) {
+        std::memcpy(first, "0.", 2);
+        std::memset(first + 2, '0', -point);
+        std::memcpy(first + 2 - point, digits, length);
+        return first + 2 - point + length;
+    }
+
+    *first++ = digits[0];
+    if(length > 1) {
+        *first++ = '.';
+        std::memcpy(first, digits + 1, length - 1);
+        first += length - 1;
+    }
+    *first++ = 'e';
+    *first++ = point - 1 < 0 ? '-' : '+';
+    int magnitude = point - 1 < 0 ? 1 - point : point - 1;
+    if(magnitude < 10)
+        *first++ = '0';
+    return formatUnsigned(first, static_cast<unsigned int>(magnitude));
+}
+
+/*
+  Write a single text field for CSV/TSV output. The field is only quoted
+  (with any quotes inside doubled) when it contains the delimiter, a quote or
+  a new line.
+
+  @param os
+    The output stream to write to
+
+  @param value
+    The text to write
+
+  @param delimiter
+    The character between fields, e.g. ',' or '\t'
+
+  @example
+    BethYw::writeCSVField(std::cout, "Wales, total", ','); // "Wales, total"
+*/
+void BethYw::writeCSVField(std::ostream& os, const std::string& value, char delimiter) {
+    const char special[] = {delimiter, '"', '\n', '\r'};
+    if(value.find_first_of(special, 0, sizeof(special)) == std::string::npos) {
+        os.write(value.data(), value.size());
+        return;
+    }
+
+    os.put('"');
+    for(char ch : value) {
+        if(ch == '"')
+            os.put('"');
+        os.put(ch);
+    }
+    os.put('"');
+}
+
+/*
+  Write a single number field for CSV/TSV output, in its shortest round-trip
+  form. NaN and infinity are written as an empty field.
+
+  @param os
+    The output stream to write to
+
+  @param value
+    The number to write
+
+  @example
+    BethYw::writeCSVNumber(std::cout, 711.6801); // 711.6801
+*/
+void BethYw::writeCSVNumber(std::ostream& os, double value) {
+    if(!std::isfinite(value))
+        return;
+
+    char number[64];
+    char* end = formatShortest(number, value);
+    os.write(number, end - number);
+}
+
+/*
+  Write a std::string as a quoted JSON string, escaping it in the same way as
+  lib_json.hpp does when dumping (non-ASCII UTF-8 is passed through as is).
+
+  @param os
+    The output stream to write to
+
+  @param value
+    The string to write
+
+  @example
+    BethYw::writeJSONString(std::cout, "Ynys Môn"); // "Ynys Môn"
+*/
+void BethYw::writeJSONString(std::ostream& os, const std::string& value) {
+    os.put('"');
+
+    //write runs of characters that don't need escaping in one go
+    std::size_t start = 0;
+    for(std::size_t i = 0; i < value.size(); i++) {
+        const auto ch = static_cast<unsigned char>(value[i]);
+        if(ch > 0x1F && ch != '"' && ch != '\\')
+            continue;
+
+        os.write(value.data() + start, i - start);
+        start = i + 1;
+
+        switch(ch) {
+            case '"':  os.write("\\\"", 2); break;
+            case '\\': os.write("\\\\", 2); break;
+            case '\b': os.write("\\b", 2);  break;
+            case '\t': os.write("\\t", 2);  break;
+            case '\n': os.write("\\n", 2);  break;
+            case '\f': os.write("\\f", 2);  break;
+            case '\r': os.write("\\r", 2);  break;
+            default: {
+                char escaped[7];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+                os.write(escaped, 6);
+            }
+        }
+    }
+    os.write(value.data() + start, value.size() - start);
+
+    os.put('"');
+}
+
+/*
+  Write a double as a JSON number, using the shortest representation that
+  round-trips (the same Grisu2 formatting as lib_json.hpp). NaN and infinity
+  are written as null.
+
+  @param os
+    The output stream to write to
+
+  @param value
+    The number to write
+
+  @example
+    BethYw::writeJSONNumber(std::cout, 711.6801); // 711.6801
+    BethYw::writeJSONNumber(std::cout, 68592);    // 68592.0
+*/
+void BethYw::writeJSONNumber(std::ostream& os, double value) {
+    if(!std::isfinite(value)) {
+        os.write("null", 4);
+        return;
+    }
+
+    char number[64];
+    char* end = formatShortest(number, value);
+    os.write(number, end - number);
+}
+
+/*
+  Write a Statistics struct as a JSON object, with its keys in alphabetical
+  order like every other object dumped by lib_json.hpp.
+
+  @param os
+    The output stream to write to
+
+  @param stats
+    The statistics to write
+
+  @example
+    Measure measure("pop", "Population");
+    ...
+    BethYw::writeJSONStatistics(std::cout, measure.getStatistics());
+*/
+void BethYw::writeJSONStatistics(std::ostream& os, const Statistics& stats) {
+    os << "{\"count\":" << stats.count;
+    os << ",\"growthRate\":";
+    writeJSONNumber(os, stats.growthRate);
+    os << ",\"lowerQuartile\":";
+    writeJSONNumber(os, stats.lowerQuartile);
+    os << ",\"maximumYear\":" << stats.maximumYear;
+    os << ",\"mean\":";
+    writeJSONNumber(os, stats.mean);
+    os << ",\"median\":";
+    writeJSONNumber(os, stats.median);
+    os << ",\"minimumYear\":" << stats.minimumYear;
+    os << ",\"standardDeviation\":";
+    writeJSONNumber(os, stats.standardDeviation);
+    os << ",\"trend\":";
+    writeJSONNumber(os, stats.trend);
+    os << ",\"upperQuartile\":";
+    writeJSONNumber(os, stats.upperQuartile);
+    os.put('}');
+}
+
+/*
+  The index of the stream's iword() slot used to remember withStatistics.
+*/
+static int statisticsIndex() {
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+/*
+  A stream manipulator that asks Measure's operator<< and the toJSON()
+  functions to include the extended statistics (see statistics.h).
+
+  @param os
+    The output stream to change
+
+  @return
+    The output stream
+
+  @example
+    std::cout << BethYw::withStatistics << areas;
+*/
+std::ostream& BethYw::withStatistics(std::ostream& os) {
+    os.iword(statisticsIndex()) = 1;
+    return os;
+}
+
+/*
+  Check whether withStatistics has been set on a stream.
+
+  @param os
+    The output stream to check
+
+  @return
+    true if the extended statistics should be written
+*/
+bool BethYw::showStatistics(std::ostream& os) {
+    return os.iword(statisticsIndex()) != 0;
+}
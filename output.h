@@ -0,0 +1,119 @@
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains declarations for the output helpers. Where input.h deals
+  with where data comes from, this file deals with where it goes to.
+
+  OutputBuffer is a std::streambuf that collects output in one large block of
+  memory and hands it to a C FILE in big chunks, so that Areas, Area and
+  Measure can write straight to a std::ostream without every small piece
+  going through the terminal.
+
+  TableWriter builds the two rows of a Measure's table (the headings and the
+  values) in reusable strings, right-aligning each heading to the width of its
+  formatted value, so the whole table can be written in one go.
+
+  The CSV helpers write single fields of comma (or tab) separated output,
+  quoting text only when it needs it.
+
+  The JSON helpers write single values in exactly the same form as the JSON
+  library (lib_json.hpp) would dump them, which lets the toJSON() functions
+  stream their output without first building a json object.
+ */
+
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "statistics.h"
+
+namespace BethYw {
+
+/*
+  A buffered std::streambuf over a C FILE (e.g. stdout). Output is only
+  written to the FILE when the buffer is full, when the stream is flushed, or
+  when the OutputBuffer is destroyed.
+*/
+class OutputBuffer : public std::streambuf {
+private:
+    //where the buffer is written to when it is full or flushed
+    std::FILE* file;
+
+    //memory used to collect the output
+    std::vector<char> buffer;
+
+    bool flushBuffer();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize count) override;
+    int sync() override;
+
+public:
+    /*----Constructors----*/
+    OutputBuffer(std::FILE* file, std::size_t capacity = 1 << 16);
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    ~OutputBuffer();
+};
+
+/*
+  The size of buffer formatFixed() may need, enough for "%f" of any double.
+*/
+constexpr std::size_t FIXED_BUFFER_SIZE = 512;
+
+/*
+  Two rows of right-aligned table columns: a row of headings and a row of
+  values. Each value is formatted once, and its length is used as the width
+  its heading is padded to. Clearing a TableWriter keeps its memory, so one
+  instance can be reused for every table that is printed.
+*/
+class TableWriter {
+private:
+    //the headings row, padded to the width of each value
+    std::string headings;
+
+    //the values row
+    std::string values;
+
+    void addColumn(const char* heading, std::size_t headingLength, const char* value, std::size_t valueLength);
+
+public:
+    /*----Miscellaneous----*/
+    void clear();
+    void addColumn(unsigned int heading, double value);
+    void addColumn(const std::string& heading, double value);
+    void addColumn(const std::string& heading, unsigned int value);
+    void write(std::ostream& os) const;
+};
+
+/*----Formatting----*/
+char* formatFixed(char* first, double value);
+char* formatUnsigned(char* first, unsigned int value);
+char* formatShortest(char* first, double value);
+
+/*----CSV----*/
+void writeCSVField(std::ostream& os, const std::string& value, char delimiter);
+void writeCSVNumber(std::ostream& os, double value);
+
+/*----JSON----*/
+void writeJSONString(std::ostream& os, const std::string& value);
+void writeJSONNumber(std::ostream& os, double value);
+void writeJSONStatistics(std::ostream& os, const Statistics& stats);
+
+/*----Stream Options----*/
+std::ostream& withStatistics(std::ostream& os);
+bool showStatistics(std::ostream& os);
+
+} // namespace BethYw
+
+#endif // OUTPUT_H_
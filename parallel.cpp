@@ -0,0 +1,78 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the thread pool. See the header
+  file for additional comments.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+/*
+  Run task(0) to task(count - 1), each once, spread over a pool of threads.
+  Each thread takes the next index that hasn't been started yet, so a slow
+  task doesn't hold up the others, and the calling thread does its share
+  too. If a task throws, the tasks not yet started are skipped and the first
+  exception is thrown again once every thread has finished.
+
+  @param count
+    The number of tasks
+
+  @param task
+    The task to run, given its index
+
+  @param threads
+    The most threads to use (including the calling thread), or 0 for one per
+    hardware thread
+
+  @throws
+    Whatever the first task to throw threw
+
+  @example
+    std::vector<double> results(10);
+    BethYw::parallelFor(10, [&results](std::size_t i) {
+      results[i] = i * i;
+    });
+*/
+void BethYw::parallelFor(std::size_t count,
+                         const std::function<void(std::size_t)>& task,
+                         unsigned int threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned int>(std::min<std::size_t>(threads, count));
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < count && !failed; i = next++) {
+            try {
+                task(i);
+            } catch (...) {
+                if (!failed.exchange(true))
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; i++)
+        pool.emplace_back(worker);
+    if (threads > 0)
+        worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
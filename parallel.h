@@ -0,0 +1,30 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declaration of the small thread pool used to share
+  independent pieces of work (datasets to import, blocks of a correlation
+  matrix) between threads.
+ */
+
+#include <cstddef>
+#include <functional>
+
+namespace BethYw {
+
+/*
+  Run task(0) to task(count - 1), each once, spread over a pool of threads.
+*/
+void parallelFor(std::size_t count,
+                 const std::function<void(std::size_t)>& task,
+                 unsigned int threads = 0);
+
+} // namespace BethYw
+
+#endif // PARALLEL_H_
@@ -0,0 +1,870 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of queries. See the header file for
+  additional comments.
+
+  A query is split into tokens and then parsed by recursive descent, one
+  function per clause, into columns, conditions, orders and a limit. plan()
+  then moves every condition the filters can express into the Selection and
+  keeps the rest to be checked on each row.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "bethyw.h"
+#include "output.h"
+#include "query.h"
+
+namespace {
+
+struct Token {
+  enum Type { WORD, NUMBER, STRING, SYMBOL, END };
+
+  Type type;
+  std::string text;
+  double number;
+};
+
+std::invalid_argument invalidQuery(const std::string& reason, const Token& token) {
+    if (token.type == Token::END)
+        return std::invalid_argument("Invalid query: " + reason + " at the end");
+    return std::invalid_argument("Invalid query: " + reason + " near '" + token.text + "'");
+}
+
+bool isWordStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.';
+}
+
+/*
+  Split a query into words (which may contain - and ., for dataset codes like
+  complete-pop), numbers, quoted strings and symbols.
+*/
+std::vector<Token> tokenise(const std::string& text) {
+    std::vector<Token> tokens;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pos++;
+            continue;
+        }
+
+        Token token;
+        token.number = 0;
+        std::size_t start = pos;
+        bool numberStart = std::isdigit(static_cast<unsigned char>(c))
+                           || ((c == '-' || c == '.') && pos + 1 < text.size()
+                               && (std::isdigit(static_cast<unsigned char>(text[pos + 1])) || text[pos + 1] == '.'));
+
+        if (isWordStart(c)) {
+            while (pos < text.size() && isWordChar(text[pos]))
+                pos++;
+            token.type = Token::WORD;
+            token.text = text.substr(start, pos - start);
+        } else if (numberStart) {
+            char* end = nullptr;
+            token.number = std::strtod(text.c_str() + pos, &end);
+            pos = end - text.c_str();
+            token.type = Token::NUMBER;
+            token.text = text.substr(start, pos - start);
+        } else if (c == '\'' || c == '"') {
+            std::size_t close = text.find(c, pos + 1);
+            if (close == std::string::npos)
+                throw std::invalid_argument("Invalid query: unclosed quote");
+            token.type = Token::STRING;
+            token.text = text.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+        } else {
+            std::string two = text.substr(pos, 2);
+            token.type = Token::SYMBOL;
+            if (two == "<=" || two == ">=" || two == "!=" || two == "<>") {
+                token.text = two;
+                pos += 2;
+            } else if (std::string(",()*=<>").find(c) != std::string::npos) {
+                token.text = std::string(1, c);
+                pos++;
+            } else {
+                token.text = std::string(1, c);
+                throw invalidQuery("unexpected character", token);
+            }
+        }
+        tokens.push_back(token);
+    }
+
+    Token end;
+    end.type = Token::END;
+    end.number = 0;
+    tokens.push_back(end);
+    return tokens;
+}
+
+const char* columnName(BethYw::QueryColumn column) {
+    switch (column) {
+        case BethYw::QueryColumn::Area:    return "area";
+        case BethYw::QueryColumn::Name:    return "name";
+        case BethYw::QueryColumn::Measure: return "measure";
+        case BethYw::QueryColumn::Label:   return "label";
+        case BethYw::QueryColumn::Year:    return "year";
+        default:                           return "value";
+    }
+}
+
+bool isNumeric(BethYw::QueryColumn column) {
+    return column == BethYw::QueryColumn::Year || column == BethYw::QueryColumn::Value;
+}
+
+/*
+  The text of a row's cell, for the text columns.
+*/
+std::string textOf(const BethYw::QueryRow& row, BethYw::QueryColumn column) {
+    switch (column) {
+        case BethYw::QueryColumn::Area:    return row.area->getLocalAuthorityCode();
+        case BethYw::QueryColumn::Name:    return row.area->getDisplayName();
+        case BethYw::QueryColumn::Measure: return row.measure->getCodename();
+        default:                           return row.measure->getLabel();
+    }
+}
+
+double numberOf(const BethYw::QueryRow& row, BethYw::QueryColumn column) {
+    return column == BethYw::QueryColumn::Year ? row.year : row.value;
+}
+
+/*
+  A row's cell as it is printed in a table or CSV.
+*/
+std::string cellOf(const BethYw::QueryRow& row, BethYw::QueryColumn column) {
+    if (column == BethYw::QueryColumn::Year)
+        return std::to_string(row.year);
+    if (column == BethYw::QueryColumn::Value) {
+        char buffer[BethYw::FIXED_BUFFER_SIZE];
+        return std::string(buffer, BethYw::formatFixed(buffer, row.value));
+    }
+    return textOf(row, column);
+}
+
+/*
+  The recursive descent parser, which fills in the parts of a query as it
+  goes through the clauses.
+*/
+class Parser {
+private:
+    std::vector<Token> tokens;
+    std::size_t pos = 0;
+
+public:
+    explicit Parser(const std::string& text) : tokens(tokenise(text)) {}
+
+    const Token& current() const {
+        return tokens[pos];
+    }
+
+    bool keyword(const char* word) {
+        if (current().type != Token::WORD || !BethYw::insensitiveEquals(current().text, word))
+            return false;
+        pos++;
+        return true;
+    }
+
+    void expectKeyword(const char* word) {
+        if (!keyword(word)) {
+            std::string upper = word;
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            throw invalidQuery("expected " + upper, current());
+        }
+    }
+
+    bool symbol(const char* text) {
+        if (current().type != Token::SYMBOL || current().text != text)
+            return false;
+        pos++;
+        return true;
+    }
+
+    void expectSymbol(const char* text) {
+        if (!symbol(text))
+            throw invalidQuery(std::string("expected ") + text, current());
+    }
+
+    bool atEnd() const {
+        return current().type == Token::END;
+    }
+
+    BethYw::QueryColumn column() {
+        static const BethYw::QueryColumn all[] = {
+            BethYw::QueryColumn::Area, BethYw::QueryColumn::Name, BethYw::QueryColumn::Measure,
+            BethYw::QueryColumn::Label, BethYw::QueryColumn::Year, BethYw::QueryColumn::Value};
+        if (current().type == Token::WORD)
+            for (auto column : all)
+                if (keyword(columnName(column)))
+                    return column;
+        throw invalidQuery("expected a column (area, name, measure, label, year or value)", current());
+    }
+
+    std::string word() {
+        if (current().type != Token::WORD && current().type != Token::STRING)
+            throw invalidQuery("expected a name", current());
+        return tokens[pos++].text;
+    }
+
+    double number() {
+        if (current().type != Token::NUMBER)
+            throw invalidQuery("expected a number", current());
+        return tokens[pos++].number;
+    }
+
+    std::size_t count() {
+        const Token& token = current();
+        double value = number();
+        if (value < 0 || value != std::floor(value))
+            throw invalidQuery("expected a whole number", token);
+        return static_cast<std::size_t>(value);
+    }
+};
+
+} // namespace
+
+/*
+  Check whether a row passes the condition.
+*/
+bool BethYw::Query::Condition::matches(const QueryRow& row) const {
+    if (!isNumeric(column)) {
+        std::string value = textOf(row, column);
+        bool found = std::find(texts.begin(), texts.end(), value) != texts.end();
+        return op == NOT_EQUAL ? !found : found;
+    }
+
+    double value = numberOf(row, column);
+    switch (op) {
+        case EQUAL:         return value == numbers[0];
+        case NOT_EQUAL:     return value != numbers[0];
+        case LESS:          return value < numbers[0];
+        case LESS_EQUAL:    return value <= numbers[0];
+        case GREATER:       return value > numbers[0];
+        case GREATER_EQUAL: return value >= numbers[0];
+        default:            return std::find(numbers.begin(), numbers.end(), value) != numbers.end();
+    }
+}
+
+/*
+  Parse and plan a query.
+
+  @param text
+    The query, e.g. "SELECT area, value FROM popden WHERE year = 2015"
+
+  @throws
+    std::invalid_argument if the query is not valid, with a message starting
+    "Invalid query: " saying what was wrong and where, or if a dataset code
+    in FROM is not valid
+
+  @example
+    BethYw::Query query("SELECT * FROM popden WHERE value > 100 LIMIT 5");
+*/
+BethYw::Query::Query(const std::string& text) : text(text) {
+    Parser parser(text);
+    explain = parser.keyword("explain");
+    parser.expectKeyword("select");
+
+    if (parser.symbol("*")) {
+        columns = {QueryColumn::Area, QueryColumn::Name, QueryColumn::Measure,
+                   QueryColumn::Label, QueryColumn::Year, QueryColumn::Value};
+    } else {
+        do {
+            columns.push_back(parser.column());
+        } while (parser.symbol(","));
+    }
+
+    parser.expectKeyword("from");
+    std::vector<std::string> from;
+    do {
+        from.push_back(parser.word());
+    } while (parser.symbol(","));
+    selection.datasets = from;
+
+    std::vector<Condition> parsed;
+    if (parser.keyword("where")) {
+        do {
+            Condition condition;
+            const Token& start = parser.current();
+            condition.column = parser.column();
+            if (condition.column == QueryColumn::Name || condition.column == QueryColumn::Label)
+                throw invalidQuery("only area, measure, year and value can be used in WHERE", start);
+            bool numeric = isNumeric(condition.column);
+
+            auto literal = [&]() {
+                if (numeric)
+                    condition.numbers.push_back(parser.number());
+                else if (condition.column == QueryColumn::Measure)
+                    condition.texts.push_back(BethYw::convertToLower(parser.word()));
+                else
+                    condition.texts.push_back(parser.word());
+            };
+
+            const Token& opToken = parser.current();
+            if (parser.keyword("between")) {
+                if (!numeric)
+                    throw invalidQuery("BETWEEN needs a number column", opToken);
+                Condition upper = condition;
+                condition.op = Condition::GREATER_EQUAL;
+                literal();
+                parser.expectKeyword("and");
+                upper.op = Condition::LESS_EQUAL;
+                upper.numbers.push_back(parser.number());
+                parsed.push_back(condition);
+                parsed.push_back(upper);
+                continue;
+            }
+
+            if (parser.keyword("in")) {
+                condition.op = Condition::IN;
+                parser.expectSymbol("(");
+                do {
+                    literal();
+                } while (parser.symbol(","));
+                parser.expectSymbol(")");
+            } else {
+                if (parser.symbol("="))
+                    condition.op = Condition::EQUAL;
+                else if (parser.symbol("!=") || parser.symbol("<>"))
+                    condition.op = Condition::NOT_EQUAL;
+                else if (numeric && parser.symbol("<"))
+                    condition.op = Condition::LESS;
+                else if (numeric && parser.symbol("<="))
+                    condition.op = Condition::LESS_EQUAL;
+                else if (numeric && parser.symbol(">"))
+                    condition.op = Condition::GREATER;
+                else if (numeric && parser.symbol(">="))
+                    condition.op = Condition::GREATER_EQUAL;
+                else
+                    throw invalidQuery("expected a comparison", opToken);
+                literal();
+            }
+            parsed.push_back(condition);
+        } while (parser.keyword("and"));
+    }
+
+    if (parser.keyword("order")) {
+        parser.expectKeyword("by");
+        do {
+            Order order;
+            order.column = parser.column();
+            order.descending = parser.keyword("desc");
+            if (!order.descending)
+                parser.keyword("asc");
+            orders.push_back(order);
+        } while (parser.symbol(","));
+    }
+
+    if (parser.keyword("limit")) {
+        limited = true;
+        limit = parser.count();
+    }
+
+    if (parser.keyword("format")) {
+        formatGiven = true;
+        if (parser.keyword("table"))
+            format = QueryFormat::Table;
+        else if (parser.keyword("json"))
+            format = QueryFormat::JSON;
+        else if (parser.keyword("csv"))
+            format = QueryFormat::CSV;
+        else if (parser.keyword("tsv"))
+            format = QueryFormat::TSV;
+        else
+            throw invalidQuery("expected TABLE, JSON, CSV or TSV", parser.current());
+    }
+
+    if (!parser.atEnd())
+        throw invalidQuery("unexpected text", parser.current());
+
+    plan(parsed);
+}
+
+/*
+  Split the conditions into the filters of the Selection (pushed down to the
+  parsers) and the conditions left to check on each row, and skip the
+  datasets that can't have a row. A condition on a year is pushed down as
+  the range of years it allows, and also kept if the range lets through years
+  it doesn't (!=, IN). Conditions that contradict each other (e.g. two
+  different areas) leave nothing to import at all.
+*/
+void BethYw::Query::plan(std::vector<Condition>& parsed) {
+    bool areasGiven = false, measuresGiven = false;
+    std::set<std::string> areas, measures;
+    //worked out in double, as a literal can be negative, fractional or too
+    //large for a year
+    double first = 0;
+    double last = std::numeric_limits<unsigned int>::max();
+
+    auto intersect = [](bool& given, std::set<std::string>& set, const std::vector<std::string>& values) {
+        std::set<std::string> allowed(values.begin(), values.end());
+        if (given) {
+            std::set<std::string> both;
+            std::set_intersection(set.begin(), set.end(), allowed.begin(), allowed.end(),
+                                  std::inserter(both, both.begin()));
+            allowed = both;
+        }
+        set = allowed;
+        given = true;
+    };
+
+    for (auto const& condition : parsed) {
+        bool pushed = condition.op == Condition::EQUAL || condition.op == Condition::IN;
+        if (condition.column == QueryColumn::Area && pushed) {
+            intersect(areasGiven, areas, condition.texts);
+            continue;
+        }
+        if (condition.column == QueryColumn::Measure && pushed) {
+            intersect(measuresGiven, measures, condition.texts);
+            continue;
+        }
+        if (condition.column != QueryColumn::Year) {
+            conditions.push_back(condition);
+            continue;
+        }
+
+        //a year is whole, so e.g. year > 2010.5 allows 2011 onwards
+        double value = condition.numbers[0];
+        switch (condition.op) {
+            case Condition::EQUAL:
+                first = std::max(first, std::ceil(value));
+                last = std::min(last, std::floor(value));
+                break;
+            case Condition::GREATER:
+                first = std::max(first, std::floor(value) + 1);
+                break;
+            case Condition::GREATER_EQUAL:
+                first = std::max(first, std::ceil(value));
+                break;
+            case Condition::LESS:
+                last = std::min(last, std::ceil(value) - 1);
+                break;
+            case Condition::LESS_EQUAL:
+                last = std::min(last, std::floor(value));
+                break;
+            case Condition::IN:
+                first = std::max(first, std::ceil(*std::min_element(condition.numbers.begin(), condition.numbers.end())));
+                last = std::min(last, std::floor(*std::max_element(condition.numbers.begin(), condition.numbers.end())));
+                conditions.push_back(condition);
+                break;
+            default:
+                conditions.push_back(condition);
+                break;
+        }
+    }
+
+    selection.areasFilter = StringFilterSet(areas.begin(), areas.end());
+    selection.measuresFilter = StringFilterSet(measures.begin(), measures.end());
+
+    //no year outside 1 to the largest unsigned int can be read, so a range
+    //that isn't inside it matches nothing; otherwise it fits in the filter
+    bool noYears = first > last || last < 1 || first > std::numeric_limits<unsigned int>::max();
+    if (!noYears && (first != 0 || last != std::numeric_limits<unsigned int>::max()))
+        selection.yearsFilter = YearFilterTuple(static_cast<unsigned int>(first),
+                                                static_cast<unsigned int>(last));
+    impossible = (areasGiven && areas.empty()) || (measuresGiven && measures.empty()) || noYears;
+
+    //a dataset of one measure the query doesn't want can be skipped
+    std::vector<std::string> datasets;
+    for (auto const& dataset : BethYw::findDatasets(selection.datasets)) {
+        auto single = dataset.COLS.find(BethYw::SINGLE_MEASURE_CODE);
+        if (measuresGiven && single != dataset.COLS.end()
+            && measures.find(BethYw::convertToLower(single->second)) == measures.end())
+            skipped.push_back(dataset.CODE);
+        else
+            datasets.push_back(dataset.CODE);
+    }
+    selection.datasets = datasets;
+    if (datasets.empty())
+        impossible = true;
+}
+
+/*
+  Retrieve the text the query was parsed from.
+
+  @return
+    The query as it was written
+*/
+const std::string& BethYw::Query::getText() const {
+    return text;
+}
+
+/*
+  Retrieve the datasets and filters the query needs imported: only the
+  datasets that weren't skipped, and only the areas, measures and years the
+  conditions allow.
+
+  @return
+    The Selection to import
+
+  @example
+    BethYw::Query query("SELECT * FROM popden WHERE year = 2015");
+    auto years = query.getSelection().yearsFilter; // (2015, 2015)
+*/
+const BethYw::Selection& BethYw::Query::getSelection() const {
+    return selection;
+}
+
+/*
+  Check whether the query started with EXPLAIN, so only the plan is printed.
+
+  @return
+    true if the query is to be explained rather than run
+*/
+bool BethYw::Query::isExplain() const {
+    return explain;
+}
+
+/*
+  Check whether the plan showed no row can match (e.g. area = 'A' AND
+  area = 'B'), in which case nothing needs importing at all.
+
+  @return
+    true if the query can't return any rows
+*/
+bool BethYw::Query::isEmpty() const {
+    return impossible;
+}
+
+/*
+  Check whether the query uses the name column, which is the only one that
+  needs the names in areas.csv to be imported.
+
+  @return
+    true if areas.csv is needed
+*/
+bool BethYw::Query::needsNames() const {
+    for (auto column : columns)
+        if (column == QueryColumn::Name)
+            return true;
+    for (auto const& order : orders)
+        if (order.column == QueryColumn::Name)
+            return true;
+    return false;
+}
+
+/*
+  Run the query on data imported with its Selection: go through every
+  reading, keep the rows that pass the conditions left after planning, then
+  sort and limit them. Without an ORDER BY, the rows are in order of area,
+  measure and year, and going through the readings stops as soon as there
+  are LIMIT rows.
+
+  @param data
+    The data, imported (or selected) with getSelection()
+
+  @return
+    The rows, which point into data
+
+  @example
+    BethYw::Query query("SELECT area, value FROM popden WHERE value > 1000");
+    ...
+    auto rows = query.execute(data);
+*/
+std::vector<BethYw::QueryRow> BethYw::Query::execute(const Areas& data) const {
+    std::vector<QueryRow> rows;
+    if (impossible || (limited && limit == 0))
+        return rows;
+
+    for (auto const& area : data.getAreas()) {
+        for (auto const& measure : area.second.getMeasures()) {
+            for (auto const& reading : measure.second.getReadings()) {
+                QueryRow row = {&area.second, &measure.second, reading.first, reading.second};
+                bool matches = true;
+                for (auto const& condition : conditions) {
+                    if (!condition.matches(row)) {
+                        matches = false;
+                        break;
+                    }
+                }
+                if (!matches)
+                    continue;
+
+                rows.push_back(row);
+                if (orders.empty() && limited && rows.size() == limit)
+                    return rows;
+            }
+        }
+    }
+
+    if (!orders.empty()) {
+        std::stable_sort(rows.begin(), rows.end(), [this](const QueryRow& a, const QueryRow& b) {
+            for (auto const& order : orders) {
+                int compare;
+                if (isNumeric(order.column)) {
+                    double x = numberOf(a, order.column), y = numberOf(b, order.column);
+                    compare = x < y ? -1 : (y < x ? 1 : 0);
+                } else {
+                    compare = textOf(a, order.column).compare(textOf(b, order.column));
+                }
+                if (compare != 0)
+                    return order.descending ? compare > 0 : compare < 0;
+            }
+            return false;
+        });
+        if (limited && rows.size() > limit)
+            rows.resize(limit);
+    }
+    return rows;
+}
+
+/*
+  Run the query on data imported with its Selection and write the result,
+  or write the plan if the query started with EXPLAIN.
+
+  @param data
+    The data, imported (or selected) with getSelection()
+
+  @param os
+    The stream to write to
+
+  @param defaultFormat
+    The format to use if the query has no FORMAT clause
+
+  @example
+    BethYw::Query query("SELECT * FROM popden LIMIT 5");
+    ...
+    query.run(data, std::cout);
+*/
+void BethYw::Query::run(const Areas& data, std::ostream& os, QueryFormat defaultFormat) const {
+    if (explain)
+        writePlan(os);
+    else
+        write(os, execute(data), formatGiven ? format : defaultFormat);
+}
+
+/*
+  Write the plan: which datasets are imported and which are skipped, the
+  filters pushed down to the parsers, and what is left to do on each row.
+
+  @param os
+    The stream to write to
+
+  @example
+    BethYw::Query query("EXPLAIN SELECT * FROM all WHERE measure = 'pop'");
+    query.writePlan(std::cout);
+*/
+void BethYw::Query::writePlan(std::ostream& os) const {
+    auto list = [](const std::vector<std::string>& values) {
+        std::string joined;
+        for (auto const& value : values)
+            joined += (joined.empty() ? "" : ", ") + value;
+        return joined.empty() ? std::string("none") : joined;
+    };
+    auto sorted = [&list](const StringFilterSet& filter) {
+        std::vector<std::string> values(filter.begin(), filter.end());
+        std::sort(values.begin(), values.end());
+        return values.empty() ? std::string("all") : list(values);
+    };
+
+    if (impossible) {
+        os << "import: nothing (no row can match)\n";
+        return;
+    }
+
+    os << "import: " << list(selection.datasets) << '\n'
+       << "skip: " << list(skipped) << '\n'
+       << "areas: " << sorted(selection.areasFilter) << '\n'
+       << "measures: " << sorted(selection.measuresFilter) << '\n'
+       << "years: ";
+    unsigned int first = std::get<0>(selection.yearsFilter);
+    unsigned int last = std::get<1>(selection.yearsFilter);
+    if (first == 0 && last == 0)
+        os << "all";
+    else if (last == std::numeric_limits<unsigned int>::max())
+        os << first << " onwards";
+    else if (first == 0)
+        os << "up to " << last;
+    else
+        os << first << '-' << last;
+
+    static const char* ops[] = {"=", "!=", "<", "<=", ">", ">=", "IN"};
+    std::vector<std::string> checks;
+    for (auto const& condition : conditions) {
+        std::string check = std::string(columnName(condition.column)) + " " + ops[condition.op] + " ";
+        std::vector<std::string> values = condition.texts;
+        for (double number : condition.numbers) {
+            std::ostringstream value;
+            value << std::setprecision(15) << number;
+            values.push_back(value.str());
+        }
+        check += condition.op == Condition::IN ? "(" + list(values) + ")" : values.front();
+        checks.push_back(check);
+    }
+    os << "\ncheck: " << list(checks) << '\n';
+
+    std::vector<std::string> order;
+    for (auto const& by : orders)
+        order.push_back(std::string(columnName(by.column)) + (by.descending ? " DESC" : " ASC"));
+    os << "order: " << (order.empty() ? std::string("area, measure, year") : list(order)) << '\n'
+       << "limit: " << (limited ? std::to_string(limit) : std::string("none")) << '\n';
+}
+
+/*
+  Write the rows of a query's result, with the query's columns, as a table
+  (one line per row under a line of headings), a JSON array of objects, or
+  CSV/TSV with a row of headings.
+
+  @param os
+    The stream to write to
+
+  @param rows
+    The rows, from execute()
+
+  @param format
+    The format to write them in
+
+  @example
+    BethYw::Query query("SELECT area, value FROM popden");
+    ...
+    query.write(std::cout, query.execute(data), BethYw::QueryFormat::CSV);
+*/
+void BethYw::Query::write(std::ostream& os, const std::vector<QueryRow>& rows, QueryFormat format) const {
+    if (format == QueryFormat::JSON) {
+        os.put('[');
+        for (std::size_t i = 0; i < rows.size(); i++) {
+            if (i > 0)
+                os.put(',');
+            for (std::size_t c = 0; c < columns.size(); c++) {
+                os.put(c == 0 ? '{' : ',');
+                BethYw::writeJSONString(os, columnName(columns[c]));
+                os.put(':');
+                if (columns[c] == QueryColumn::Year)
+                    os << rows[i].year;
+                else if (columns[c] == QueryColumn::Value)
+                    BethYw::writeJSONNumber(os, rows[i].value);
+                else
+                    BethYw::writeJSONString(os, textOf(rows[i], columns[c]));
+            }
+            os.put('}');
+        }
+        os << "]\n";
+        return;
+    }
+
+    if (format == QueryFormat::CSV || format == QueryFormat::TSV) {
+        char delimiter = format == QueryFormat::CSV ? ',' : '\t';
+        for (std::size_t c = 0; c < columns.size(); c++) {
+            if (c > 0)
+                os.put(delimiter);
+            os << columnName(columns[c]);
+        }
+        os.put('\n');
+        for (auto const& row : rows) {
+            for (std::size_t c = 0; c < columns.size(); c++) {
+                if (c > 0)
+                    os.put(delimiter);
+                if (columns[c] == QueryColumn::Year)
+                    os << row.year;
+                else if (columns[c] == QueryColumn::Value)
+                    BethYw::writeCSVNumber(os, row.value);
+                else
+                    BethYw::writeCSVField(os, textOf(row, columns[c]), delimiter);
+            }
+            os.put('\n');
+        }
+        return;
+    }
+
+    if (rows.empty()) {
+        os << "<no rows>\n";
+        return;
+    }
+
+    //text is left-aligned and numbers right-aligned, each to its widest cell
+    std::vector<std::vector<std::string>> cells(rows.size());
+    std::vector<std::size_t> widths;
+    for (auto column : columns)
+        widths.push_back(std::string(columnName(column)).size());
+    for (std::size_t r = 0; r < rows.size(); r++) {
+        for (std::size_t c = 0; c < columns.size(); c++) {
+            cells[r].push_back(cellOf(rows[r], columns[c]));
+            widths[c] = std::max(widths[c], cells[r][c].size());
+        }
+    }
+
+    auto writeCell = [&os](const std::string& cell, std::size_t width, bool right) {
+        if (right)
+            os << std::string(width - cell.size(), ' ') << cell << ' ';
+        else
+            os << cell << std::string(width - cell.size(), ' ') << ' ';
+    };
+    for (std::size_t c = 0; c < columns.size(); c++)
+        writeCell(columnName(columns[c]), widths[c], isNumeric(columns[c]));
+    os.put('\n');
+    for (auto const& row : cells) {
+        for (std::size_t c = 0; c < columns.size(); c++)
+            writeCell(row[c], widths[c], isNumeric(columns[c]));
+        os.put('\n');
+    }
+}
+
+/*
+  Check whether some text is a query (starts with SELECT or EXPLAIN) rather
+  than, e.g., a line of program arguments.
+
+  @param text
+    The text to check
+
+  @return
+    true if it looks like a query
+
+  @example
+    BethYw::isQuery("select * from popden"); // returns true
+    BethYw::isQuery("-d popden -j");         // returns false
+*/
+bool BethYw::isQuery(const std::string& text) {
+    std::size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+        return false;
+    std::size_t end = start;
+    while (end < text.size() && std::isalpha(static_cast<unsigned char>(text[end])))
+        end++;
+    std::string first = BethYw::convertToLower(text.substr(start, end - start));
+    return first == "select" || first == "explain";
+}
+
+/*
+  Parse, plan and run a query against the datasets in a Catalogue, importing
+  the ones it needs that aren't in memory yet (unless nothing can match).
+
+  @param catalogue
+    The datasets in memory
+
+  @param text
+    The query
+
+  @param os
+    The stream to write the result (or plan) to
+
+  @throws
+    std::invalid_argument if the query is not valid, or whatever
+    Catalogue::load() throws if a dataset couldn't be imported
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::runQuery(catalogue, "SELECT * FROM trains LIMIT 3", std::cout);
+*/
+void BethYw::runQuery(Catalogue& catalogue, const std::string& text, std::ostream& os) {
+    BethYw::Query query(text);
+    Areas data = Areas();
+    if (!query.isExplain() && !query.isEmpty())
+        data = catalogue.query(query.getSelection());
+    query.run(data, os);
+}
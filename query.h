@@ -0,0 +1,126 @@
+#ifndef QUERY_H_
+#define QUERY_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for queries written in a small SQL-like
+  language, over one row per (area, measure, year) reading:
+
+    SELECT area, year, value FROM popden
+    WHERE measure = 'pop' AND year BETWEEN 2010 AND 2019 AND value > 100000
+    ORDER BY value DESC LIMIT 10
+
+  Columns:    area, name, measure, label, year, value (or * for all of them)
+  FROM:       dataset codes, comma-separated (or all)
+  WHERE:      conditions joined by AND, each one of
+                column = != <> < <= > >= literal
+                column BETWEEN literal AND literal
+                column IN (literal, ...)
+              on area, measure (= != IN only), year or value
+  ORDER BY:   columns, each ASC (the default) or DESC
+  LIMIT:      the most rows to return
+  FORMAT:     TABLE (the default), JSON, CSV or TSV
+
+  Keywords are case insensitive. Text can be 'quoted' or "quoted", or left
+  bare if it is one word. Starting with EXPLAIN prints the plan instead.
+
+  The query is planned when it is parsed: conditions on area, measure and
+  year become the same filters as the -a, -m and -y arguments, so they are
+  applied by the parsers (or Areas::select() on data already loaded) and the
+  readings they rule out are never imported at all. Datasets that only have
+  one measure are skipped when the query rules that measure out. Only the
+  conditions left over (e.g. on value) are checked against each row.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+#include "catalogue.h"
+
+namespace BethYw {
+
+enum class QueryColumn { Area, Name, Measure, Label, Year, Value };
+
+enum class QueryFormat { Table, JSON, CSV, TSV };
+
+/*
+  One reading in the result of a query. The Area and Measure are pointed to
+  rather than copied, so a row is only valid while the Areas object the query
+  was run on is unchanged.
+*/
+struct QueryRow {
+  const Area* area;
+  const Measure* measure;
+  unsigned int year;
+  double value;
+};
+
+class Query {
+private:
+  struct Condition {
+    enum Op { EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL, IN };
+
+    QueryColumn column;
+    Op op;
+    std::vector<std::string> texts;
+    std::vector<double> numbers;
+
+    bool matches(const QueryRow& row) const;
+  };
+
+  struct Order {
+    QueryColumn column;
+    bool descending;
+  };
+
+  std::string text;
+  bool explain = false;
+  std::vector<QueryColumn> columns;
+  std::vector<Order> orders;
+  bool limited = false;
+  std::size_t limit = 0;
+  bool formatGiven = false;
+  QueryFormat format = QueryFormat::Table;
+
+  // the plan: the filters pushed down to the parsers, the datasets that
+  // can't be skipped, and the conditions left to check on each row
+  Selection selection;
+  std::vector<std::string> skipped;
+  std::vector<Condition> conditions;
+  bool impossible = false;
+
+  void plan(std::vector<Condition>& parsed);
+
+public:
+  /*----Constructor----*/
+  explicit Query(const std::string& text) noexcept(false);
+
+  /*----Getters----*/
+  const std::string& getText() const;
+  const Selection& getSelection() const;
+  bool isExplain() const;
+  bool isEmpty() const;
+  bool needsNames() const;
+
+  /*----Miscellaneous----*/
+  std::vector<QueryRow> execute(const Areas& data) const;
+  void run(const Areas& data, std::ostream& os, QueryFormat defaultFormat = QueryFormat::Table) const;
+  void writePlan(std::ostream& os) const;
+  void write(std::ostream& os, const std::vector<QueryRow>& rows, QueryFormat format) const;
+};
+
+/*----Helpers----*/
+bool isQuery(const std::string& text);
+void runQuery(Catalogue& catalogue, const std::string& text, std::ostream& os) noexcept(false);
+
+} // namespace BethYw
+
+#endif // QUERY_H_
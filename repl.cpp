@@ -0,0 +1,254 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of --repl mode. See the header file
+  for additional comments.
+
+  Every command that prints data is turned into the program arguments that
+  would print it (e.g. "rank top 5 dens 2015" becomes --top 5 --by dens
+  --year 2015) and handed to BethYw::writeOutput(), so the shell prints
+  exactly what the command line would.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bethyw.h"
+#include "query.h"
+#include "repl.h"
+#include "server.h"
+
+namespace {
+
+const char* HELP =
+    "Commands:\n"
+    "  filter [-d ..] [-a ..] [-m ..] [-y ..]  change the datasets and filters\n"
+    "  filter                                  print the datasets and filters\n"
+    "  filter reset                            select everything again\n"
+    "  show [arguments]                        print the data, e.g. show -j --stats\n"
+    "  rank top|bottom N MEASURE YEAR [-j]     print the N highest/lowest areas\n"
+    "  stats [-j]                              approximate statistics of each measure\n"
+    "  export FILE [arguments]                 write the data to a file (.json .ndjson\n"
+    "                                          .csv .tsv .arrow, or give the format)\n"
+    "  select ... | explain select ...         run a query, e.g. select * from popden\n"
+    "                                          where value > 1000 order by value desc\n"
+    "  help                                    print this\n"
+    "  quit                                    leave\n"
+    "Filter arguments given to show, rank, stats or export apply to it only.\n";
+
+/*
+  Join the values of a filter, sorted, or "all" if it is empty.
+*/
+std::string describeFilter(const StringFilterSet& filter) {
+    if (filter.empty())
+        return "all";
+    std::vector<std::string> values(filter.begin(), filter.end());
+    std::sort(values.begin(), values.end());
+    std::string joined;
+    for (auto const& value : values)
+        joined += (joined.empty() ? "" : ",") + value;
+    return joined;
+}
+
+/*
+  Print the datasets and filters of a Selection on one line.
+*/
+void describeSelection(std::ostream& os, const BethYw::Selection& selection) {
+    os << "datasets: ";
+    for (std::size_t i = 0; i < selection.datasets.size(); i++)
+        os << (i > 0 ? "," : "") << selection.datasets[i];
+    os << " | areas: " << describeFilter(selection.areasFilter)
+       << " | measures: " << describeFilter(selection.measuresFilter) << " | years: ";
+
+    unsigned int first = std::get<0>(selection.yearsFilter);
+    unsigned int last = std::get<1>(selection.yearsFilter);
+    if (first == 0 && last == 0)
+        os << "all";
+    else if (first == last)
+        os << first;
+    else
+        os << first << '-' << last;
+    os << '\n';
+}
+
+/*
+  Parse the arguments of a command, refusing the ones that only make sense
+  when starting the program.
+*/
+cxxopts::ParseResult parseCommandArguments(const std::vector<std::string>& arguments) {
+    auto args = BethYw::parseArguments(arguments);
+    if (args.count("dir") || args.count("serve") || args.count("repl") || args.count("help"))
+        throw std::invalid_argument("--dir, --serve, --repl and --help can't be used in a command");
+    return args;
+}
+
+/*
+  Print the data a command selects, in the form its arguments ask for.
+*/
+void output(BethYw::Catalogue& catalogue,
+            const BethYw::Selection& selection,
+            const std::vector<std::string>& arguments,
+            std::ostream& out) {
+    auto args = parseCommandArguments(arguments);
+    Areas data = catalogue.query(BethYw::parseSelection(args, selection), args.count("sketch") > 0);
+    BethYw::writeOutput(data, args, out);
+}
+
+/*
+  The format argument for a file name's extension, or an empty string.
+*/
+std::string formatForFile(const std::string& file) {
+    auto dot = file.rfind('.');
+    std::string extension = dot == std::string::npos ? "" : BethYw::convertToLower(file.substr(dot + 1));
+    for (auto format : {"json", "ndjson", "csv", "tsv", "arrow"})
+        if (extension == format)
+            return std::string("--") + format;
+    return "";
+}
+
+} // namespace
+
+/*
+  Run one command typed into the shell. An invalid command (or one that
+  fails, e.g. because a dataset can't be imported) prints one line starting
+  "Error: " and changes nothing.
+
+  @param catalogue
+    The datasets in memory, which any dataset the command needs is imported
+    into
+
+  @param selection
+    The current Selection, which the filter command changes
+
+  @param line
+    The command
+
+  @param out
+    The stream to print to
+
+  @return
+    false if the command was quit (or exit), true otherwise
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::Selection selection;
+    BethYw::runCommand(catalogue, selection, "filter -d popden -a W06000011", std::cout);
+    BethYw::runCommand(catalogue, selection, "show -j", std::cout);
+*/
+bool BethYw::runCommand(Catalogue& catalogue, Selection& selection, const std::string& line, std::ostream& out) {
+    try {
+        //a query is run as it is, whatever the current selection
+        if (BethYw::isQuery(line)) {
+            BethYw::runQuery(catalogue, line, out);
+            return true;
+        }
+
+        std::vector<std::string> words = BethYw::splitArguments(line);
+        if (words.empty())
+            return true;
+        std::string command = BethYw::convertToLower(words.front());
+        words.erase(words.begin());
+
+        if (command == "quit" || command == "exit") {
+            return false;
+        } else if (command == "help") {
+            out << HELP;
+        } else if (command == "filter") {
+            if (words.size() == 1 && BethYw::insensitiveEquals(words.front(), "reset")) {
+                selection = Selection();
+            } else if (!words.empty()) {
+                auto args = parseCommandArguments(words);
+                selection = BethYw::parseSelection(args, selection);
+            }
+            describeSelection(out, selection);
+        } else if (command == "show") {
+            output(catalogue, selection, words, out);
+        } else if (command == "rank") {
+            if (words.size() < 4 || (!BethYw::insensitiveEquals(words[0], "top")
+                                      && !BethYw::insensitiveEquals(words[0], "bottom")))
+                throw std::invalid_argument("Usage: rank top|bottom N MEASURE YEAR");
+            std::vector<std::string> arguments = {"--" + BethYw::convertToLower(words[0]), words[1],
+                                                  "--by", words[2], "--year", words[3]};
+            arguments.insert(arguments.end(), words.begin() + 4, words.end());
+            output(catalogue, selection, arguments, out);
+        } else if (command == "stats") {
+            words.insert(words.begin(), "--sketch");
+            output(catalogue, selection, words, out);
+        } else if (command == "export") {
+            if (words.empty())
+                throw std::invalid_argument("Usage: export FILE [arguments]");
+            std::string file = words.front();
+            words.erase(words.begin());
+
+            auto args = parseCommandArguments(words);
+            if (!args.count("json") && !args.count("ndjson") && !args.count("csv")
+                && !args.count("tsv") && !args.count("arrow")) {
+                std::string format = formatForFile(file);
+                if (!format.empty())
+                    words.push_back(format);
+            }
+
+            std::ofstream stream(file, std::ios::binary);
+            if (!stream)
+                throw std::runtime_error("Failed to open file " + file);
+            output(catalogue, selection, words, stream);
+            out << "Wrote " << file << '\n';
+        } else {
+            throw std::invalid_argument("Unknown command: " + command + " (try help)");
+        }
+    } catch (const std::exception& error) {
+        out << "Error: " << error.what() << '\n';
+    }
+    return true;
+}
+
+/*
+  Run the interactive shell: import the datasets of the starting Selection,
+  then run commands read one per line until quit or the end of the input.
+
+  @param catalogue
+    The datasets in memory
+
+  @param selection
+    The starting Selection (e.g. from the program arguments)
+
+  @param in
+    The stream to read commands from
+
+  @param out
+    The stream to print to (flushed after every command)
+
+  @param prompt
+    The stream to print the prompt to, or null for no prompt
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::runRepl(catalogue, BethYw::Selection(), std::cin, std::cout, &std::cerr);
+*/
+void BethYw::runRepl(Catalogue& catalogue,
+                     Selection selection,
+                     std::istream& in,
+                     std::ostream& out,
+                     std::ostream* prompt) {
+    try {
+        catalogue.load(BethYw::findDatasets(selection.datasets));
+    } catch (const std::exception& error) {
+        out << "Error: " << error.what() << '\n';
+    }
+
+    std::string line;
+    for (;;) {
+        if (prompt != nullptr)
+            *prompt << "bethyw> " << std::flush;
+        if (!std::getline(in, line) || !BethYw::runCommand(catalogue, selection, line, out))
+            break;
+        out.flush();
+    }
+}
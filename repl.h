@@ -0,0 +1,51 @@
+#ifndef REPL_H_
+#define REPL_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for --repl mode, an interactive shell
+  over a Catalogue. The shell keeps a current Selection (datasets and
+  filters), and each command works on it:
+
+    filter [-d ..] [-a ..] [-m ..] [-y ..]   change (or, alone, print) it
+    filter reset                             go back to everything
+    show [output arguments]                  print it, e.g. show -j --stats
+    rank top|bottom N MEASURE YEAR [-j]      print a ranking
+    stats [-j]                               approximate statistics of each
+                                             measure (see sketch.h)
+    export FILE [output arguments]           write it to a file, in the
+                                             format from the file extension
+                                             (.json .ndjson .csv .tsv .arrow)
+                                             unless one is given
+    select ...                               run a query (see query.h)
+    explain select ...                       print a query's plan
+    help                                     list the commands
+    quit                                     leave (as does end of input)
+
+  Commands that take arguments take the filter arguments too, which apply
+  to that command only. Datasets are imported the first time a command needs
+  them, and then kept.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "catalogue.h"
+
+namespace BethYw {
+
+bool runCommand(Catalogue& catalogue, Selection& selection, const std::string& line, std::ostream& out);
+void runRepl(Catalogue& catalogue,
+             Selection selection,
+             std::istream& in,
+             std::ostream& out,
+             std::ostream* prompt = nullptr);
+
+} // namespace BethYw
+
+#endif // REPL_H_
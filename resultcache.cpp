@@ -0,0 +1,267 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the ResultCache. See the header
+  file for additional comments.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "bethyw.h"
+#include "catalogue.h"
+#include "query.h"
+#include "resultcache.h"
+#include "server.h"
+
+/*
+  Construct an empty ResultCache.
+
+  @param budget
+    The most bytes of keys and answers to keep
+
+  @example
+    BethYw::ResultCache cache(64 * 1024 * 1024);
+*/
+BethYw::ResultCache::ResultCache(std::size_t budget) : budget(budget) {}
+
+/*
+  Get the most bytes of keys and answers the cache keeps.
+
+  @return
+    The budget, in bytes
+*/
+std::size_t BethYw::ResultCache::getBudget() const {
+    return budget;
+}
+
+/*
+  Get the bytes of keys and answers the cache is keeping now.
+
+  @return
+    The bytes used, never more than the budget
+*/
+std::size_t BethYw::ResultCache::getUsed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
+
+/*
+  Get the number of answers the cache is keeping now.
+
+  @return
+    The number of answers
+*/
+std::size_t BethYw::ResultCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+/*
+  Drop every answer if they were written from an older generation of the
+  Catalogue than the current one. The mutex must be held.
+*/
+void BethYw::ResultCache::clearIfOlder(std::uint64_t current) {
+    if (current > generation) {
+        entries.clear();
+        index.clear();
+        used = 0;
+        generation = current;
+    }
+}
+
+/*
+  Look up the answer to a query, and if it is there make it the most recently
+  used.
+
+  @param key
+    The key of the query (see resultKey())
+
+  @param current
+    The generation of the Catalogue now (see Catalogue::getGeneration())
+
+  @param answer
+    Where to put the answer if it is found
+
+  @return
+    true if the answer was found
+
+  @example
+    std::string answer;
+    if (cache.find(key, catalogue.getGeneration(), answer))
+      out << answer;
+*/
+bool BethYw::ResultCache::find(const std::string& key, std::uint64_t current, std::string& answer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    clearIfOlder(current);
+    if (current != generation)
+        return false;
+
+    auto it = index.find(key);
+    if (it == index.end())
+        return false;
+    entries.splice(entries.begin(), entries, it->second);
+    answer = it->second->answer;
+    return true;
+}
+
+/*
+  Keep the answer to a query as the most recently used, dropping the least
+  recently used answers until it fits in the budget. An answer that could
+  never fit, or one written from a generation of the Catalogue that has
+  already been replaced, isn't kept.
+
+  @param key
+    The key of the query (see resultKey())
+
+  @param current
+    The generation of the Catalogue the answer was written from, read before
+    the data was selected
+
+  @param answer
+    The bytes that were written for the query
+
+  @example
+    auto current = catalogue.getGeneration();
+    std::ostringstream answer;
+    ...
+    cache.insert(key, current, answer.str());
+*/
+void BethYw::ResultCache::insert(const std::string& key, std::uint64_t current, const std::string& answer) {
+    std::size_t bytes = key.size() + answer.size();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    clearIfOlder(current);
+    if (current != generation)
+        return;
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        used -= it->second->key.size() + it->second->answer.size();
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    if (bytes > budget)
+        return;
+
+    while (used + bytes > budget) {
+        used -= entries.back().key.size() + entries.back().answer.size();
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front({key, answer});
+    index[key] = entries.begin();
+    used += bytes;
+}
+
+/*
+  Drop every answer.
+
+  @example
+    cache.clear();
+*/
+void BethYw::ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    used = 0;
+}
+
+/*
+  Make the key a query's answer is kept by, so queries asking for the same
+  thing in different ways share one answer.
+
+  For program arguments, the datasets are written as the codes they match,
+  in order, the areas and measures are sorted, and the years are written as
+  numbers. Every other argument is written by its long name with its value,
+  sorted by name (an argument given more than once, like --derive, keeps the
+  order it was given in, as that can change the answer). So "-j -d popden"
+  and "--json --datasets=popden" have the same key.
+
+  For a query starting SELECT or EXPLAIN, runs of spaces outside quotes are
+  made one space.
+
+  @param query
+    The query, as one line of program arguments or a SELECT
+
+  @return
+    The key
+
+  @throws
+    std::invalid_argument or cxxopts::OptionException if the query isn't
+    valid (the error should be answered as normal, and not kept)
+
+  @example
+    BethYw::resultKey("-j -d popden") == BethYw::resultKey("--json -d popden")
+*/
+std::string BethYw::resultKey(const std::string& query) {
+    std::ostringstream key;
+
+    if (BethYw::isQuery(query)) {
+        key << "query:";
+        char quote = 0;
+        bool started = false;
+        bool space = false;
+        for (char c : query) {
+            if (quote == 0 && (c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+                space = true;
+                continue;
+            }
+            if (space && started)
+                key << ' ';
+            started = true;
+            space = false;
+            if (quote == 0 && (c == '\'' || c == '"'))
+                quote = c;
+            else if (c == quote)
+                quote = 0;
+            key << c;
+        }
+        return key.str();
+    }
+
+    auto args = BethYw::parseArguments(BethYw::splitArguments(query));
+    auto selection = BethYw::parseSelection(args);
+
+    key << "datasets:";
+    for (auto const& dataset : BethYw::findDatasets(selection.datasets))
+        key << dataset.CODE << ',';
+
+    std::vector<std::string> areas(selection.areasFilter.begin(), selection.areasFilter.end());
+    std::sort(areas.begin(), areas.end());
+    key << "\nareas:";
+    for (auto const& area : areas)
+        key << area << ',';
+
+    std::vector<std::string> measures(selection.measuresFilter.begin(), selection.measuresFilter.end());
+    std::sort(measures.begin(), measures.end());
+    key << "\nmeasures:";
+    for (auto const& measure : measures)
+        key << measure << ',';
+
+    key << "\nyears:" << std::get<0>(selection.yearsFilter) << '-' << std::get<1>(selection.yearsFilter);
+
+    std::vector<std::pair<std::string, std::string>> options;
+    for (auto const& option : args.arguments()) {
+        if (option.key() == "datasets" || option.key() == "areas"
+            || option.key() == "measures" || option.key() == "years")
+            continue;
+        options.emplace_back(option.key(), option.value());
+    }
+    std::stable_sort(options.begin(), options.end(),
+                     [](const std::pair<std::string, std::string>& a,
+                        const std::pair<std::string, std::string>& b) {
+                         return a.first < b.first;
+                     });
+    for (auto const& option : options)
+        key << '\n' << option.first << '=' << option.second;
+
+    return key.str();
+}
@@ -0,0 +1,78 @@
+#ifndef RESULTCACHE_H_
+#define RESULTCACHE_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declaration of the ResultCache, which keeps the
+  answers --serve has already written, so the same query asked again is
+  answered with the bytes written the first time instead of selecting and
+  writing the data again.
+
+  Answers are kept by a key made from the query with everything that doesn't
+  change the answer taken out (see resultKey()), so "-j -d popden" and
+  "--json --datasets popden" share one answer. When the cache would grow
+  past its budget, the answers used least recently are dropped first.
+
+  Each answer remembers the generation of the Catalogue it was written from
+  (see Catalogue::getGeneration()). When a dataset is imported again (e.g.
+  with --watch) the generation changes, and every answer from before it is
+  dropped the next time the cache is used.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace BethYw {
+
+class ResultCache {
+private:
+  struct Entry {
+    std::string key;
+    std::string answer;
+  };
+
+  // the most we keep, counting the keys and the answers
+  std::size_t budget;
+  std::size_t used = 0;
+
+  // the Catalogue generation every entry was written from
+  std::uint64_t generation = 0;
+
+  // most recently used first
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+  mutable std::mutex mutex;
+
+  void clearIfOlder(std::uint64_t current);
+
+public:
+  /*----Constructor----*/
+  explicit ResultCache(std::size_t budget);
+
+  /*----Getters----*/
+  std::size_t getBudget() const;
+  std::size_t getUsed() const;
+  std::size_t size() const;
+
+  /*----Miscellaneous----*/
+  bool find(const std::string& key, std::uint64_t current, std::string& answer);
+  void insert(const std::string& key, std::uint64_t current, const std::string& answer);
+  void clear();
+};
+
+/*----Keys----*/
+std::string resultKey(const std::string& query) noexcept(false);
+
+} // namespace BethYw
+
+#endif // RESULTCACHE_H_
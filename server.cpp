@@ -0,0 +1,370 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of --serve mode. See the header file
+  for additional comments.
+
+  The main thread accepts connections and puts them in a queue, and a pool of
+  worker threads takes them off it, so a slow query (or a slow client) only
+  holds up its own worker. Queries only read the Catalogue, apart from
+  importing a dataset the first time one asks for it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cctype>
+#include <csignal>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "bethyw.h"
+#include "query.h"
+#include "server.h"
+
+namespace {
+
+// the longest query line read from a client
+const std::size_t MAX_QUERY = 64 * 1024;
+
+// how long a client has to send its query line, and to take each part of
+// the answer, before its connection is dropped so its worker is free again
+const int CLIENT_TIMEOUT_SECONDS = 5;
+
+#ifndef _WIN32
+/*
+  Read one line (without the newline) from a socket, stopping at the end of
+  the stream or MAX_QUERY bytes. Returns false if the client sends nothing
+  for CLIENT_TIMEOUT_SECONDS in all, or the socket fails, before the end of
+  the line.
+*/
+bool readLine(int fd, std::string& line) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(CLIENT_TIMEOUT_SECONDS);
+    char buffer[4096];
+    line.clear();
+    while (line.size() < MAX_QUERY) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        pollfd wanted = {fd, POLLIN, 0};
+        int ready = left > 0 ? ::poll(&wanted, 1, static_cast<int>(left)) : 0;
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            return false;
+
+        ssize_t count = ::read(fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            return false;
+        if (count == 0)
+            break;
+        line.append(buffer, count);
+        auto newline = line.find('\n');
+        if (newline != std::string::npos) {
+            line.erase(newline);
+            break;
+        }
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+/*
+  Write all of a string to a socket, giving up if the client has gone (or
+  stopped reading: see serve()).
+*/
+void writeAll(int fd, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t count = ::write(fd, data.data() + written, data.size() - written);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return;
+        written += count;
+    }
+}
+#endif
+
+} // namespace
+
+/*
+  Split a query line into arguments at spaces, like a shell would: text in
+  single or double quotes is kept together (without the quotes), so an
+  argument can contain spaces, e.g. --derive "popden = pop / area".
+
+  @param line
+    The query line
+
+  @return
+    The arguments, in order
+
+  @throws
+    std::invalid_argument if a quote isn't closed, with the message:
+    Invalid query: unclosed quote
+
+  @example
+    auto args = BethYw::splitArguments("-d popden --derive 'x = pop * 2'");
+    // returns {"-d", "popden", "--derive", "x = pop * 2"}
+*/
+std::vector<std::string> BethYw::splitArguments(const std::string& line) {
+    std::vector<std::string> arguments;
+    std::string argument;
+    bool inArgument = false;
+    char quote = 0;
+
+    for (char c : line) {
+        if (quote != 0) {
+            if (c == quote)
+                quote = 0;
+            else
+                argument += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inArgument = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inArgument)
+                arguments.push_back(argument);
+            argument.clear();
+            inArgument = false;
+        } else {
+            argument += c;
+            inArgument = true;
+        }
+    }
+
+    if (quote != 0)
+        throw std::invalid_argument("Invalid query: unclosed quote");
+    if (inArgument)
+        arguments.push_back(argument);
+    return arguments;
+}
+
+/*
+  Answer one query: parse it as program arguments, import any dataset it
+  needs that isn't in memory yet, select the data from the Catalogue and
+  write it in the format asked for, exactly as run() would have. The --dir,
+  --serve, --repl and --help arguments aren't allowed in a query. A query
+  starting SELECT or EXPLAIN is run as a query instead (see query.h). If the
+  query is invalid, one line starting "Error: " is written instead.
+
+  With a ResultCache, an answer kept from the same query (see resultKey())
+  is written instead if the data hasn't been imported again since, and a
+  new answer is kept. Errors are never kept.
+
+  @param catalogue
+    The datasets in memory
+
+  @param query
+    The query, as one line of program arguments or a SELECT
+
+  @param out
+    The stream to write the answer to
+
+  @param cache
+    The answers already written, or nullptr to always work them out
+
+  @return
+    true if the query was answered, false if an error was written instead
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::answerQuery(catalogue, "-d popden -a W06000011 -j", std::cout);
+*/
+bool BethYw::answerQuery(Catalogue& catalogue, const std::string& query, std::ostream& out, ResultCache* cache) {
+    //an invalid query gets no key, and is answered with its error as normal
+    std::string key;
+    std::uint64_t generation = catalogue.getGeneration();
+    if (cache != nullptr) {
+        try {
+            key = BethYw::resultKey(query);
+        } catch (const std::exception&) {
+            cache = nullptr;
+        }
+    }
+    if (cache != nullptr) {
+        std::string cached;
+        if (cache->find(key, generation, cached)) {
+            out << cached;
+            return true;
+        }
+    }
+
+    try {
+        //written to a string first so an error halfway through doesn't leave
+        //half an answer before the error
+        std::ostringstream answer;
+        if (BethYw::isQuery(query)) {
+            BethYw::runQuery(catalogue, query, answer);
+        } else {
+            auto args = BethYw::parseArguments(BethYw::splitArguments(query));
+            if (args.count("dir") || args.count("serve") || args.count("repl") || args.count("help"))
+                throw std::invalid_argument("Invalid query: --dir, --serve, --repl and --help can't be used in a query");
+
+            Areas data = catalogue.query(BethYw::parseSelection(args), args.count("sketch") > 0);
+            BethYw::writeOutput(data, args, answer);
+        }
+
+        std::string text = answer.str();
+        if (cache != nullptr)
+            cache->insert(key, generation, text);
+        out << text;
+        return true;
+    } catch (const std::exception& error) {
+        out << "Error: " << error.what() << '\n';
+        return false;
+    }
+}
+
+/*
+  Answer queries sent to a Unix domain socket, forever (or until the socket
+  fails). A socket already at the path (e.g. left by a server that was
+  killed) is replaced, but anything else there is an error. Connections are
+  answered by a pool of worker threads, one query per connection. A client
+  that doesn't send its query line within a few seconds is disconnected
+  without an answer, so an idle connection can't hold up a worker for long.
+
+  @param catalogue
+    The datasets in memory (usually loaded already, so the first queries
+    don't have to wait)
+
+  @param path
+    The path of the socket to create
+
+  @param threads
+    The number of worker threads, or 0 for one per hardware thread
+
+  @param cache
+    The answers already written (see answerQuery()), or nullptr for none
+
+  @throws
+    std::runtime_error if something other than a socket is at the path, or
+    the socket can't be created or stops working
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    catalogue.load(BethYw::findDatasets({"all"}));
+    BethYw::serve(catalogue, "bethyw.sock");
+*/
+void BethYw::serve(Catalogue& catalogue, const std::string& path, unsigned int threads, ResultCache* cache) {
+#ifdef _WIN32
+    (void) catalogue;
+    (void) path;
+    (void) threads;
+    (void) cache;
+    throw std::runtime_error("BethYw::serve: Unix domain sockets are not supported on this platform");
+#else
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("BethYw::serve: Invalid socket path " + path);
+    std::strcpy(address.sun_path, path.c_str());
+
+    //only a socket left by an earlier server is replaced, never a file
+    struct stat existing;
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode))
+            throw std::runtime_error("BethYw::serve: " + path + " already exists and is not a socket");
+        ::unlink(path.c_str());
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::runtime_error("BethYw::serve: Failed to create socket " + path);
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || ::listen(listener, SOMAXCONN) < 0) {
+        ::close(listener);
+        throw std::runtime_error("BethYw::serve: Failed to listen on socket " + path
+                                 + ": " + std::strerror(errno));
+    }
+
+    //a client hanging up early shouldn't kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::queue<int> connections;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; i++) {
+        pool.emplace_back([&]() {
+            for (;;) {
+                int fd;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [&]() { return stopping || !connections.empty(); });
+                    if (connections.empty())
+                        return;
+                    fd = connections.front();
+                    connections.pop();
+                }
+
+                std::string query;
+                if (readLine(fd, query)) {
+                    std::ostringstream answer;
+                    BethYw::answerQuery(catalogue, query, answer, cache);
+                    writeAll(fd, answer.str());
+                }
+                ::close(fd);
+            }
+        });
+    }
+
+    std::cerr << "Listening on " << path << std::endl;
+
+    std::string error;
+    for (;;) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            error = std::strerror(errno);
+            break;
+        }
+        //a client that stops reading its answer is dropped like one that
+        //never sends its query (see readLine())
+        timeval timeout = {CLIENT_TIMEOUT_SECONDS, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            connections.push(fd);
+        }
+        ready.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& thread : pool)
+        thread.join();
+    ::close(listener);
+    throw std::runtime_error("BethYw::serve: Failed to accept a connection on " + path + ": " + error);
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for --serve mode, where the datasets
+  are imported once into a Catalogue and queries are answered from memory.
+
+  The protocol is one query per connection to a Unix domain socket: the
+  client sends one line of the same arguments as the command line, e.g.
+
+    -d popden -a W06000011,W06000024 -y 2010-2015 -j
+
+  and gets back exactly what the program would have printed, then the
+  connection is closed. A client that hasn't sent its line within a few
+  seconds is disconnected without an answer. A line starting SELECT or EXPLAIN is a query in the
+  language in query.h instead. An invalid query gets one line starting
+  "Error: ".
+  With a ResultCache, the answer to a query asked before is sent again
+  without being worked out again (see resultcache.h).
+  With a tool like socat:
+
+    echo "-d popden -j" | socat - UNIX-CONNECT:bethyw.sock
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catalogue.h"
+#include "resultcache.h"
+
+namespace BethYw {
+
+/*----Requests----*/
+std::vector<std::string> splitArguments(const std::string& line) noexcept(false);
+bool answerQuery(Catalogue& catalogue,
+                 const std::string& query,
+                 std::ostream& out,
+                 ResultCache* cache = nullptr);
+
+/*----Server----*/
+void serve(Catalogue& catalogue,
+           const std::string& path,
+           unsigned int threads = 0,
+           ResultCache* cache = nullptr) noexcept(false);
+
+} // namespace BethYw
+
+#endif // SERVER_H_
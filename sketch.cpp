@@ -0,0 +1,473 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the t-digest and HyperLogLog
+  sketches. See the header file for additional comments.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "output.h"
+#include "sketch.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+/*
+  The t-digest k1 scale function and its inverse: a centroid may cover at
+  most one unit of k, which is a small range of q near 0 and 1 and a large
+  one near 0.5.
+*/
+double scale(double q, double compression) {
+    return compression / (2 * PI) * std::asin(2 * q - 1);
+}
+
+double inverseScale(double k, double compression) {
+    return (std::sin(k * 2 * PI / compression) + 1) / 2;
+}
+
+/*
+  A 64 bit hash of a string that is the same on every platform (unlike
+  std::hash): FNV-1a, with its bits mixed by the splitmix64 finaliser since
+  HyperLogLog needs every bit to be equally random.
+*/
+std::uint64_t hash(const std::string& value) {
+    std::uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace
+
+/*
+  Construct an empty t-digest.
+
+  @param compression
+    How many centroids to keep (about compression / 2 once it has a lot of
+    values); more is more accurate but bigger
+
+  @example
+    BethYw::TDigest digest;
+*/
+BethYw::TDigest::TDigest(double compression) : compression(compression) {}
+
+/*
+  Add a value to the digest.
+
+  @param value
+    The value to add
+
+  @param weight
+    How many times to add it
+
+  @example
+    BethYw::TDigest digest;
+    digest.add(711.6801);
+*/
+void BethYw::TDigest::add(double value, double weight) {
+    if (std::isnan(value) || weight <= 0)
+        return;
+
+    if (total == 0) {
+        minimum = value;
+        maximum = value;
+    } else {
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+    total += weight;
+
+    buffer.push_back(Centroid{value, weight});
+    if (buffer.size() >= 5 * compression)
+        flush();
+}
+
+/*
+  Merge another digest into this one, as though everything added to it had
+  been added to this one too.
+
+  @param other
+    The digest to merge in
+
+  @example
+    BethYw::TDigest a, b;
+    ...
+    a.merge(b);
+*/
+void BethYw::TDigest::merge(const TDigest& other) {
+    if (other.total == 0)
+        return;
+
+    for (auto const& centroid : other.merged()) {
+        buffer.push_back(centroid);
+        if (buffer.size() >= 5 * compression)
+            flush();
+    }
+
+    if (total == 0) {
+        minimum = other.minimum;
+        maximum = other.maximum;
+    } else {
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+    total += other.total;
+}
+
+/*
+  The centroids with the buffered values merged in, without changing the
+  digest: sort everything by mean and then merge neighbours into one
+  centroid while it covers no more than one unit of the scale function.
+*/
+std::vector<BethYw::TDigest::Centroid> BethYw::TDigest::merged() const {
+    if (buffer.empty())
+        return centroids;
+
+    std::vector<Centroid> sorted(buffer);
+    sorted.insert(sorted.end(), centroids.begin(), centroids.end());
+    std::sort(sorted.begin(), sorted.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+
+    double weight = 0;
+    for (auto const& centroid : sorted)
+        weight += centroid.weight;
+
+    std::vector<Centroid> result;
+    Centroid current = sorted.front();
+    double before = 0;
+    double limit = inverseScale(scale(0, compression) + 1, compression);
+    for (std::size_t i = 1; i < sorted.size(); i++) {
+        const Centroid& next = sorted[i];
+        if ((before + current.weight + next.weight) / weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            result.push_back(current);
+            before += current.weight;
+            limit = inverseScale(scale(before / weight, compression) + 1, compression);
+            current = next;
+        }
+    }
+    result.push_back(current);
+    return result;
+}
+
+/*
+  Merge the buffered values into the centroids.
+*/
+void BethYw::TDigest::flush() {
+    if (buffer.empty())
+        return;
+    centroids = merged();
+    buffer.clear();
+}
+
+/*
+  Retrieve the number of values added (the sum of their weights).
+
+  @return
+    The number of values
+
+  @example
+    BethYw::TDigest digest;
+    digest.add(1);
+    auto count = digest.count(); // returns 1
+*/
+double BethYw::TDigest::count() const {
+    return total;
+}
+
+/*
+  Retrieve the smallest value added, which is kept exactly.
+
+  @return
+    The smallest value, or 0 if there are none
+*/
+double BethYw::TDigest::getMinimum() const {
+    return minimum;
+}
+
+/*
+  Retrieve the largest value added, which is kept exactly.
+
+  @return
+    The largest value, or 0 if there are none
+*/
+double BethYw::TDigest::getMaximum() const {
+    return maximum;
+}
+
+/*
+  Estimate a quantile. Each centroid's mean is taken to be at the middle of
+  the values it holds, and the quantile is interpolated between the two
+  closest centroids (or the minimum/maximum at the ends). Any values still
+  buffered are merged into a copy of the centroids, so the digest itself is
+  not changed.
+
+  @param q
+    The quantile, from 0 to 1 (0.5 is the median)
+
+  @return
+    The estimated value at that quantile, or NaN if there are no values
+
+  @example
+    BethYw::TDigest digest;
+    ...
+    auto p99 = digest.quantile(0.99);
+*/
+double BethYw::TDigest::quantile(double q) const {
+    if (total == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+    std::vector<Centroid> withBuffer;
+    if (!buffer.empty())
+        withBuffer = merged();
+    const std::vector<Centroid>& summary = buffer.empty() ? centroids : withBuffer;
+
+    q = std::min(std::max(q, 0.0), 1.0);
+    const double target = q * total;
+
+    double previousMean = minimum;
+    double previousMiddle = 0;
+    double before = 0;
+    for (auto const& centroid : summary) {
+        double middle = before + centroid.weight / 2;
+        if (target <= middle) {
+            if (middle == previousMiddle)
+                return centroid.mean;
+            return previousMean + (centroid.mean - previousMean) * (target - previousMiddle) / (middle - previousMiddle);
+        }
+        previousMean = centroid.mean;
+        previousMiddle = middle;
+        before += centroid.weight;
+    }
+
+    if (total == previousMiddle)
+        return maximum;
+    return previousMean + (maximum - previousMean) * (target - previousMiddle) / (total - previousMiddle);
+}
+
+/*
+  Construct an empty HyperLogLog counter.
+
+  @example
+    BethYw::HyperLogLog areas;
+*/
+BethYw::HyperLogLog::HyperLogLog() {}
+
+/*
+  Add a value. Adding the same value again doesn't change the count.
+
+  @param value
+    The value to add
+
+  @example
+    BethYw::HyperLogLog areas;
+    areas.add("W06000011");
+*/
+void BethYw::HyperLogLog::add(const std::string& value) {
+    addHash(hash(value));
+}
+
+void BethYw::HyperLogLog::addHash(std::uint64_t h) {
+    if (registers.empty()) {
+        auto position = std::lower_bound(sparse.begin(), sparse.end(), h);
+        if (position == sparse.end() || *position != h)
+            sparse.insert(position, h);
+        if (sparse.size() > SPARSE_LIMIT)
+            toRegisters();
+        return;
+    }
+
+    std::size_t index = h >> (64 - PRECISION);
+
+    //the position of the first 1 bit in the rest of the hash
+    std::uint64_t rest = h << PRECISION;
+    std::uint8_t rank = 1;
+    while (rank <= 64 - PRECISION && (rest & (1ULL << 63)) == 0) {
+        rank++;
+        rest <<= 1;
+    }
+    registers[index] = std::max(registers[index], rank);
+}
+
+/*
+  Swap the exact list of hashes for the registers, once there are too many
+  hashes for it to be smaller.
+*/
+void BethYw::HyperLogLog::toRegisters() {
+    registers.assign(1u << PRECISION, 0);
+    for (auto h : sparse)
+        addHash(h);
+    sparse.clear();
+    sparse.shrink_to_fit();
+}
+
+/*
+  Merge another counter into this one, as though everything added to it had
+  been added to this one too.
+
+  @param other
+    The counter to merge in
+
+  @example
+    BethYw::HyperLogLog a, b;
+    ...
+    a.merge(b);
+*/
+void BethYw::HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.registers.empty()) {
+        for (auto h : other.sparse)
+            addHash(h);
+        return;
+    }
+
+    if (registers.empty())
+        toRegisters();
+    for (std::size_t i = 0; i < registers.size(); i++)
+        registers[i] = std::max(registers[i], other.registers[i]);
+}
+
+/*
+  Estimate the number of distinct values added.
+
+  @return
+    The estimated number of distinct values (exact while there are few)
+
+  @example
+    BethYw::HyperLogLog areas;
+    areas.add("W06000011");
+    areas.add("W06000011");
+    auto distinct = areas.estimate(); // returns 1
+*/
+double BethYw::HyperLogLog::estimate() const {
+    if (registers.empty())
+        return sparse.size();
+
+    const double m = registers.size();
+    double sum = 0;
+    std::size_t zeros = 0;
+    for (auto reg : registers) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0)
+            zeros++;
+    }
+
+    //linear counting is more accurate while many registers are still empty
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * std::log(m / zeros);
+    return estimate;
+}
+
+/*
+  Merge the sketches of the same measure from somewhere else (e.g. another
+  dataset or Areas object) into these.
+
+  @param other
+    The sketches to merge in
+
+  @example
+    BethYw::MeasureSketch a, b;
+    ...
+    a.merge(b);
+*/
+void BethYw::MeasureSketch::merge(const MeasureSketch& other) {
+    if (label.empty())
+        label = other.label;
+    values.merge(other.values);
+    areas.merge(other.areas);
+}
+
+/*
+  Write the sketches as a table for each measure, in the same style as the
+  tables of a Measure's values.
+
+  @param os
+    The output stream to write to
+
+  @param sketches
+    The sketches, by measure codename
+
+  @example
+    BethYw::writeSketchTable(std::cout, data.getSketches());
+*/
+void BethYw::writeSketchTable(std::ostream& os, const SketchContainer& sketches) {
+    if (sketches.empty()) {
+        os << "<no data>\n";
+        return;
+    }
+
+    TableWriter table;
+    for (auto const& sketch : sketches) {
+        const TDigest& values = sketch.second.values;
+        os << sketch.second.label << " (" << sketch.first << ") \n";
+
+        table.clear();
+        table.addColumn("Readings", static_cast<unsigned int>(values.count()));
+        table.addColumn("Areas", static_cast<unsigned int>(std::lround(sketch.second.areas.estimate())));
+        table.addColumn("Min", values.getMinimum());
+        table.addColumn("P25", values.quantile(0.25));
+        table.addColumn("Median", values.quantile(0.5));
+        table.addColumn("P75", values.quantile(0.75));
+        table.addColumn("P99", values.quantile(0.99));
+        table.addColumn("Max", values.getMaximum());
+        table.write(os);
+        os.put('\n');
+    }
+}
+
+/*
+  Write the sketches as a JSON object, with an object of approximate
+  statistics for each measure codename.
+
+  @param os
+    The output stream to write to
+
+  @param sketches
+    The sketches, by measure codename
+
+  @example
+    BethYw::writeSketchJSON(std::cout, data.getSketches());
+    // {"pop":{"areas":22,"label":"Population","max":...,"readings":242}}
+*/
+void BethYw::writeSketchJSON(std::ostream& os, const SketchContainer& sketches) {
+    os.put('{');
+    for (auto sketch = sketches.begin(); sketch != sketches.end(); sketch++) {
+        const TDigest& values = sketch->second.values;
+        if (sketch != sketches.begin())
+            os.put(',');
+        writeJSONString(os, sketch->first);
+        os << ":{\"areas\":" << std::lround(sketch->second.areas.estimate()) << ",\"label\":";
+        writeJSONString(os, sketch->second.label);
+        os.write(",\"max\":", 7);
+        writeJSONNumber(os, values.getMaximum());
+        os.write(",\"median\":", 10);
+        writeJSONNumber(os, values.quantile(0.5));
+        os.write(",\"min\":", 7);
+        writeJSONNumber(os, values.getMinimum());
+        os.write(",\"p25\":", 7);
+        writeJSONNumber(os, values.quantile(0.25));
+        os.write(",\"p75\":", 7);
+        writeJSONNumber(os, values.quantile(0.75));
+        os.write(",\"p99\":", 7);
+        writeJSONNumber(os, values.quantile(0.99));
+        os << ",\"readings\":" << static_cast<unsigned long>(values.count()) << '}';
+    }
+    os.put('}');
+}
@@ -0,0 +1,132 @@
+#ifndef SKETCH_H_
+#define SKETCH_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for sketches: small summaries of a
+  large number of values that give approximate answers without keeping the
+  values themselves.
+
+  TDigest       — Approximate quantiles (median, percentiles) of a series of
+                  numbers, from a few hundred weighted "centroids".
+
+  HyperLogLog   — Approximate number of distinct strings (e.g. area codes),
+                  from 4096 one byte registers (or exactly, while there
+                  are only a few).
+
+  Both can be merged: merging two sketches gives (about) the same answers as
+  one sketch of everything added to either of them.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace BethYw {
+
+/*
+  A merging t-digest (Dunning & Ertl). Values are collected in a buffer and
+  every so often sorted and merged into the centroids, with centroids near
+  the middle allowed to hold more values than those near the ends so the
+  extreme quantiles stay accurate.
+*/
+class TDigest {
+private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  double compression;
+
+  // merged into the centroids when full; a quantile calculated before then
+  // merges a copy, so the const functions never change the digest and can
+  // be called from several threads at once
+  std::vector<Centroid> buffer;
+  std::vector<Centroid> centroids;
+
+  double total = 0;
+  double minimum = 0;
+  double maximum = 0;
+
+  std::vector<Centroid> merged() const;
+  void flush();
+
+public:
+  /*----Constructor----*/
+  explicit TDigest(double compression = 100);
+
+  /*----Getters----*/
+  double count() const;
+  double getMinimum() const;
+  double getMaximum() const;
+  double quantile(double q) const;
+
+  /*----Miscellaneous----*/
+  void add(double value, double weight = 1);
+  void merge(const TDigest& other);
+};
+
+/*
+  A HyperLogLog distinct counter with 2^12 registers, which has a standard
+  error of about 1.6%. While there are only a few distinct values (e.g. the
+  22 areas) it keeps their hashes instead, and counts them exactly.
+*/
+class HyperLogLog {
+private:
+  static const unsigned int PRECISION = 12;
+  static const std::size_t SPARSE_LIMIT = 256;
+
+  // the sorted hashes of the values, until there are more than SPARSE_LIMIT
+  std::vector<std::uint64_t> sparse;
+
+  // empty until the hashes are swapped for registers
+  std::vector<std::uint8_t> registers;
+
+  void addHash(std::uint64_t hash);
+  void toRegisters();
+
+public:
+  /*----Constructor----*/
+  HyperLogLog();
+
+  /*----Getters----*/
+  double estimate() const;
+
+  /*----Miscellaneous----*/
+  void add(const std::string& value);
+  void merge(const HyperLogLog& other);
+};
+
+/*
+  The sketches kept for one measure codename across every Area: the
+  distribution of its values and the number of distinct areas with a value.
+*/
+struct MeasureSketch {
+  std::string label;
+  TDigest values;
+  HyperLogLog areas;
+
+  void merge(const MeasureSketch& other);
+};
+
+/*
+  An alias for the sketches of every measure, by codename.
+*/
+using SketchContainer = std::map<std::string, MeasureSketch>;
+
+/*----Output----*/
+void writeSketchTable(std::ostream& os, const SketchContainer& sketches);
+void writeSketchJSON(std::ostream& os, const SketchContainer& sketches);
+
+} // namespace BethYw
+
+#endif // SKETCH_H_
@@ -0,0 +1,366 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the snapshot cache. See the header
+  file for additional comments.
+
+  Snapshots (and the dataset files, to hash them) are memory-mapped where the
+  platform allows, so checking an unchanged file and reading its snapshot
+  copies nothing before the Areas are built.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "bethyw.h"
+#include "fileutil.h"
+#include "snapshot.h"
+
+namespace {
+
+const char MAGIC[] = "BYWSNAP1";
+constexpr std::size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+/*
+  A whole file, read-only, with its size and modified time. It is mapped into
+  memory where possible, and read into a string otherwise.
+*/
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+    long long modified = 0;
+    bool open = false;
+#ifdef _WIN32
+    std::string contents;
+#else
+    void* mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& path) {
+        unsigned long long size = 0;
+        if (!BethYw::stampFile(path, size, modified))
+            return;
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return;
+        std::ostringstream read;
+        read << file.rdbuf();
+        contents = read.str();
+        bytes = contents.data();
+        length = contents.size();
+        open = true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        length = static_cast<std::size_t>(size);
+        if (length > 0) {
+            mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                ::close(fd);
+                return;
+            }
+            bytes = static_cast<const char*>(mapping);
+        }
+        ::close(fd);
+        open = true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapping != nullptr)
+            ::munmap(mapping, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return open; }
+    const char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+    long long getModified() const { return modified; }
+};
+
+/*
+  Append a little-endian integer to the end of a string.
+*/
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+    auto bits = static_cast<std::uint64_t>(value);
+    for (std::size_t i = 0; i < sizeof(T); i++)
+        out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+}
+
+void appendDouble(std::string& out, double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLittleEndian(out, bits);
+}
+
+void appendString(std::string& out, const std::string& value) {
+    appendLittleEndian(out, static_cast<std::uint32_t>(value.size()));
+    out += value;
+}
+
+/*
+  Reads a snapshot from the front, remembering if it ever ran off the end
+  (after which everything read is 0 or empty).
+*/
+class SnapshotReader {
+private:
+    const char* next;
+    const char* end;
+    bool valid = true;
+
+public:
+    SnapshotReader(const char* bytes, std::size_t length) : next(bytes), end(bytes + length) {}
+
+    template <typename T>
+    T number() {
+        if (static_cast<std::size_t>(end - next) < sizeof(T)) {
+            valid = false;
+            next = end;
+            return 0;
+        }
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(next[i])) << (8 * i);
+        next += sizeof(T);
+        return static_cast<T>(bits);
+    }
+
+    double decimal() {
+        auto bits = number<std::uint64_t>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string text() {
+        auto length = number<std::uint32_t>();
+        if (static_cast<std::size_t>(end - next) < length) {
+            valid = false;
+            next = end;
+            return "";
+        }
+        std::string value(next, length);
+        next += length;
+        return value;
+    }
+
+    bool isValid() const { return valid; }
+    bool atEnd() const { return next == end; }
+};
+
+/*
+  Write a snapshot of areas, which were imported from source (whose size,
+  modified time and hash are given), to a temporary file and then move it
+  into place, so no reader ever sees half of one. Failing to write it is not
+  an error: the dataset will just be parsed again next time.
+*/
+void saveSnapshot(const std::string& snapshot,
+                  const std::string& source,
+                  std::uint64_t size,
+                  long long modified,
+                  std::uint64_t hash,
+                  const Areas& areas) {
+    std::string out(MAGIC, MAGIC_SIZE);
+    appendString(out, source);
+    appendLittleEndian(out, size);
+    appendLittleEndian(out, static_cast<std::int64_t>(modified));
+    appendLittleEndian(out, hash);
+
+    appendLittleEndian(out, static_cast<std::uint32_t>(areas.getAreas().size()));
+    for (auto const& area : areas.getAreas()) {
+        appendString(out, area.first);
+        appendLittleEndian(out, static_cast<std::uint32_t>(area.second.getNames().size()));
+        for (auto const& name : area.second.getNames()) {
+            appendString(out, name.first);
+            appendString(out, name.second);
+        }
+        appendLittleEndian(out, static_cast<std::uint32_t>(area.second.getMeasures().size()));
+        for (auto const& measure : area.second.getMeasures()) {
+            appendString(out, measure.second.getCodename());
+            appendString(out, measure.second.getLabel());
+            appendLittleEndian(out, static_cast<std::uint32_t>(measure.second.getReadings().size()));
+            for (auto const& reading : measure.second.getReadings()) {
+                appendLittleEndian(out, static_cast<std::uint32_t>(reading.first));
+                appendDouble(out, reading.second);
+            }
+        }
+    }
+
+    BethYw::writeFileAtomically(snapshot, out);
+}
+
+} // namespace
+
+/*
+  Work out where the snapshot of a dataset in a directory is kept: a file in
+  the cache directory named after the dataset's code and a hash of its path,
+  so the same cache can be used for several datasets directories.
+
+  @param cacheDir
+    The cache directory, ending in DIR_SEP
+
+  @param dir
+    The datasets directory, ending in DIR_SEP
+
+  @param dataset
+    The dataset
+
+  @return
+    The path of the snapshot
+
+  @example
+    auto path = BethYw::snapshotPath("cache/", "datasets/", InputFiles::POPDEN);
+    // e.g. cache/popden-1f0e3dad99908345.snapshot
+*/
+std::string BethYw::snapshotPath(const std::string& cacheDir, const std::string& dir, const InputFileSource& dataset) {
+    std::string source = dir + dataset.FILE;
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(BethYw::hashBytes(source.data(), source.size())));
+    return cacheDir + dataset.CODE + "-" + hash + ".snapshot";
+}
+
+/*
+  Read a snapshot into an Areas object, if it was taken from the source file
+  as it is now (same path, size, modified time and hash of the contents).
+
+  @param snapshot
+    The path of the snapshot
+
+  @param source
+    The path of the dataset file it should have been taken from
+
+  @param areas
+    The Areas object to fill, which is only changed if the snapshot is used
+
+  @return
+    true if the snapshot was up to date and read; false if it is missing,
+    out of date or not a valid snapshot
+
+  @example
+    Areas data = Areas();
+    std::string snapshot = BethYw::snapshotPath("cache/", "datasets/", InputFiles::POPDEN);
+    if (!BethYw::loadSnapshot(snapshot, "datasets/popu1009.json", data))
+      ...
+*/
+bool BethYw::loadSnapshot(const std::string& snapshot, const std::string& source, Areas& areas) {
+    MappedFile snapshotFile(snapshot);
+    if (!snapshotFile.isOpen() || snapshotFile.size() < MAGIC_SIZE
+        || std::memcmp(snapshotFile.data(), MAGIC, MAGIC_SIZE) != 0)
+        return false;
+
+    SnapshotReader reader(snapshotFile.data() + MAGIC_SIZE, snapshotFile.size() - MAGIC_SIZE);
+    std::string path = reader.text();
+    auto size = reader.number<std::uint64_t>();
+    auto modified = reader.number<std::int64_t>();
+    auto hash = reader.number<std::uint64_t>();
+
+    //the hash is only worked out once the cheaper checks have passed
+    MappedFile sourceFile(source);
+    if (!reader.isValid() || !sourceFile.isOpen() || path != source || size != sourceFile.size()
+        || modified != sourceFile.getModified() || hash != BethYw::hashBytes(sourceFile.data(), sourceFile.size()))
+        return false;
+
+    Areas imported = Areas();
+    auto areaCount = reader.number<std::uint32_t>();
+    for (std::uint32_t a = 0; a < areaCount && reader.isValid(); a++) {
+        Area area(reader.text());
+        auto nameCount = reader.number<std::uint32_t>();
+        for (std::uint32_t n = 0; n < nameCount && reader.isValid(); n++) {
+            std::string language = reader.text();
+            area.setName(language, reader.text());
+        }
+        auto measureCount = reader.number<std::uint32_t>();
+        for (std::uint32_t m = 0; m < measureCount && reader.isValid(); m++) {
+            std::string codename = reader.text();
+            Measure measure(codename, reader.text());
+            auto readingCount = reader.number<std::uint32_t>();
+            for (std::uint32_t r = 0; r < readingCount && reader.isValid(); r++) {
+                auto year = reader.number<std::uint32_t>();
+                measure.setValue(year, reader.decimal());
+            }
+            area.setMeasure(codename, measure);
+        }
+        imported.setArea(area.getLocalAuthorityCode(), area);
+    }
+
+    if (!reader.isValid() || !reader.atEnd())
+        return false;
+    areas = std::move(imported);
+    return true;
+}
+
+/*
+  Import the whole of a dataset, with no filters: from its snapshot in the
+  cache directory if that is up to date, or else by parsing the file and
+  then saving a snapshot for next time.
+
+  @param dir
+    The datasets directory, ending in DIR_SEP
+
+  @param dataset
+    The dataset to import
+
+  @param cacheDir
+    The cache directory, ending in DIR_SEP (created if it doesn't exist)
+
+  @return
+    Everything in the dataset
+
+  @throws
+    std::runtime_error (or whatever the parser threw) if the dataset had to
+    be parsed and couldn't be
+
+  @example
+    Areas data = BethYw::importDataset("datasets/", InputFiles::POPDEN, "cache/");
+    StringFilterSet areasFilter = {"W06000011"};
+    Areas swansea = data.select(&areasFilter, nullptr, nullptr);
+*/
+Areas BethYw::importDataset(const std::string& dir, const InputFileSource& dataset, const std::string& cacheDir) {
+    std::string source = dir + dataset.FILE;
+    std::string snapshot = BethYw::snapshotPath(cacheDir, dir, dataset);
+
+    Areas imported = Areas();
+    if (BethYw::loadSnapshot(snapshot, source, imported))
+        return imported;
+
+    //parsed from the same bytes that are hashed, so the snapshot can't be
+    //of a different version of the file than its header says
+    MappedFile sourceFile(source);
+    if (!sourceFile.isOpen())
+        throw std::runtime_error("InputFile::open: Failed to open file " + source);
+    std::istringstream stream(std::string(sourceFile.data() == nullptr ? "" : sourceFile.data(), sourceFile.size()));
+
+    const StringFilterSet all;
+    const YearFilterTuple allYears(0, 0);
+    imported.populate(stream, dataset.PARSER, dataset.COLS, &all, &all, &allYears);
+
+    BethYw::makeDirectory(cacheDir);
+    saveSnapshot(snapshot, source, sourceFile.size(), sourceFile.getModified(),
+                 BethYw::hashBytes(sourceFile.data(), sourceFile.size()), imported);
+    return imported;
+}
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for the snapshot cache (--cache), which
+  keeps each dataset, once parsed, as a binary snapshot so that later runs
+  can skip the JSON and CSV parsers while the file is unchanged.
+
+  A snapshot holds everything imported from one dataset file with no filters,
+  after a header saying which file it came from (path, size, modified time
+  and a 64-bit FNV-1a hash of the contents). It is only used while all four
+  still match the file; otherwise the file is parsed again and the snapshot
+  replaced. The filters are then applied with Areas::select(), which gives
+  the same data as the parsers would have.
+
+  All numbers are little-endian, and strings are a uint32 length then bytes:
+
+    "BYWSNAP1"  path  uint64 size  int64 modified  uint64 hash
+    uint32 areas, each:
+      code  uint32 names, each: language  name
+            uint32 measures, each: codename  label
+                                   uint32 readings, each: uint32 year  float64 value
+ */
+
+#include <string>
+
+#include "areas.h"
+#include "datasets.h"
+
+namespace BethYw {
+
+std::string snapshotPath(const std::string& cacheDir, const std::string& dir, const InputFileSource& dataset);
+bool loadSnapshot(const std::string& snapshot, const std::string& source, Areas& areas);
+Areas importDataset(const std::string& dir,
+                    const InputFileSource& dataset,
+                    const std::string& cacheDir) noexcept(false);
+
+} // namespace BethYw
+
+#endif // SNAPSHOT_H_
@@ -0,0 +1,269 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the statistics kernels. See the
+  header file for additional comments.
+
+  The sums are split over four independent accumulators ("lanes"). Without
+  them each addition has to wait for the one before it, and the compiler is
+  not allowed to reorder floating point additions itself, so it could neither
+  vectorise the loop nor overlap the additions.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "statistics.h"
+
+namespace {
+
+const std::size_t LANES = 4;
+
+/*
+  Sum term(i) for i in [0, count) over LANES accumulators.
+*/
+template <typename Term>
+double laneSum(std::size_t count, Term term) {
+    double lanes[LANES] = {0, 0, 0, 0};
+
+    std::size_t i = 0;
+    for (; i + LANES <= count; i += LANES)
+        for (std::size_t lane = 0; lane < LANES; lane++)
+            lanes[lane] += term(i + lane);
+
+    for (; i < count; i++)
+        lanes[0] += term(i);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+/*
+  The p-th percentile of already sorted values, interpolating linearly
+  between the two closest ranks.
+*/
+double sortedPercentile(const double* sorted, std::size_t count, double p) {
+    double rank = (p / 100) * (count - 1);
+    auto lower = static_cast<std::size_t>(std::floor(rank));
+    if (lower + 1 >= count)
+        return sorted[count - 1];
+    return sorted[lower] + (sorted[lower + 1] - sorted[lower]) * (rank - lower);
+}
+
+} // namespace
+
+/*
+  Calculate the p-th percentile of a series of values, interpolating linearly
+  between the two closest ranks (the same method as numpy's default). The
+  values don't need to be sorted and are not modified.
+
+  @param values
+    The values
+
+  @param count
+    The number of values
+
+  @param p
+    The percentile to find, from 0 to 100 (50 is the median)
+
+  @return
+    The percentile, or 0 if there are no values
+
+  @example
+    double values[] = {3, 1, 2, 4};
+    auto median = BethYw::percentile(values, 4, 50); // returns 2.5
+*/
+double BethYw::percentile(const double* values, std::size_t count, double p) {
+    if (count == 0)
+        return 0;
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    std::vector<double> scratch(values, values + count);
+
+    double rank = (p / 100) * (count - 1);
+    auto lower = static_cast<std::size_t>(std::floor(rank));
+    std::nth_element(scratch.begin(), scratch.begin() + lower, scratch.end());
+    if (lower + 1 >= count)
+        return scratch[lower];
+
+    //everything after the nth element is at least as large, so the next
+    //rank up is the smallest of them
+    double upper = *std::min_element(scratch.begin() + lower + 1, scratch.end());
+    return scratch[lower] + (upper - scratch[lower]) * (rank - lower);
+}
+
+/*
+  Calculate the summary statistics for a series of readings.
+
+  @param years
+    The year of each reading, in ascending order
+
+  @param values
+    The value of each reading
+
+  @param count
+    The number of readings
+
+  @return
+    The Statistics for the readings
+
+  @example
+    unsigned int years[] = {1999, 2000, 2001};
+    double values[] = {10, 30, 20};
+    auto stats = BethYw::calculateStatistics(years, values, 3);
+    // stats.median == 20, stats.maximumYear == 2000
+*/
+BethYw::Statistics BethYw::calculateStatistics(const unsigned int* years, const double* values, std::size_t count) {
+    Statistics stats;
+    stats.count = count;
+    if (count == 0)
+        return stats;
+
+    stats.mean = laneSum(count, [values](std::size_t i) { return values[i]; }) / count;
+
+    const double mean = stats.mean;
+    double variance = laneSum(count, [values, mean](std::size_t i) {
+        double deviation = values[i] - mean;
+        return deviation * deviation;
+    }) / count;
+    stats.standardDeviation = std::sqrt(variance);
+
+    //least squares: slope = sum(dx * dy) / sum(dx * dx), about the means
+    const double meanYear = laneSum(count, [years](std::size_t i) { return static_cast<double>(years[i]); }) / count;
+    double sxy = laneSum(count, [years, values, mean, meanYear](std::size_t i) {
+        return (years[i] - meanYear) * (values[i] - mean);
+    });
+    double sxx = laneSum(count, [years, meanYear](std::size_t i) {
+        double dx = years[i] - meanYear;
+        return dx * dx;
+    });
+    stats.trend = sxx == 0 ? 0 : sxy / sxx;
+
+    std::size_t minimum = 0;
+    std::size_t maximum = 0;
+    for (std::size_t i = 1; i < count; i++) {
+        if (values[i] < values[minimum])
+            minimum = i;
+        if (values[i] > values[maximum])
+            maximum = i;
+    }
+    stats.minimumYear = years[minimum];
+    stats.maximumYear = years[maximum];
+
+    //growth only makes sense between two different years of positive values
+    const double first = values[0];
+    const double last = values[count - 1];
+    const unsigned int span = years[count - 1] - years[0];
+    if (span > 0 && first > 0 && last >= 0)
+        stats.growthRate = (std::pow(last / first, 1.0 / span) - 1) * 100;
+
+    //all three quantiles come from one sorted copy
+    static thread_local std::vector<double> sorted;
+    sorted.assign(values, values + count);
+    std::sort(sorted.begin(), sorted.end());
+    stats.median = sortedPercentile(sorted.data(), count, 50);
+    stats.lowerQuartile = sortedPercentile(sorted.data(), count, 25);
+    stats.upperQuartile = sortedPercentile(sorted.data(), count, 75);
+
+    return stats;
+}
+
+/*
+  Check whether any transform has been asked for.
+
+  @return
+    true if at least one derived series should be added
+
+  @example
+    BethYw::Transforms transforms;
+    transforms.change = true;
+    bool add = transforms.any(); // returns true
+*/
+bool BethYw::Transforms::any() const {
+    return movingAverage || change || percentChange || cumulativeSum;
+}
+
+/*
+  Calculate the derived series of a series of readings in one pass over them.
+  The moving average keeps a running sum of the readings in its window, adding
+  each new reading and taking off the ones that have fallen out of the window,
+  instead of adding up the whole window again for every reading.
+
+  Where a value can't be calculated it is NaN: the moving average needs a
+  reading in every year of the window, the changes need a reading in the year
+  before, and the % change also needs that reading not to be 0.
+
+  Any of the output arrays can be nullptr to skip that series.
+
+  @param years
+    The year of each reading, in ascending order
+
+  @param values
+    The value of each reading
+
+  @param count
+    The number of readings, and the size of each output array
+
+  @param window
+    The number of years in the moving average (at least 1)
+
+  @param movingAverage
+    Output: the average of the readings in the `window` years up to each one
+
+  @param change
+    Output: the change from the previous year
+
+  @param percentChange
+    Output: the change from the previous year as a % of the previous year
+
+  @param cumulativeSum
+    Output: the sum of the readings up to and including each one
+
+  @example
+    unsigned int years[] = {2000, 2001, 2002};
+    double values[] = {10, 20, 60};
+    double average[3], change[3];
+    BethYw::transformSeries(years, values, 3, 2, average, change, nullptr, nullptr);
+    // average == {NaN, 15, 40}, change == {NaN, 10, 40}
+*/
+void BethYw::transformSeries(const unsigned int* years,
+                             const double* values,
+                             std::size_t count,
+                             unsigned int window,
+                             double* movingAverage,
+                             double* change,
+                             double* percentChange,
+                             double* cumulativeSum) {
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    window = std::max(window, 1u);
+
+    double windowSum = 0;
+    double total = 0;
+    std::size_t first = 0;
+
+    for (std::size_t i = 0; i < count; i++) {
+        total += values[i];
+        if (cumulativeSum)
+            cumulativeSum[i] = total;
+
+        if (movingAverage) {
+            windowSum += values[i];
+            while (years[first] + window <= years[i])
+                windowSum -= values[first++];
+            //the years are unique, so a full window has one reading per year
+            movingAverage[i] = i - first + 1 == window ? windowSum / window : missing;
+        }
+
+        bool consecutive = i > 0 && years[i] == years[i - 1] + 1;
+        double difference = consecutive ? values[i] - values[i - 1] : missing;
+        if (change)
+            change[i] = difference;
+        if (percentChange)
+            percentChange[i] = consecutive && values[i - 1] != 0 ? difference / values[i - 1] * 100 : missing;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declarations for the statistics calculated over a
+  Measure's readings, beyond the average and differences in Measure itself.
+
+  The calculations work on plain contiguous arrays of years and values (rather
+  than the Measure's map) with simple loops the compiler can vectorise, so the
+  same kernels serve one Measure or every Measure in an Areas object packed
+  into one pair of arrays.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace BethYw {
+
+/*
+  The summary statistics for one series of readings. Every value is 0 when it
+  cannot be calculated (e.g. there are no readings).
+*/
+struct Statistics {
+  // number of readings
+  std::size_t count = 0;
+
+  double mean = 0;
+  double median = 0;
+
+  // the 25th and 75th percentiles (the lower and upper quartiles)
+  double lowerQuartile = 0;
+  double upperQuartile = 0;
+
+  // the population standard deviation
+  double standardDeviation = 0;
+
+  // compound annual growth rate from the first to the last year, as a %
+  double growthRate = 0;
+
+  // least-squares slope of value against year, i.e. change per year
+  double trend = 0;
+
+  // the years with the smallest and largest values (the earliest on a tie)
+  unsigned int minimumYear = 0;
+  unsigned int maximumYear = 0;
+};
+
+/*
+  Which derived series to add for every Measure (see Areas::addTransforms()),
+  each calculated from a reading and the readings in the years before it.
+*/
+struct Transforms {
+  // the average over the last `window` years, e.g. a 3-year moving average
+  bool movingAverage = false;
+  unsigned int window = 3;
+
+  // the change from the year before (year-over-year), as a value and a %
+  bool change = false;
+  bool percentChange = false;
+
+  // the running total of the readings so far
+  bool cumulativeSum = false;
+
+  bool any() const;
+};
+
+/*----Kernels----*/
+Statistics calculateStatistics(const unsigned int* years, const double* values, std::size_t count);
+double percentile(const double* values, std::size_t count, double p);
+void transformSeries(const unsigned int* years,
+                     const double* values,
+                     std::size_t count,
+                     unsigned int window,
+                     double* movingAverage,
+                     double* change,
+                     double* percentChange,
+                     double* cumulativeSum);
+
+} // namespace BethYw
+
+#endif // STATISTICS_H_
@@ -0,0 +1,97 @@
+#ifndef SCRATCH_H_
+#define SCRATCH_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  A scratch directory for the tests that need dataset files of their own
+  (e.g. to change one and see it imported again). It is made when the
+  ScratchDir is made and removed, with every file in it the test named, when
+  it goes out of scope, even if a REQUIRE fails part of the way through.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class ScratchDir {
+private:
+  std::string root;
+  std::vector<std::string> files;
+  std::vector<std::string> dirs;
+
+  static void makeDirectory(const std::string& dir) {
+#ifdef _WIN32
+    ::_mkdir(dir.c_str());
+#else
+    ::mkdir(dir.c_str(), 0755);
+#endif
+  }
+
+  static void removeDirectory(const std::string& dir) {
+#ifdef _WIN32
+    ::_rmdir(dir.c_str());
+#else
+    ::rmdir(dir.c_str());
+#endif
+  }
+
+public:
+  // dir ends in a '/', e.g. "bethyw-test-watch/"
+  explicit ScratchDir(const std::string& dir) : root(dir) {
+    makeDirectory(root);
+  }
+
+  ~ScratchDir() {
+    for (auto file = files.rbegin(); file != files.rend(); file++)
+      std::remove(file->c_str());
+    for (auto dir = dirs.rbegin(); dir != dirs.rend(); dir++)
+      removeDirectory(*dir);
+    removeDirectory(root);
+  }
+
+  ScratchDir(const ScratchDir&) = delete;
+  ScratchDir& operator=(const ScratchDir&) = delete;
+
+  // the directory, ending in a '/'
+  const std::string& dir() const { return root; }
+
+  // the path of a file in the directory, which is removed with it
+  std::string path(const std::string& file) {
+    return own(root + file);
+  }
+
+  // a path (e.g. of an index the code under test writes) to remove with the
+  // directory
+  std::string own(const std::string& path) {
+    files.push_back(path);
+    return files.back();
+  }
+
+  // the path of a directory inside it that the code under test makes, which
+  // is removed (once empty) with it
+  std::string subdir(const std::string& dir) {
+    dirs.push_back(root + dir);
+    return dirs.back();
+  }
+
+  // write a file in the directory
+  void write(const std::string& file, const std::string& contents) {
+    std::ofstream stream(path(file), std::ios::binary);
+    stream << contents;
+  }
+};
+
+#endif // SCRATCH_H_
@@ -0,0 +1,156 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../output.h"
+
+SCENARIO( "Areas can be streamed as JSON without building a json object", "[Areas][json]" ) {
+
+  auto get_istream = [](const std::string &path) {
+    return std::ifstream(path);
+  };
+
+  GIVEN( "an Areas instance populated from areas.csv and popu1009.json" ) {
+
+    Areas areas = Areas();
+
+    auto areasStream = get_istream("datasets/areas.csv");
+    auto dataStream  = get_istream("datasets/popu1009.json");
+
+    REQUIRE( areasStream.is_open() );
+    REQUIRE( dataStream.is_open() );
+
+    std::unordered_set<std::string> areasFilter(0);
+    std::unordered_set<std::string> measuresFilter(0);
+    std::tuple<unsigned int, unsigned int> yearsFilter = std::make_tuple(0,0);
+
+    areas.populateFromAuthorityCodeCSV(areasStream, BethYw::InputFiles::AREAS.COLS, &areasFilter);
+    areas.populateFromWelshStatsJSON(dataStream, BethYw::InputFiles::DATASETS[0].COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+    THEN( "the streamed JSON is the same as dumping it with the JSON library" ) {
+
+      std::ostringstream os;
+      areas.toJSON(os);
+
+      REQUIRE( os.str() == nlohmann::json::parse(os.str()).dump() );
+      REQUIRE( os.str() == areas.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an empty Areas instance" ) {
+
+    Areas areas = Areas();
+
+    THEN( "the streamed JSON is an empty object" ) {
+
+      std::ostringstream os;
+      areas.toJSON(os);
+
+      REQUIRE( os.str() == "{}" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "single JSON values are written the same way as the JSON library", "[json]" ) {
+
+  GIVEN( "strings that need escaping" ) {
+
+    const std::string value = "Ynys Môn \"quoted\" \\ \t\n\x01";
+
+    THEN( "they are escaped like nlohmann::json::dump()" ) {
+
+      std::ostringstream os;
+      BethYw::writeJSONString(os, value);
+
+      REQUIRE( os.str() == nlohmann::json(value).dump() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "whole, fractional and very large numbers" ) {
+
+    const double values[] = {68592.0, 711.6801, 0.1, -0.0, 1e300, 12345678.9, 98.195805, 1e-5, 0.0001,
+                             1e15, 1e16, 5e-324, 1.7976931348623157e308, -2.5e-7, 123456789012345678.0};
+
+    THEN( "they are formatted like nlohmann::json::dump()" ) {
+
+      for (double value : values) {
+        std::ostringstream os;
+        BethYw::writeJSONNumber(os, value);
+
+        REQUIRE( os.str() == nlohmann::json(value).dump() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas can be streamed as newline-delimited JSON", "[Areas][ndjson]" ) {
+
+  GIVEN( "an Areas instance with two Areas" ) {
+
+    Areas areas = Areas();
+
+    Area first("W06000011");
+    first.setName("eng", "Swansea");
+    Measure pop("Pop", "Population");
+    pop.setValue(1991, 69123);
+    first.setMeasure("Pop", pop);
+    areas.setArea("W06000011", first);
+
+    Area second("W06000012");
+    second.setName("eng", "Neath Port Talbot");
+    areas.setArea("W06000012", second);
+
+    THEN( "there is one line per Area, matching that Area's JSON" ) {
+
+      std::ostringstream os;
+      areas.toNDJSON(os);
+
+      REQUIRE( os.str() ==
+        "{\"W06000011\":{\"measures\":{\"pop\":{\"1991\":69123.0}},\"names\":{\"eng\":\"Swansea\"}}}\n"
+        "{\"W06000012\":{\"names\":{\"eng\":\"Neath Port Talbot\"}}}\n" );
+
+    } // THEN
+
+    THEN( "there can be one line per Measure instead" ) {
+
+      std::ostringstream os;
+      areas.toNDJSON(os, true);
+
+      REQUIRE( os.str() ==
+        "{\"area\":\"W06000011\",\"measure\":\"pop\",\"label\":\"Population\",\"values\":{\"1991\":69123.0}}\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
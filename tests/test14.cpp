@@ -0,0 +1,100 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "../measure.h"
+#include "../output.h"
+
+SCENARIO( "doubles are formatted the same as std::to_string", "[output][table]" ) {
+
+  GIVEN( "a mix of values including rounding edge cases" ) {
+
+    const double values[] = {0.0, -0.0, 711.6801, 97.126504, 69123.0, -999.0,
+                             0.0000005, 0.0000015, 2.5e-7, -1e-7, 123456789.123456,
+                             1e300, -1e20, 5791.191191, 1.330961,
+                             std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::quiet_NaN()};
+
+    THEN( "formatFixed() gives exactly the same characters" ) {
+
+      for (double value : values) {
+        char buffer[BethYw::FIXED_BUFFER_SIZE];
+        char* end = BethYw::formatFixed(buffer, value);
+
+        REQUIRE( std::string(buffer, end) == std::to_string(value) );
+      }
+
+    } // THEN
+
+    THEN( "formatFixed() agrees with std::to_string across a range of values" ) {
+
+      for (int i = -20000; i < 20000; i++) {
+        double value = i * 0.0137 + i * i * 0.5;
+        char buffer[BethYw::FIXED_BUFFER_SIZE];
+        char* end = BethYw::formatFixed(buffer, value);
+
+        REQUIRE( std::string(buffer, end) == std::to_string(value) );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a Measure is printed as a right-aligned table", "[Measure][table]" ) {
+
+  GIVEN( "a Measure with two readings" ) {
+
+    Measure measure("Pop", "Population");
+    measure.setValue(1991, 69123);
+    measure.setValue(1992, 69379);
+
+    THEN( "each heading is padded to the width of its value" ) {
+
+      std::ostringstream os;
+      os << measure;
+
+      REQUIRE( os.str() ==
+        "Population (pop) \n"
+        "        1991         1992      Average      Diff.  % Diff. \n"
+        "69123.000000 69379.000000 69251.000000 256.000000 0.370354 \n"
+        "\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure with no readings" ) {
+
+    Measure measure("Pop", "Population");
+
+    THEN( "<no data> is printed" ) {
+
+      std::ostringstream os;
+      os << measure;
+
+      REQUIRE( os.str() == "Population (pop) \n<no data>\n\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,156 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../areas.h"
+
+SCENARIO( "Areas can be written as CSV and TSV", "[Areas][csv]" ) {
+
+  GIVEN( "an Areas instance with two Measures in one Area" ) {
+
+    Areas areas = Areas();
+
+    Area area("W06000011");
+    Measure pop("Pop", "Population");
+    pop.setValue(1991, 69123);
+    pop.setValue(1993, 69772.5);
+    Measure dens("Dens", "Population density");
+    dens.setValue(1992, 97.126504);
+    area.setMeasure("Pop", pop);
+    area.setMeasure("Dens", dens);
+    areas.setArea("W06000011", area);
+
+    THEN( "the long CSV format has one row per reading" ) {
+
+      std::ostringstream os;
+      areas.toCSV(os);
+
+      REQUIRE( os.str() ==
+        "area,measure,year,value\n"
+        "W06000011,dens,1992,97.126504\n"
+        "W06000011,pop,1991,69123.0\n"
+        "W06000011,pop,1993,69772.5\n" );
+
+    } // THEN
+
+    THEN( "the wide TSV format has one column per year with gaps left empty" ) {
+
+      std::ostringstream os;
+      areas.toWideCSV(os, '\t');
+
+      REQUIRE( os.str() ==
+        "area\tmeasure\t1991\t1992\t1993\n"
+        "W06000011\tdens\t\t97.126504\t\n"
+        "W06000011\tpop\t69123.0\t\t69772.5\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure codename containing the delimiter" ) {
+
+    Areas areas = Areas();
+
+    Area area("W06000011");
+    Measure measure("a,b", "Odd codename");
+    measure.setValue(2000, 1);
+    area.setMeasure("a,b", measure);
+    areas.setArea("W06000011", area);
+
+    THEN( "the field is quoted in CSV but not in TSV" ) {
+
+      std::ostringstream csv;
+      areas.toCSV(csv);
+      std::ostringstream tsv;
+      areas.toCSV(tsv, '\t');
+
+      REQUIRE( csv.str() == "area,measure,year,value\nW06000011,\"a,b\",2000,1.0\n" );
+      REQUIRE( tsv.str() == "area\tmeasure\tyear\tvalue\nW06000011\ta,b\t2000\t1.0\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas can be written as an Arrow IPC stream", "[Areas][arrow]" ) {
+
+  GIVEN( "an Areas instance with one Measure in one Area" ) {
+
+    Areas areas = Areas();
+
+    Area area("W06000011");
+    Measure pop("Pop", "Population");
+    pop.setValue(1991, 69123);
+    pop.setValue(1992, 69379);
+    area.setMeasure("Pop", pop);
+    areas.setArea("W06000011", area);
+
+    std::ostringstream os;
+    areas.toArrow(os);
+    const std::string stream = os.str();
+
+    THEN( "the stream is made of 8 byte aligned messages" ) {
+
+      REQUIRE( stream.size() % 8 == 0 );
+      REQUIRE( stream.substr(0, 4) == std::string(4, '\xFF') );
+
+    } // THEN
+
+    THEN( "the stream ends with the end-of-stream marker" ) {
+
+      REQUIRE( stream.substr(stream.size() - 8) == std::string(4, '\xFF') + std::string(4, '\0') );
+
+    } // THEN
+
+    THEN( "the dictionaries and the values are in the stream" ) {
+
+      REQUIRE( stream.find("W06000011") != std::string::npos );
+      REQUIRE( stream.find("pop") != std::string::npos );
+
+      double value = 69379;
+      REQUIRE( stream.find(std::string(reinterpret_cast<const char*>(&value), sizeof(value))) != std::string::npos );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Areas instance with a reading for a year past 65535" ) {
+
+    Areas areas = Areas();
+
+    Area area("W06000011");
+    Measure pop("Pop", "Population");
+    pop.setValue(1991, 69123);
+    pop.setValue(100000, 1);
+    area.setMeasure("Pop", pop);
+    areas.setArea("W06000011", area);
+
+    std::ostringstream os;
+    areas.toArrow(os);
+
+    THEN( "the years are written whole as uint32 little-endian" ) {
+
+      const std::string years("\xC7\x07\x00\x00\xA0\x86\x01\x00", 8);
+      REQUIRE( os.str().find(years) != std::string::npos );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,178 @@
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+
+#include "../areas.h"
+#include "../measure.h"
+#include "../statistics.h"
+
+SCENARIO( "a Measure keeps its summary statistics up to date", "[Measure][statistics]" ) {
+
+  GIVEN( "a Measure with three readings" ) {
+
+    Measure measure("pop", "Population");
+    measure.setValue(2001, 20);
+    measure.setValue(1999, 10);
+    measure.setValue(2000, 30);
+
+    THEN( "the average, range and years are correct" ) {
+
+      REQUIRE( measure.getAverage() == Approx(20) );
+      REQUIRE( measure.getMinimum() == 10 );
+      REQUIRE( measure.getMaximum() == 30 );
+      REQUIRE( measure.getFirstYear() == 1999 );
+      REQUIRE( measure.getLastYear() == 2001 );
+      REQUIRE( measure.getDifference() == Approx(10) );
+      REQUIRE( measure.getDifferenceAsPercentage() == Approx(100) );
+
+    } // THEN
+
+    WHEN( "the maximum is replaced by a smaller value" ) {
+
+      measure.setValue(2000, 15);
+
+      THEN( "the average and range are updated" ) {
+
+        REQUIRE( measure.getAverage() == Approx(15) );
+        REQUIRE( measure.getMinimum() == 10 );
+        REQUIRE( measure.getMaximum() == 20 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "another Measure is merged in" ) {
+
+      Measure other("pop", "Population");
+      other.setValue(2000, 1000);
+      other.setValue(2002, 2);
+      measure.merge(other);
+
+      THEN( "only the new years are added to the statistics" ) {
+
+        REQUIRE( measure.size() == 4 );
+        REQUIRE( measure.getAverage() == Approx(15.5) );
+        REQUIRE( measure.getMinimum() == 2 );
+        REQUIRE( measure.getMaximum() == 30 );
+        REQUIRE( measure.getLastYear() == 2002 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure with no readings" ) {
+
+    Measure measure("pop", "Population");
+
+    THEN( "every statistic is 0" ) {
+
+      REQUIRE( measure.getAverage() == 0 );
+      REQUIRE( measure.getDifference() == 0 );
+      REQUIRE( measure.getDifferenceAsPercentage() == 0 );
+      REQUIRE( measure.getMinimum() == 0 );
+      REQUIRE( measure.getFirstYear() == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "extended statistics can be calculated for a Measure", "[Measure][statistics]" ) {
+
+  GIVEN( "a Measure with five readings" ) {
+
+    Measure measure("pop", "Population");
+    measure.setValue(2000, 100);
+    measure.setValue(2001, 90);
+    measure.setValue(2002, 130);
+    measure.setValue(2003, 120);
+    measure.setValue(2004, 146.41);
+
+    auto stats = measure.getStatistics();
+
+    THEN( "the median, quartiles and standard deviation are correct" ) {
+
+      REQUIRE( stats.count == 5 );
+      REQUIRE( stats.median == Approx(120) );
+      REQUIRE( stats.lowerQuartile == Approx(100) );
+      REQUIRE( stats.upperQuartile == Approx(130) );
+      REQUIRE( stats.standardDeviation == Approx(20.300495) );
+
+    } // THEN
+
+    THEN( "the growth rate, trend and years of the extremes are correct" ) {
+
+      REQUIRE( stats.growthRate == Approx(10) );
+      REQUIRE( stats.trend == Approx(12.282) );
+      REQUIRE( stats.minimumYear == 2001 );
+      REQUIRE( stats.maximumYear == 2004 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "unsorted values" ) {
+
+    const double values[] = {4, 1, 3, 2};
+
+    THEN( "any percentile can be found, interpolating between ranks" ) {
+
+      REQUIRE( BethYw::percentile(values, 4, 50) == Approx(2.5) );
+      REQUIRE( BethYw::percentile(values, 4, 0) == Approx(1) );
+      REQUIRE( BethYw::percentile(values, 4, 100) == Approx(4) );
+      REQUIRE( BethYw::percentile(values, 4, 90) == Approx(3.7) );
+      REQUIRE( BethYw::percentile(values, 0, 50) == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Areas instance with two Areas" ) {
+
+    Areas areas = Areas();
+
+    Area first("W06000011");
+    Measure pop("pop", "Population");
+    pop.setValue(2000, 1);
+    pop.setValue(2001, 5);
+    first.setMeasure("pop", pop);
+    areas.setArea("W06000011", first);
+
+    Area second("W06000012");
+    Measure dens("dens", "Population density");
+    dens.setValue(1999, 7);
+    second.setMeasure("dens", dens);
+    second.setMeasure("pop", pop);
+    areas.setArea("W06000012", second);
+
+    THEN( "the batch statistics match those of each Measure" ) {
+
+      auto stats = areas.getStatistics();
+
+      REQUIRE( stats.size() == 2 );
+      REQUIRE( stats["W06000011"]["pop"].median == Approx(pop.getStatistics().median) );
+      REQUIRE( stats["W06000011"]["pop"].trend == Approx(4) );
+      REQUIRE( stats["W06000012"]["dens"].mean == Approx(7) );
+      REQUIRE( stats["W06000012"]["pop"].maximumYear == 2001 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,77 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+
+#include "../areas.h"
+
+SCENARIO( "Areas can be ranked by the value of a Measure in one year", "[Areas][rank]" ) {
+
+  GIVEN( "an Areas instance with four Areas, one without a value for the year" ) {
+
+    Areas areas = Areas();
+
+    const std::string codes[] = {"W06000001", "W06000002", "W06000003", "W06000004"};
+    const double values[] = {25.5, 99, 25.5, 7};
+    for (unsigned int i = 0; i < 4; i++) {
+      Area area(codes[i]);
+      Measure dens("Dens", "Population density");
+      dens.setValue(i == 3 ? 2018 : 2019, values[i]);
+      area.setMeasure("Dens", dens);
+      areas.setArea(codes[i], area);
+    }
+
+    THEN( "the highest values come first, with ties going to the lower code" ) {
+
+      auto ranking = areas.rank("DENS", 2019, 2);
+
+      REQUIRE( ranking.size() == 2 );
+      REQUIRE( ranking[0].area->getLocalAuthorityCode() == "W06000002" );
+      REQUIRE( ranking[0].value == 99 );
+      REQUIRE( ranking[1].area->getLocalAuthorityCode() == "W06000001" );
+      REQUIRE( ranking[1].value == 25.5 );
+
+    } // THEN
+
+    THEN( "the lowest values can come first instead" ) {
+
+      auto ranking = areas.rank("dens", 2019, 10, false);
+
+      REQUIRE( ranking.size() == 3 );
+      REQUIRE( ranking[0].area->getLocalAuthorityCode() == "W06000001" );
+      REQUIRE( ranking[1].area->getLocalAuthorityCode() == "W06000003" );
+      REQUIRE( ranking[2].area->getLocalAuthorityCode() == "W06000002" );
+
+    } // THEN
+
+    THEN( "the ranking points at the Areas inside the Areas instance" ) {
+
+      auto ranking = areas.rank("dens", 2019, 1);
+
+      REQUIRE( ranking[0].area == &areas.getAreas().at("W06000002") );
+
+    } // THEN
+
+    THEN( "an unknown measure or year gives an empty ranking" ) {
+
+      REQUIRE( areas.rank("pop", 2019, 5).empty() );
+      REQUIRE( areas.rank("dens", 1990, 5).empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
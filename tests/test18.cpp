@@ -0,0 +1,191 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "../areas.h"
+#include "../expression.h"
+
+SCENARIO( "measure expressions can be parsed and evaluated", "[expression]" ) {
+
+  GIVEN( "an expression using precedence, brackets and unary minus" ) {
+
+    BethYw::Expression expression("(Rail + bus) * 2 - -rail / 4");
+
+    THEN( "each measure is listed once, in lowercase" ) {
+
+      REQUIRE( expression.getMeasures() == std::vector<std::string>({"rail", "bus"}) );
+
+    } // THEN
+
+    THEN( "it is evaluated with the usual precedence" ) {
+
+      double values[] = {8, 2};
+      REQUIRE( expression.evaluate(values) == 22 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "invalid expressions and definitions" ) {
+
+    THEN( "they throw std::invalid_argument" ) {
+
+      REQUIRE_THROWS_AS( BethYw::Expression("pop /"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Expression("(pop"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Expression("pop area"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Expression("1 + 2"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::parseDerivation("pop / area"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::parseDerivation("1pop = pop"), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "expressions with brackets nested up to and past the limit" ) {
+
+    auto nested = [](unsigned int depth) {
+      return std::string(depth, '(') + "pop" + std::string(depth, ')');
+    };
+
+    THEN( "only those nested too deeply throw std::invalid_argument" ) {
+
+      REQUIRE( BethYw::Expression(nested(BethYw::MAX_EXPRESSION_DEPTH)).getMeasures().size() == 1 );
+      REQUIRE( BethYw::Expression(std::string(BethYw::MAX_EXPRESSION_DEPTH, '-') + "pop")
+                 .getMeasures().size() == 1 );
+      REQUIRE_THROWS_AS( BethYw::Expression(nested(BethYw::MAX_EXPRESSION_DEPTH + 1)), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Expression(nested(30000)), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Expression(std::string(30000, '-') + "pop"), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a definition with spaces" ) {
+
+    auto derivation = BethYw::parseDerivation(" PopDen = pop / area ");
+
+    THEN( "the codename is lowercase and the expression is trimmed" ) {
+
+      REQUIRE( derivation.codename == "popden" );
+      REQUIRE( derivation.expression.getText() == "pop / area" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "derived measures are calculated when they are defined", "[Areas][Area][derived]" ) {
+
+  GIVEN( "an Areas instance where only one Area has both pop and area" ) {
+
+    Areas areas = Areas();
+
+    Area swansea("W06000011");
+    Measure pop("Pop", "Population");
+    pop.setValue(1991, 169725);
+    pop.setValue(2019, 188771);
+    pop.setValue(2020, 190000);
+    Measure size("Area", "Land area");
+    size.setValue(1991, 2370.2762);
+    size.setValue(2019, 2370.2762);
+    size.setValue(2021, 0);
+    swansea.setMeasure("Pop", pop);
+    swansea.setMeasure("Area", size);
+    areas.setArea("W06000011", swansea);
+
+    Area powys("W06000023");
+    powys.setMeasure("Pop", pop);
+    areas.setArea("W06000023", powys);
+
+    THEN( "it is only defined for the Area with the inputs" ) {
+
+      REQUIRE( areas.defineMeasure("popden = pop / area") == 1 );
+      REQUIRE( areas.getArea("W06000011").size() == 3 );
+      REQUIRE( areas.getArea("W06000023").size() == 1 );
+      REQUIRE( areas.getArea("W06000023").findMeasure("popden") == nullptr );
+
+    } // THEN
+
+    THEN( "it has a value for each year that every input has" ) {
+
+      areas.defineMeasure("popden = pop / area");
+      auto& popden = areas.getArea("W06000011").getMeasure("PopDen");
+
+      REQUIRE( popden.size() == 2 );
+      REQUIRE( popden.getValue(2019) == Approx(79.64093) );
+      REQUIRE( popden.getLabel() == "pop / area" );
+
+    } // THEN
+
+    THEN( "it is only calculated once" ) {
+
+      areas.defineMeasure("popden = pop / area");
+      const Area& area = areas.getArea("W06000011");
+
+      REQUIRE( area.findMeasure("popden") == area.findMeasure("popden") );
+
+    } // THEN
+
+    THEN( "it can be built on by another derived measure" ) {
+
+      areas.defineMeasure("popden = pop / area");
+      areas.defineMeasure("per_km = popden * 100");
+
+      REQUIRE( areas.getArea("W06000011").getMeasure("per_km").getValue(2019) == Approx(7964.093) );
+
+    } // THEN
+
+    THEN( "it is calculated again when one of its inputs is set" ) {
+
+      areas.defineMeasure("popden = pop / area");
+      areas.defineMeasure("per_km = popden * 100");
+      Measure more("Pop", "Population");
+      more.setValue(2019, 237027.62);
+      Area& area = areas.getArea("W06000011");
+      area.setMeasure("pop", more);
+
+      REQUIRE( area.getMeasure("popden").getValue(2019) == Approx(100) );
+      REQUIRE( area.getMeasure("per_km").getValue(2019) == Approx(10000) );
+      REQUIRE( area.getMeasure("popden").getValue(1991) == Approx(71.605579) );
+
+    } // THEN
+
+    THEN( "setting it directly makes it ordinary data" ) {
+
+      areas.defineMeasure("popden = pop / area");
+      Measure popden("popden", "Set");
+      popden.setValue(2019, 1);
+      areas.getArea("W06000011").setMeasure("popden", popden);
+      areas.getArea("W06000011").setMeasure("pop", pop);
+
+      REQUIRE( areas.getArea("W06000011").getMeasure("popden").getValue(2019) == 1 );
+
+    } // THEN
+
+    THEN( "it is included in the JSON output" ) {
+
+      areas.defineMeasure("popden = pop / area");
+
+      REQUIRE( areas.getArea("W06000011").toJSON().find("\"popden\":{\"1991\":71.605579") != std::string::npos );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,124 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <string>
+
+#include "../areas.h"
+#include "../statistics.h"
+
+SCENARIO( "derived series can be calculated in one pass over the readings", "[statistics][transform]" ) {
+
+  GIVEN( "readings with a gap between 2002 and 2005" ) {
+
+    const unsigned int years[] = {2000, 2001, 2002, 2005, 2006, 2007};
+    const double values[] = {10, 20, 60, 0, 5, 10};
+    double average[6], change[6], percent[6], total[6];
+
+    BethYw::transformSeries(years, values, 6, 3, average, change, percent, total);
+
+    THEN( "the moving average needs a reading in every year of the window" ) {
+
+      REQUIRE( std::isnan(average[0]) );
+      REQUIRE( std::isnan(average[1]) );
+      REQUIRE( average[2] == 30 );
+      REQUIRE( std::isnan(average[3]) );
+      REQUIRE( std::isnan(average[4]) );
+      REQUIRE( average[5] == 5 );
+
+    } // THEN
+
+    THEN( "the changes need a reading in the year before" ) {
+
+      REQUIRE( std::isnan(change[0]) );
+      REQUIRE( change[1] == 10 );
+      REQUIRE( change[2] == 40 );
+      REQUIRE( std::isnan(change[3]) );
+      REQUIRE( change[4] == 5 );
+
+      REQUIRE( percent[1] == 100 );
+      REQUIRE( percent[2] == 200 );
+      REQUIRE( std::isnan(percent[4]) ); // from 0
+      REQUIRE( percent[5] == 100 );
+
+    } // THEN
+
+    THEN( "the cumulative sum adds up every reading" ) {
+
+      REQUIRE( total[2] == 90 );
+      REQUIRE( total[5] == 105 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas can add derived series of every Measure", "[Areas][transform]" ) {
+
+  GIVEN( "an Areas instance with one Measure" ) {
+
+    Areas areas = Areas();
+
+    Area area("W06000011");
+    Measure pop("Pop", "Population");
+    pop.setValue(2000, 100);
+    pop.setValue(2001, 110);
+    pop.setValue(2002, 121);
+    area.setMeasure("Pop", pop);
+    areas.setArea("W06000011", area);
+
+    WHEN( "every transform is added" ) {
+
+      BethYw::Transforms transforms;
+      transforms.movingAverage = true;
+      transforms.window = 2;
+      transforms.change = true;
+      transforms.percentChange = true;
+      transforms.cumulativeSum = true;
+      areas.addTransforms(transforms);
+
+      auto& result = areas.getArea("W06000011");
+
+      THEN( "there is a new Measure for each" ) {
+
+        REQUIRE( result.size() == 5 );
+        REQUIRE( result.getMeasure("pop_ma2").getLabel() == "Population (2-year moving average)" );
+        REQUIRE( result.getMeasure("pop_ma2").getValue(2002) == 115.5 );
+        REQUIRE( result.getMeasure("pop_yoy").size() == 2 );
+        REQUIRE( result.getMeasure("pop_yoy").getValue(2002) == 11 );
+        REQUIRE( result.getMeasure("pop_yoypct").getValue(2001) == Approx(10) );
+        REQUIRE( result.getMeasure("pop_cumsum").getValue(2002) == 331 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "no transforms are asked for" ) {
+
+      areas.addTransforms(BethYw::Transforms());
+
+      THEN( "nothing is added" ) {
+
+        REQUIRE( areas.getArea("W06000011").size() == 1 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,111 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "../areas.h"
+#include "../correlation.h"
+
+SCENARIO( "measures can be correlated over the areas and years they share", "[Areas][correlation]" ) {
+
+  GIVEN( "two Areas with three Measures, one of them in different years" ) {
+
+    Areas areas = Areas();
+
+    for (unsigned int i = 0; i < 2; i++) {
+      std::string code = "W0600001" + std::to_string(i);
+      Area area(code);
+      Measure x("x", "X");
+      Measure y("y", "Y");
+      Measure z("z", "Z");
+      for (unsigned int year = 2000; year < 2003; year++) {
+        double value = i * 3 + (year - 2000);
+        x.setValue(year, value);
+        y.setValue(year, value * value); // increasing, but not linearly
+        z.setValue(year + 10, value);
+      }
+      area.setMeasure("x", x);
+      area.setMeasure("y", y);
+      area.setMeasure("z", z);
+      areas.setArea(code, area);
+    }
+
+    THEN( "Pearson's correlation is less than 1 for a non-linear relationship" ) {
+
+      auto matrix = areas.correlate(BethYw::CorrelationMethod::Pearson, 2);
+
+      REQUIRE( matrix.measures == std::vector<std::string>({"x", "y", "z"}) );
+      REQUIRE( matrix.getCoefficient(0, 0) == Approx(1) );
+      REQUIRE( matrix.getCoefficient(0, 1) == Approx(0.9598832853) );
+      REQUIRE( matrix.getCoefficient(1, 0) == matrix.getCoefficient(0, 1) );
+      REQUIRE( matrix.getCount(0, 1) == 6 );
+
+    } // THEN
+
+    THEN( "Spearman's correlation is 1 for any increasing relationship" ) {
+
+      auto matrix = areas.correlate(BethYw::CorrelationMethod::Spearman, 1);
+
+      REQUIRE( matrix.getCoefficient(0, 1) == Approx(1) );
+
+    } // THEN
+
+    THEN( "measures with no years in common can't be correlated" ) {
+
+      auto matrix = areas.correlate(BethYw::CorrelationMethod::Pearson);
+
+      REQUIRE( matrix.getCount(0, 2) == 0 );
+      REQUIRE( std::isnan(matrix.getCoefficient(0, 2)) );
+
+      std::ostringstream os;
+      BethYw::writeCorrelationJSON(os, matrix);
+      REQUIRE( os.str().find("\"x\":{\"x\":1.0,") != std::string::npos );
+      REQUIRE( os.str().find("\"z\":null}") != std::string::npos );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the correlation kernel gives the same results with any number of threads", "[correlation]" ) {
+
+  GIVEN( "more columns than fit in one block" ) {
+
+    const std::size_t rows = 50;
+    const std::size_t count = 20;
+    std::vector<double> columns(rows * count);
+    for (std::size_t i = 0; i < columns.size(); i++)
+      columns[i] = std::sin(i * 0.7) * (i % 7) + (i % 13 == 0 ? NAN : 0);
+
+    THEN( "one thread and four threads agree" ) {
+
+      std::vector<double> one(count * count), four(count * count);
+      std::vector<std::size_t> oneCounts(count * count), fourCounts(count * count);
+      BethYw::correlateColumns(columns.data(), rows, count, BethYw::CorrelationMethod::Spearman, one.data(), oneCounts.data(), 1);
+      BethYw::correlateColumns(columns.data(), rows, count, BethYw::CorrelationMethod::Spearman, four.data(), fourCounts.data(), 4);
+
+      REQUIRE( oneCounts == fourCounts );
+      for (std::size_t i = 0; i < one.size(); i++)
+        REQUIRE( (one[i] == four[i] || (std::isnan(one[i]) && std::isnan(four[i]))) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
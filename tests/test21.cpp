@@ -0,0 +1,168 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../sketch.h"
+
+SCENARIO( "a t-digest estimates quantiles and can be merged", "[sketch][tdigest]" ) {
+
+  GIVEN( "the values 1 to 10000, split between two digests" ) {
+
+    BethYw::TDigest odd, even;
+    for (unsigned int i = 1; i <= 10000; i++)
+      (i % 2 ? odd : even).add(i);
+
+    odd.merge(even);
+
+    THEN( "it counts every value and keeps the minimum and maximum exactly" ) {
+
+      REQUIRE( odd.count() == 10000 );
+      REQUIRE( odd.getMinimum() == 1 );
+      REQUIRE( odd.getMaximum() == 10000 );
+      REQUIRE( odd.quantile(0) == 1 );
+      REQUIRE( odd.quantile(1) == 10000 );
+
+    } // THEN
+
+    THEN( "the quantiles are close, and closest at the ends" ) {
+
+      REQUIRE( odd.quantile(0.5) == Approx(5000).epsilon(0.01) );
+      REQUIRE( odd.quantile(0.25) == Approx(2500).epsilon(0.01) );
+      REQUIRE( odd.quantile(0.99) == Approx(9900).epsilon(0.001) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a digest with values still buffered, read from several threads" ) {
+
+    BethYw::TDigest digest;
+    for (unsigned int i = 1; i <= 100; i++)
+      digest.add(i);
+    const BethYw::TDigest& shared = digest;
+    double expected = shared.quantile(0.5);
+
+    std::vector<double> medians(4);
+    std::vector<std::thread> readers;
+    for (std::size_t t = 0; t < medians.size(); t++)
+      readers.emplace_back([&shared, &medians, t]() {
+        for (unsigned int i = 0; i < 100; i++)
+          medians[t] = shared.quantile(0.5);
+      });
+    for (auto& reader : readers)
+      reader.join();
+
+    THEN( "every thread gets the same quantile, as reading it doesn't change the digest" ) {
+
+      for (auto median : medians)
+        REQUIRE( median == expected );
+      REQUIRE( expected == Approx(50.5) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an empty digest" ) {
+
+    BethYw::TDigest digest;
+
+    THEN( "it has no quantiles" ) {
+
+      REQUIRE( std::isnan(digest.quantile(0.5)) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a HyperLogLog estimates the number of distinct values", "[sketch][hyperloglog]" ) {
+
+  GIVEN( "a few values added more than once" ) {
+
+    BethYw::HyperLogLog counter;
+    for (unsigned int repeat = 0; repeat < 3; repeat++)
+      for (unsigned int i = 0; i < 22; i++)
+        counter.add("W060000" + std::to_string(i));
+
+    THEN( "the count is exact" ) {
+
+      REQUIRE( std::lround(counter.estimate()) == 22 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "100000 distinct values, split between two counters" ) {
+
+    BethYw::HyperLogLog a, b;
+    for (unsigned int i = 0; i < 100000; i++)
+      (i < 60000 ? a : b).add(std::to_string(i));
+
+    a.merge(b);
+
+    THEN( "the merged count is within 5%" ) {
+
+      REQUIRE( a.estimate() == Approx(100000).epsilon(0.05) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas can sketch the measures it imports", "[Areas][sketch]" ) {
+
+  GIVEN( "popu1009.json imported twice with sketching on" ) {
+
+    Areas areas = Areas();
+    areas.setSketching(true);
+
+    std::unordered_set<std::string> areasFilter(0);
+    std::unordered_set<std::string> measuresFilter(0);
+    std::tuple<unsigned int, unsigned int> yearsFilter = std::make_tuple(0,0);
+
+    for (unsigned int i = 0; i < 2; i++) {
+      std::ifstream stream("datasets/popu1009.json");
+      REQUIRE( stream.is_open() );
+      areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::DATASETS[0].COLS, &areasFilter, &measuresFilter, &yearsFilter);
+    }
+
+    THEN( "each reading is only sketched once" ) {
+
+      auto const& sketches = areas.getSketches();
+      REQUIRE( sketches.size() == 3 );
+
+      std::size_t readings = 0;
+      for (auto const& area : areas.getAreas())
+        readings += area.second.getMeasures().at("pop").size();
+
+      REQUIRE( sketches.at("pop").values.count() == readings );
+      REQUIRE( std::lround(sketches.at("pop").areas.estimate()) == areas.size() );
+      REQUIRE( sketches.at("pop").label == "Population" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,105 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../areas.h"
+#include "../parallel.h"
+
+SCENARIO( "tasks can be run on a pool of threads", "[parallel]" ) {
+
+  GIVEN( "100 tasks" ) {
+
+    THEN( "each one is run exactly once" ) {
+
+      std::vector<std::atomic<int>> runs(100);
+      BethYw::parallelFor(100, [&runs](std::size_t i) { runs[i]++; }, 4);
+
+      for (auto& run : runs)
+        REQUIRE( run == 1 );
+
+    } // THEN
+
+    THEN( "an exception thrown by a task is thrown again" ) {
+
+      REQUIRE_THROWS_AS( BethYw::parallelFor(100, [](std::size_t i) {
+        if (i == 42)
+          throw std::runtime_error("task failed");
+      }, 4), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "separately imported Areas are merged with each parser's precedence", "[Areas][merge]" ) {
+
+  auto makeAreas = [](unsigned int firstYear, unsigned int lastYear, double value) {
+    Areas areas = Areas();
+    Area area("W06000011");
+    Measure pop("Pop", "Population");
+    for (unsigned int year = firstYear; year <= lastYear; year++)
+      pop.setValue(year, value);
+    area.setMeasure("Pop", pop);
+    areas.setArea("W06000011", area);
+    return areas;
+  };
+
+  GIVEN( "an Areas instance with readings from 2000 to 2002" ) {
+
+    Areas areas = makeAreas(2000, 2002, 1);
+    Area named("W06000011");
+    named.setName("eng", "Swansea");
+    areas.setArea("W06000011", named);
+
+    WHEN( "readings from 2002 to 2003 from a JSON dataset are merged in" ) {
+
+      areas.merge(makeAreas(2002, 2003, 2), BethYw::WelshStatsJSON);
+      auto& pop = areas.getArea("W06000011").getMeasure("pop");
+
+      THEN( "the new readings replace the old ones for the same year only" ) {
+
+        REQUIRE( pop.size() == 4 );
+        REQUIRE( pop.getValue(2000) == 1 );
+        REQUIRE( pop.getValue(2002) == 2 );
+        REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "readings from 2002 to 2003 from a CSV dataset are merged in" ) {
+
+      areas.merge(makeAreas(2002, 2003, 2), BethYw::AuthorityByYearCSV);
+      auto& pop = areas.getArea("W06000011").getMeasure("pop");
+
+      THEN( "the new Measure replaces the old one" ) {
+
+        REQUIRE( pop.size() == 2 );
+        REQUIRE( pop.getValue(2002) == 2 );
+        REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
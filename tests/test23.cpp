@@ -0,0 +1,156 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../areas.h"
+#include "../catalogue.h"
+#include "../server.h"
+
+SCENARIO( "a filtered copy of an Areas instance can be selected", "[Areas][select]" ) {
+
+  GIVEN( "an Areas instance with two Areas, each with two Measures from 2000 to 2004" ) {
+
+    Areas areas = Areas();
+    for (auto code : {"W06000011", "W06000024"}) {
+      Area area(code);
+      area.setName("eng", code);
+      Measure pop("pop", "Population");
+      Measure dens("dens", "Population density");
+      for (unsigned int year = 2000; year <= 2004; year++) {
+        pop.setValue(year, year);
+        dens.setValue(year, year / 10.0);
+      }
+      area.setMeasure("pop", pop);
+      area.setMeasure("dens", dens);
+      areas.setArea(code, area);
+    }
+
+    WHEN( "one Area, one Measure and 2001 to 2002 are selected" ) {
+
+      StringFilterSet areasFilter = {"W06000024", "W06000099"};
+      StringFilterSet measuresFilter = {"pop"};
+      YearFilterTuple yearsFilter(2001, 2002);
+      Areas selected = areas.select(&areasFilter, &measuresFilter, &yearsFilter);
+
+      THEN( "only that data is copied" ) {
+
+        REQUIRE( selected.size() == 1 );
+        auto& area = selected.getArea("W06000024");
+        REQUIRE( area.getName("eng") == "W06000024" );
+        REQUIRE( area.size() == 1 );
+        REQUIRE( area.getMeasure("pop").size() == 2 );
+        REQUIRE( area.getMeasure("pop").getValue(2002) == 2002 );
+
+      } // THEN
+
+      THEN( "the original is unchanged" ) {
+
+        REQUIRE( areas.size() == 2 );
+        REQUIRE( areas.getArea("W06000024").getMeasure("pop").size() == 5 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "years with no readings are selected" ) {
+
+      YearFilterTuple yearsFilter(2010, 2012);
+      Areas selected = areas.select(nullptr, nullptr, &yearsFilter);
+
+      THEN( "the Measures are still copied, but empty, as the parsers would leave them" ) {
+
+        REQUIRE( selected.size() == 2 );
+        REQUIRE( selected.getArea("W06000011").size() == 2 );
+        REQUIRE( selected.getArea("W06000011").getMeasure("dens").size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a query line can be split into arguments", "[server][args]" ) {
+
+  GIVEN( "a query with spaces and quotes" ) {
+
+    auto arguments = BethYw::splitArguments("  -d popden   --derive 'x = pop * 2' -m\"pop\" ");
+
+    THEN( "it is split at the spaces outside the quotes, and the quotes removed" ) {
+
+      std::vector<std::string> expected = {"-d", "popden", "--derive", "x = pop * 2", "-mpop"};
+      REQUIRE( arguments == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a query with an unclosed quote" ) {
+
+    THEN( "an exception is thrown" ) {
+
+      REQUIRE_THROWS_AS( BethYw::splitArguments("--derive 'x = pop"), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "queries can be answered from the datasets in a Catalogue", "[server][Catalogue]" ) {
+
+  GIVEN( "a Catalogue of the datasets directory" ) {
+
+    BethYw::Catalogue catalogue("datasets/");
+
+    WHEN( "a query for one area of one dataset is answered" ) {
+
+      std::ostringstream answer;
+      BethYw::answerQuery(catalogue, "-d popden -a W06000011 -m pop -y 2010 -j", answer);
+
+      THEN( "the dataset is loaded and the answer is the filtered JSON" ) {
+
+        REQUIRE( catalogue.isLoaded("popden") );
+        REQUIRE_FALSE( catalogue.isLoaded("biz") );
+        REQUIRE( answer.str() ==
+          "{\"W06000011\":{\"measures\":{\"pop\":{\"2010\":237311.0}},"
+          "\"names\":{\"cym\":\"Abertawe\",\"eng\":\"Swansea\"}}}\n" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "an invalid query is answered" ) {
+
+      std::ostringstream answer;
+      BethYw::answerQuery(catalogue, "-d nothing", answer);
+
+      THEN( "the answer is the error" ) {
+
+        REQUIRE( answer.str() == "Error: No dataset matches key: nothing\n" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,107 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../catalogue.h"
+#include "../repl.h"
+
+SCENARIO( "commands typed into the shell work on the current selection", "[repl]" ) {
+
+  GIVEN( "a shell over the datasets directory" ) {
+
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::Selection selection;
+
+    WHEN( "the filter command is given arguments" ) {
+
+      std::ostringstream out;
+      REQUIRE( BethYw::runCommand(catalogue, selection, "filter -d popden -a W06000011 -y 2010", out) );
+
+      THEN( "the selection changes and is printed" ) {
+
+        REQUIRE( selection.datasets == std::vector<std::string>{"popden"} );
+        REQUIRE( selection.areasFilter.count("W06000011") == 1 );
+        REQUIRE( selection.yearsFilter == YearFilterTuple(2010, 2010) );
+        REQUIRE( out.str() == "datasets: popden | areas: W06000011 | measures: all | years: 2010\n" );
+
+      } // THEN
+
+      AND_WHEN( "the data is shown as JSON with a measure filter for that command only" ) {
+
+        out.str("");
+        BethYw::runCommand(catalogue, selection, "show -m pop -j", out);
+
+        THEN( "only the dataset asked for is loaded, and the output is the filtered JSON" ) {
+
+          REQUIRE( catalogue.isLoaded("popden") );
+          REQUIRE_FALSE( catalogue.isLoaded("trains") );
+          REQUIRE( out.str() ==
+            "{\"W06000011\":{\"measures\":{\"pop\":{\"2010\":237311.0}},"
+            "\"names\":{\"cym\":\"Abertawe\",\"eng\":\"Swansea\"}}}\n" );
+          REQUIRE( selection.measuresFilter.empty() );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "the filter is reset" ) {
+
+        out.str("");
+        BethYw::runCommand(catalogue, selection, "filter reset", out);
+
+        THEN( "everything is selected again" ) {
+
+          REQUIRE( out.str() == "datasets: all | areas: all | measures: all | years: all\n" );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "an unknown command or bad argument is given" ) {
+
+      std::ostringstream out;
+      BethYw::runCommand(catalogue, selection, "frobnicate", out);
+      BethYw::runCommand(catalogue, selection, "filter -d nothing", out);
+
+      THEN( "an error is printed and the selection is unchanged" ) {
+
+        REQUIRE( out.str() == "Error: Unknown command: frobnicate (try help)\n"
+                              "Error: No dataset matches key: nothing\n" );
+        REQUIRE( selection.datasets == std::vector<std::string>{"all"} );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "quit is given" ) {
+
+      std::ostringstream out;
+
+      THEN( "the shell is told to stop" ) {
+
+        REQUIRE_FALSE( BethYw::runCommand(catalogue, selection, "quit", out) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,162 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../catalogue.h"
+#include "../query.h"
+
+SCENARIO( "a query is planned when it is parsed", "[query]" ) {
+
+  GIVEN( "a query with conditions on area, measure, year and value" ) {
+
+    BethYw::Query query("SELECT area, year, value FROM all WHERE area IN (W06000011, W06000024) "
+                        "AND area = 'W06000011' AND measure = POP AND year BETWEEN 2010 AND 2019 "
+                        "AND year != 2015 AND value > 100 ORDER BY value DESC LIMIT 3");
+
+    THEN( "the conditions on area, measure and year become the import filters" ) {
+
+      auto const& selection = query.getSelection();
+      REQUIRE( selection.areasFilter == StringFilterSet{"W06000011"} );
+      REQUIRE( selection.measuresFilter == StringFilterSet{"pop"} );
+      REQUIRE( selection.yearsFilter == YearFilterTuple(2010, 2019) );
+      REQUIRE_FALSE( query.isEmpty() );
+
+    } // THEN
+
+    THEN( "the datasets with only another measure are skipped" ) {
+
+      REQUIRE( query.getSelection().datasets ==
+               std::vector<std::string>{"popden", "biz", "aqi", "complete-pop"} );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "queries whose conditions contradict each other" ) {
+
+    THEN( "they are known to be empty" ) {
+
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE area = A AND area = B").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year > 2015 AND year < 2012").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM trains WHERE measure = pop").isEmpty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "queries with year literals that no year can equal" ) {
+
+    THEN( "they are known to be empty, instead of importing every year" ) {
+
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year = -5").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year = 2010.5").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year = 1e30").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year > 1e30").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year < -1e30").isEmpty() );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year IN (-5, -3)").isEmpty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "queries with year literals partly outside the years there can be" ) {
+
+    THEN( "the range is cut to the years there can be" ) {
+
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year > -5").getSelection().yearsFilter
+               == YearFilterTuple(0, 0) );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year <= 1e30").getSelection().yearsFilter
+               == YearFilterTuple(0, 0) );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year BETWEEN -5 AND 2010.5").getSelection().yearsFilter
+               == YearFilterTuple(0, 2010) );
+      REQUIRE( BethYw::Query("SELECT * FROM popden WHERE year > 2010.5").getSelection().yearsFilter
+               == YearFilterTuple(2011, std::numeric_limits<unsigned int>::max()) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "queries that are not valid" ) {
+
+    THEN( "std::invalid_argument is thrown" ) {
+
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT FROM popden"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * popden"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM popden WHERE value >"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM popden WHERE area < 5"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM popden WHERE name = 'x'"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM popden LIMIT 2.5"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM popden WHERE area = 'x"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::Query("SELECT * FROM nothing"), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a query is run against the datasets it needs", "[query]" ) {
+
+  GIVEN( "a Catalogue over the datasets directory" ) {
+
+    BethYw::Catalogue catalogue("datasets/");
+
+    WHEN( "a query with a value condition, an order and a limit is run" ) {
+
+      std::ostringstream out;
+      BethYw::runQuery(catalogue,
+                       "select year, value from popden where area = W06000011 and measure = pop "
+                       "and year between 2010 and 2012 and value > 238000 order by value desc "
+                       "format csv",
+                       out);
+
+      THEN( "only the matching rows are written, in order" ) {
+
+        REQUIRE( out.str() == "year,value\n2012,239460.0\n2011,238691.0\n" );
+        REQUIRE_FALSE( catalogue.isLoaded("trains") );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a query is explained" ) {
+
+      std::ostringstream out;
+      BethYw::runQuery(catalogue, "EXPLAIN SELECT * FROM all WHERE measure = rail AND value > 5", out);
+
+      THEN( "the plan is written and nothing is imported" ) {
+
+        REQUIRE( out.str() == "import: popden, biz, aqi, trains\n"
+                              "skip: complete-popden, complete-pop, complete-area\n"
+                              "areas: all\n"
+                              "measures: rail\n"
+                              "years: all\n"
+                              "check: value > 5\n"
+                              "order: area, measure, year\n"
+                              "limit: none\n" );
+        REQUIRE_FALSE( catalogue.isLoaded("popden") );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
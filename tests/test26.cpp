@@ -0,0 +1,124 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../batch.h"
+#include "../catalogue.h"
+
+SCENARIO( "a batch file is read one job per line", "[batch]" ) {
+
+  GIVEN( "a batch file with comments, blank lines and a quoted file name" ) {
+
+    std::istringstream in("# a comment\n"
+                          "\n"
+                          "a.json -d popden -j\r\n"
+                          "  \"b c.csv\"   SELECT * FROM trains LIMIT 1\n");
+
+    WHEN( "it is read" ) {
+
+      auto jobs = BethYw::readBatch(in);
+
+      THEN( "each job has its file and its query" ) {
+
+        REQUIRE( jobs.size() == 2 );
+        REQUIRE( jobs[0].file == "a.json" );
+        REQUIRE( jobs[0].query == "-d popden -j" );
+        REQUIRE( jobs[1].file == "b c.csv" );
+        REQUIRE( jobs[1].query == "SELECT * FROM trains LIMIT 1" );
+
+      } // THEN
+
+      AND_WHEN( "the datasets they need are worked out" ) {
+
+        THEN( "each one is there once, in the order of datasets.h" ) {
+
+          REQUIRE( BethYw::batchDatasets(jobs) == std::vector<std::string>{"popden", "trains"} );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a line with no query" ) {
+
+    std::istringstream in("a.json\n");
+
+    THEN( "std::invalid_argument is thrown" ) {
+
+      REQUIRE_THROWS_AS( BethYw::readBatch(in), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "two lines writing the same output file" ) {
+
+    std::istringstream in("a.json -d popden -j\n\n\"a.json\" -d trains -j\n");
+
+    THEN( "std::invalid_argument is thrown naming both lines" ) {
+
+      REQUIRE_THROWS_WITH( BethYw::readBatch(in),
+                           "Invalid batch line 3: output file a.json is already written by line 1" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a batch is run against one import", "[batch]" ) {
+
+  GIVEN( "a Catalogue and a batch with one good and one bad query" ) {
+
+    BethYw::Catalogue catalogue("datasets/");
+    std::vector<BethYw::BatchJob> jobs = {
+      {"bethyw-test-batch.csv", "SELECT year, value FROM popden WHERE area = W06000011 AND measure = pop "
+                                "AND year = 2010 FORMAT CSV"},
+      {"bethyw-test-batch-bad.json", "-d nothing -j"}};
+
+    WHEN( "it is run" ) {
+
+      std::ostringstream log;
+      unsigned int failed = BethYw::runBatch(catalogue, jobs, log);
+
+      THEN( "the good answer is written to its file and the bad one is logged" ) {
+
+        std::ifstream file("bethyw-test-batch.csv");
+        std::stringstream written;
+        written << file.rdbuf();
+        REQUIRE( written.str() == "year,value\n2010,237311.0\n" );
+        REQUIRE( failed == 1 );
+        REQUIRE( log.str() == "bethyw-test-batch-bad.json: Error: No dataset matches key: nothing\n"
+                              "Wrote 1 of 2 files\n" );
+        REQUIRE_FALSE( std::ifstream("bethyw-test-batch-bad.json").good() );
+
+      } // THEN
+
+      std::remove("bethyw-test-batch.csv");
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
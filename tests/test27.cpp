@@ -0,0 +1,114 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "scratch.h"
+#include "../catalogue.h"
+#include "../watch.h"
+
+namespace {
+
+void writePopulation(ScratchDir& scratch, unsigned int swansea) {
+  scratch.write("complete-popu1009-pop.csv", "AuthorityCode,2011\nW06000011," + std::to_string(swansea) + "\n");
+}
+
+double swanseaPopulation(Areas data) {
+  return data.getArea("W06000011").getMeasure("pop").getValue(2011);
+}
+
+} // namespace
+
+SCENARIO( "a changed dataset is imported again and swapped in", "[watch]" ) {
+
+  GIVEN( "a Catalogue with two datasets loaded from a directory" ) {
+
+    ScratchDir scratch("bethyw-test-watch/");
+    scratch.write("areas.csv", "Local authority code,Name (eng),Name (cym)\n"
+                               "W06000011,Swansea,Abertawe\n");
+    writePopulation(scratch, 1000);
+    scratch.write("complete-popu1009-area.csv", "AuthorityCode,2011\nW06000011,380\n");
+
+    BethYw::Catalogue catalogue(scratch.dir());
+    BethYw::Selection selection;
+    selection.datasets = {"complete-pop", "complete-area"};
+    Areas before = catalogue.query(selection);
+
+    WHEN( "one file changes and is reloaded" ) {
+
+      writePopulation(scratch, 2000);
+      REQUIRE( catalogue.reload("complete-popu1009-pop.csv") );
+
+      THEN( "new queries see the new data and the old snapshot is unchanged" ) {
+
+        REQUIRE( swanseaPopulation(catalogue.query(selection)) == 2000 );
+        REQUIRE( swanseaPopulation(before) == 1000 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a file that isn't loaded, or isn't a dataset, changes" ) {
+
+      THEN( "nothing is reloaded" ) {
+
+        REQUIRE_FALSE( catalogue.reload("popu1009.json") );
+        REQUIRE_FALSE( catalogue.reload("notes.txt") );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a file changes to something that can't be imported" ) {
+
+      scratch.write("complete-popu1009-pop.csv", "AuthorityCode,2011\nW06000011,lots\n");
+
+      THEN( "an exception is thrown and the old copy is kept" ) {
+
+        REQUIRE_THROWS( catalogue.reload("complete-popu1009-pop.csv") );
+        REQUIRE( swanseaPopulation(catalogue.query(selection)) == 1000 );
+
+      } // THEN
+
+    } // WHEN
+
+#ifdef __linux__
+    WHEN( "the directory is watched and a file is written" ) {
+
+      std::ostringstream log;
+      {
+        BethYw::Watcher watcher(catalogue, scratch.dir(), log);
+        writePopulation(scratch, 3000);
+        for (int i = 0; i < 200 && log.str().empty(); i++)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+
+      THEN( "that dataset is reloaded by itself" ) {
+
+        REQUIRE( log.str() == "Reloaded complete-popu1009-pop.csv\n" );
+        REQUIRE( swanseaPopulation(catalogue.query(selection)) == 3000 );
+
+      } // THEN
+
+    } // WHEN
+#endif
+
+  } // GIVEN
+
+} // SCENARIO
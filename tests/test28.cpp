@@ -0,0 +1,144 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "scratch.h"
+#include "../datasets.h"
+#include "../measureindex.h"
+#include "../snapshot.h"
+
+namespace {
+
+void writePopden(ScratchDir& scratch, const std::string& measures) {
+  std::ostringstream stream;
+  stream << "{\"value\":[";
+  std::istringstream codes(measures);
+  std::string code;
+  bool first = true;
+  while (std::getline(codes, code, ',')) {
+    stream << (first ? "" : ",")
+           << "{\"Data\":1.5,\"Localauthority_Code\":\"W06000011\","
+              "\"Localauthority_ItemName_ENG\":\"Swansea\",\"Measure_Code\":\"" << code << "\","
+              "\"Measure_ItemName_ENG\":\"" << code << "\",\"Year_Code\":\"2011\"}";
+    first = false;
+  }
+  stream << "]}";
+  scratch.write("popu1009.json", stream.str());
+}
+
+std::string readIndexFile(const std::string& path) {
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+SCENARIO( "the measures of each dataset are found and kept in an index", "[measureindex]" ) {
+
+  GIVEN( "a directory with a population density dataset of two measures" ) {
+
+    ScratchDir scratch("bethyw-test-index/");
+    writePopden(scratch, "Dens,Pop");
+    std::string cache = scratch.subdir("cache/");
+    std::string indexFile = scratch.own(cache + BethYw::INDEX_FILE);
+    scratch.own(BethYw::snapshotPath(cache, scratch.dir(), BethYw::InputFiles::POPDEN));
+
+    WHEN( "the measures of a dataset with several are asked for" ) {
+
+      auto measures = BethYw::datasetMeasures(scratch.dir(), BethYw::InputFiles::POPDEN, cache);
+
+      THEN( "the file is read and the index written in the cache directory" ) {
+
+        REQUIRE( measures == std::set<std::string>{"dens", "pop"} );
+        REQUIRE( readIndexFile(indexFile).find(scratch.dir() + "popu1009.json\t") == 0 );
+        REQUIRE( readIndexFile(indexFile).find("\tdens,pop\n") != std::string::npos );
+        REQUIRE_FALSE( std::ifstream(scratch.dir() + BethYw::INDEX_FILE).good() );
+
+      } // THEN
+
+      AND_WHEN( "the dataset is replaced" ) {
+
+        writePopden(scratch, "Dens,Pop,Area");
+
+        THEN( "it is read again" ) {
+
+          REQUIRE( BethYw::datasetMeasures(scratch.dir(), BethYw::InputFiles::POPDEN, cache)
+                   == std::set<std::string>{"area", "dens", "pop"} );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "the measure of a dataset with a single measure is asked for" ) {
+
+      THEN( "it comes from datasets.h, with no file needed" ) {
+
+        REQUIRE( BethYw::datasetMeasures(scratch.dir(), BethYw::InputFiles::TRAINS) == std::set<std::string>{"rail"} );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "datasets are chosen by a measures filter" ) {
+
+      std::vector<BethYw::InputFileSource> datasets = {
+        BethYw::InputFiles::POPDEN, BethYw::InputFiles::BIZ, BethYw::InputFiles::TRAINS,
+        BethYw::InputFiles::COMPLETE_AREA};
+
+      auto codes = [](const std::vector<BethYw::InputFileSource>& chosen) {
+        std::vector<std::string> codes;
+        for (auto const& dataset : chosen)
+          codes.push_back(dataset.CODE);
+        return codes;
+      };
+
+      THEN( "only those that can have its measures (or that can't be read) are kept" ) {
+
+        REQUIRE( codes(BethYw::datasetsWithMeasures(scratch.dir(), datasets, {"pop"}, cache))
+                 == std::vector<std::string>{"popden", "biz"} );
+        REQUIRE( codes(BethYw::datasetsWithMeasures(scratch.dir(), datasets, {"rail", "area"}, cache))
+                 == std::vector<std::string>{"biz", "trains", "complete-area"} );
+        REQUIRE( codes(BethYw::datasetsWithMeasures(scratch.dir(), datasets, {}, cache)).size() == 4 );
+
+      } // THEN
+
+      AND_WHEN( "there is no cache directory" ) {
+
+        auto chosen = codes(BethYw::datasetsWithMeasures(scratch.dir(), datasets, {"area"}));
+
+        THEN( "only the datasets with a single measure are left out, and nothing is read or written" ) {
+
+          REQUIRE( chosen == std::vector<std::string>{"popden", "biz", "complete-area"} );
+          REQUIRE_FALSE( std::ifstream(scratch.dir() + BethYw::INDEX_FILE).good() );
+          REQUIRE_FALSE( std::ifstream(indexFile).good() );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
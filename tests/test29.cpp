@@ -0,0 +1,98 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <string>
+
+#include "scratch.h"
+#include "../datasets.h"
+#include "../snapshot.h"
+
+SCENARIO( "datasets are kept as snapshots until their file changes", "[snapshot]" ) {
+
+  GIVEN( "a directory with a dataset and an empty cache" ) {
+
+    ScratchDir scratch("bethyw-test-snapshot/");
+    const auto& dataset = BethYw::InputFiles::COMPLETE_POP;
+    scratch.write(dataset.FILE, "AuthorityCode,2011,2012\nW06000011,1000,1001.5\nW06000024,50,51\n");
+    std::string source = scratch.dir() + dataset.FILE;
+    std::string cache = scratch.subdir("cache/");
+    std::string snapshot = scratch.own(BethYw::snapshotPath(cache, scratch.dir(), dataset));
+
+    WHEN( "the dataset is imported" ) {
+
+      Areas parsed = BethYw::importDataset(scratch.dir(), dataset, cache);
+
+      THEN( "a snapshot is saved which reads back as the same data" ) {
+
+        Areas loaded = Areas();
+        REQUIRE( BethYw::loadSnapshot(snapshot, source, loaded) );
+        REQUIRE( loaded.size() == 2 );
+        REQUIRE( loaded.getAreas() == parsed.getAreas() );
+        REQUIRE( loaded.getArea("W06000011").getMeasure("pop").getValue(2012) == 1001.5 );
+
+      } // THEN
+
+      AND_WHEN( "the file changes" ) {
+
+        scratch.write(dataset.FILE, "AuthorityCode,2011,2012\nW06000011,2000,2001.5\nW06000024,50,51\n");
+
+        THEN( "the snapshot is not used, and importing parses the new file" ) {
+
+          Areas loaded = Areas();
+          REQUIRE_FALSE( BethYw::loadSnapshot(snapshot, source, loaded) );
+          REQUIRE( loaded.size() == 0 );
+          REQUIRE( BethYw::importDataset(scratch.dir(), dataset, cache)
+                     .getArea("W06000011").getMeasure("pop").getValue(2011) == 2000 );
+          REQUIRE( BethYw::loadSnapshot(snapshot, source, loaded) );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "the snapshot is cut short" ) {
+
+        std::ifstream in(snapshot, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream(snapshot, std::ios::binary) << contents.substr(0, contents.size() - 3);
+
+        THEN( "it is not used" ) {
+
+          Areas loaded = Areas();
+          REQUIRE_FALSE( BethYw::loadSnapshot(snapshot, source, loaded) );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "there is no snapshot" ) {
+
+      Areas loaded = Areas();
+
+      THEN( "nothing is loaded" ) {
+
+        REQUIRE_FALSE( BethYw::loadSnapshot(snapshot, source, loaded) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
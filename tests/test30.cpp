@@ -0,0 +1,181 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "scratch.h"
+#include "../catalogue.h"
+#include "../resultcache.h"
+#include "../server.h"
+
+namespace {
+
+void writeCachedPopulation(ScratchDir& scratch, unsigned int swansea) {
+  scratch.write("complete-popu1009-pop.csv", "AuthorityCode,2011\nW06000011," + std::to_string(swansea) + "\n");
+}
+
+} // namespace
+
+SCENARIO( "a ResultCache keeps the most recently used answers within its budget", "[resultcache]" ) {
+
+  GIVEN( "a cache with room for two answers of ten bytes with one-byte keys" ) {
+
+    BethYw::ResultCache cache(22);
+    cache.insert("a", 0, "0123456789");
+    cache.insert("b", 0, "0123456789");
+
+    WHEN( "the first is used and a third is kept" ) {
+
+      std::string answer;
+      REQUIRE( cache.find("a", 0, answer) );
+      cache.insert("c", 0, "abcdefghij");
+
+      THEN( "the least recently used answer is dropped" ) {
+
+        REQUIRE( cache.size() == 2 );
+        REQUIRE( cache.getUsed() == 22 );
+        REQUIRE_FALSE( cache.find("b", 0, answer) );
+        REQUIRE( cache.find("c", 0, answer) );
+        REQUIRE( answer == "abcdefghij" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "an answer bigger than the budget is kept" ) {
+
+      cache.insert("d", 0, "this answer is far too big");
+
+      THEN( "it isn't kept, and nothing else is dropped" ) {
+
+        std::string answer;
+        REQUIRE_FALSE( cache.find("d", 0, answer) );
+        REQUIRE( cache.size() == 2 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the Catalogue generation goes up" ) {
+
+      std::string answer;
+
+      THEN( "every answer from before is dropped, and late answers aren't kept" ) {
+
+        REQUIRE_FALSE( cache.find("a", 1, answer) );
+        REQUIRE( cache.size() == 0 );
+        cache.insert("e", 0, "stale");
+        REQUIRE_FALSE( cache.find("e", 1, answer) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "queries asking for the same thing have the same result key", "[resultcache]" ) {
+
+  GIVEN( "queries that differ only in how they are written" ) {
+
+    THEN( "their keys are the same" ) {
+
+      REQUIRE( BethYw::resultKey("-j -d popden") == BethYw::resultKey("--json --datasets=popden") );
+      REQUIRE( BethYw::resultKey("-a W06000024,W06000011 -m POP") ==
+               BethYw::resultKey("-m pop -a W06000011,W06000024") );
+      REQUIRE( BethYw::resultKey("SELECT *   FROM popden") == BethYw::resultKey(" SELECT * FROM popden ") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "queries that ask for different things" ) {
+
+    THEN( "their keys are different" ) {
+
+      REQUIRE( BethYw::resultKey("-d popden -j") != BethYw::resultKey("-d popden --csv") );
+      REQUIRE( BethYw::resultKey("-d popden -y 2010") != BethYw::resultKey("-d popden -y 2011") );
+      REQUIRE( BethYw::resultKey("--derive a=pop --derive b=a") !=
+               BethYw::resultKey("--derive b=a --derive a=pop") );
+      REQUIRE( BethYw::resultKey("SELECT * FROM popden WHERE area = 'a  b'") !=
+               BethYw::resultKey("SELECT * FROM popden WHERE area = 'a b'") );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "answers from a ResultCache are the same, until a dataset is reloaded", "[resultcache]" ) {
+
+  GIVEN( "a Catalogue over a directory with one dataset, and a cache" ) {
+
+    ScratchDir scratch("bethyw-test-resultcache/");
+    scratch.write("areas.csv", "Local authority code,Name (eng),Name (cym)\nW06000011,Swansea,Abertawe\n");
+    writeCachedPopulation(scratch, 1000);
+
+    BethYw::Catalogue catalogue(scratch.dir());
+    BethYw::ResultCache cache(1024 * 1024);
+
+    std::ostringstream plain, first, second;
+    REQUIRE( BethYw::answerQuery(catalogue, "-d complete-pop -j", plain) );
+    REQUIRE( BethYw::answerQuery(catalogue, "-d complete-pop -j", first, &cache) );
+    REQUIRE( BethYw::answerQuery(catalogue, "--datasets complete-pop --json", second, &cache) );
+
+    THEN( "the answer is kept once and written the same every time" ) {
+
+      REQUIRE( cache.size() == 1 );
+      REQUIRE( first.str() == plain.str() );
+      REQUIRE( second.str() == plain.str() );
+
+    } // THEN
+
+    WHEN( "the dataset changes and is reloaded" ) {
+
+      writeCachedPopulation(scratch, 2000);
+      REQUIRE( catalogue.reload("complete-popu1009-pop.csv") );
+
+      std::ostringstream after;
+      REQUIRE( BethYw::answerQuery(catalogue, "-d complete-pop -j", after, &cache) );
+
+      THEN( "the new data is answered" ) {
+
+        REQUIRE( after.str().find("2000") != std::string::npos );
+        REQUIRE( after.str() != plain.str() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the query is invalid" ) {
+
+      std::ostringstream error;
+      REQUIRE_FALSE( BethYw::answerQuery(catalogue, "-d nothing", error, &cache) );
+
+      THEN( "the error is answered and not kept" ) {
+
+        REQUIRE( error.str() == "Error: No dataset matches key: nothing\n" );
+        REQUIRE( cache.size() == 1 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
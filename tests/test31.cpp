@@ -0,0 +1,125 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "scratch.h"
+#include "../datasets.h"
+#include "../measureindex.h"
+#include "../snapshot.h"
+
+namespace {
+
+std::vector<std::string> matchingCodes(const std::string& dir,
+                                       const std::string& cacheDir,
+                                       const StringFilterSet& areasFilter,
+                                       const StringFilterSet& measuresFilter,
+                                       const YearFilterTuple& yearsFilter) {
+  std::vector<BethYw::InputFileSource> datasets = {
+    BethYw::InputFiles::POPDEN, BethYw::InputFiles::COMPLETE_POP};
+  std::vector<std::string> codes;
+  for (auto const& dataset : BethYw::datasetsMatching(dir, datasets, areasFilter, measuresFilter, yearsFilter,
+                                                                 cacheDir))
+    codes.push_back(dataset.CODE);
+  return codes;
+}
+
+} // namespace
+
+SCENARIO( "the manifest of each dataset has its areas, years and rows", "[measureindex]" ) {
+
+  GIVEN( "a directory with a JSON dataset for 2011 and a CSV dataset for 2012-2014" ) {
+
+    ScratchDir scratch("bethyw-test-manifest/");
+    std::string cache = scratch.subdir("cache/");
+    scratch.own(cache + BethYw::INDEX_FILE);  // where the manifests are kept
+    scratch.own(BethYw::snapshotPath(cache, scratch.dir(), BethYw::InputFiles::POPDEN));
+    scratch.own(BethYw::snapshotPath(cache, scratch.dir(), BethYw::InputFiles::COMPLETE_POP));
+    scratch.write("popu1009.json",
+                  "{\"value\":[{\"Data\":1.5,\"Localauthority_Code\":\"W06000011\","
+                  "\"Localauthority_ItemName_ENG\":\"Swansea\",\"Measure_Code\":\"Pop\","
+                  "\"Measure_ItemName_ENG\":\"Pop\",\"Year_Code\":\"2011\"}]}");
+    scratch.write("complete-popu1009-pop.csv",
+                  "AuthorityCode,2012,2013,2014\n"
+                  "W06000011,1,2,3\n"
+                  "W06000024,4,5,6\n");
+
+    WHEN( "the manifest of the CSV dataset is asked for" ) {
+
+      auto manifest = BethYw::datasetManifest(scratch.dir(), BethYw::InputFiles::COMPLETE_POP, cache);
+
+      THEN( "it is scanned, even though the dataset has a single measure" ) {
+
+        REQUIRE( manifest.scanned );
+        REQUIRE( manifest.measures == std::set<std::string>{"pop"} );
+        REQUIRE( manifest.areas == std::set<std::string>{"W06000011", "W06000024"} );
+        REQUIRE( manifest.firstYear == 2012 );
+        REQUIRE( manifest.lastYear == 2014 );
+        REQUIRE( manifest.rows == 6 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "datasets are chosen by areas and years filters" ) {
+
+      THEN( "only those that can have a reading left are kept" ) {
+
+        REQUIRE( matchingCodes(scratch.dir(), cache, {}, {}, YearFilterTuple(0, 0))
+                 == std::vector<std::string>{"popden", "complete-pop"} );
+        REQUIRE( matchingCodes(scratch.dir(), cache, {}, {}, YearFilterTuple(2011, 2011))
+                 == std::vector<std::string>{"popden"} );
+        REQUIRE( matchingCodes(scratch.dir(), cache, {}, {}, YearFilterTuple(2010, 2012))
+                 == std::vector<std::string>{"popden", "complete-pop"} );
+        REQUIRE( matchingCodes(scratch.dir(), cache, {}, {}, YearFilterTuple(2019, 2019)).empty() );
+        REQUIRE( matchingCodes(scratch.dir(), cache, {"W06000024"}, {}, YearFilterTuple(0, 0))
+                 == std::vector<std::string>{"complete-pop"} );
+        REQUIRE( matchingCodes(scratch.dir(), cache, {"W06000011"}, {"dens"}, YearFilterTuple(0, 0)).empty() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "there is no cache directory to keep the manifests in" ) {
+
+      THEN( "no dataset is scanned, so all of them are kept" ) {
+
+        REQUIRE( matchingCodes(scratch.dir(), "", {}, {}, YearFilterTuple(2019, 2019))
+                 == std::vector<std::string>{"popden", "complete-pop"} );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a dataset can't be read" ) {
+
+      std::remove(scratch.path("complete-popu1009-pop.csv").c_str());
+
+      THEN( "it is kept, so importing it reports the error" ) {
+
+        REQUIRE( matchingCodes(scratch.dir(), cache, {}, {}, YearFilterTuple(2019, 2019))
+                 == std::vector<std::string>{"complete-pop"} );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,153 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "scratch.h"
+#include "../areaindex.h"
+#include "../datasets.h"
+
+namespace {
+
+std::string popdenRecord(const std::string& code, const std::string& year) {
+  return "{\"Data\":1.5,\"Localauthority_Code\":\"" + code + "\","
+         "\"Localauthority_ItemName_ENG\":\"Name {\\\"" + code + "\\\"}\",\"Measure_Code\":\"Pop\","
+         "\"Measure_ItemName_ENG\":\"Population\",\"Year_Code\":\"" + year + "\"}";
+}
+
+} // namespace
+
+SCENARIO( "only the records of the areas wanted are read from a dataset", "[areaindex]" ) {
+
+  GIVEN( "a directory with a JSON dataset and a CSV dataset of three areas" ) {
+
+    ScratchDir scratch("bethyw-test-areaindex/");
+    std::string cache = scratch.subdir("cache/");
+    scratch.own(BethYw::areaIndexPath(cache, scratch.dir(), BethYw::InputFiles::POPDEN));
+    scratch.own(BethYw::areaIndexPath(cache, scratch.dir(), BethYw::InputFiles::COMPLETE_POP));
+    scratch.write("popu1009.json",
+                  "{\"odata.metadata\":\"value\",\"value\":[\n  " + popdenRecord("W06000011", "2011")
+                  + ",\n  " + popdenRecord("W06000024", "2011")
+                  + ",\n  " + popdenRecord("W06000011", "2012") + "\n],\"odata.nextLink\":\"x\"}");
+    scratch.write("complete-popu1009-pop.csv",
+                  "AuthorityCode,2011,2012\n"
+                  "W06000011,1,2\n"
+                  "W06000024,3,4\n"
+                  "W06000001,5,6\n");
+
+    WHEN( "the records of one area are read from the JSON dataset" ) {
+
+      std::string records;
+      REQUIRE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::POPDEN, {"W06000011"}, cache, records) );
+
+      THEN( "they are the objects of that area, in order, in a new value array" ) {
+
+        REQUIRE( records == "{\"value\":[" + popdenRecord("W06000011", "2011") + ","
+                            + popdenRecord("W06000011", "2012") + "]}" );
+
+      } // THEN
+
+      THEN( "the index is kept in the cache directory, not next to the dataset" ) {
+
+        std::ifstream index(BethYw::areaIndexPath(cache, scratch.dir(), BethYw::InputFiles::POPDEN));
+        REQUIRE( index.good() );
+        REQUIRE_FALSE( std::ifstream(scratch.dir() + ".popu1009.json.bethyw-areas").good() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the records of two areas are read from the CSV dataset" ) {
+
+      std::string records;
+      REQUIRE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::COMPLETE_POP,
+                                       {"W06000001", "W06000011"}, cache, records) );
+
+      THEN( "they are the header line and the lines of those areas, in order" ) {
+
+        REQUIRE( records == "AuthorityCode,2011,2012\nW06000011,1,2\nW06000001,5,6\n" );
+
+      } // THEN
+
+      AND_WHEN( "the dataset is replaced" ) {
+
+        scratch.write("complete-popu1009-pop.csv",
+                      "AuthorityCode,2011\n"
+                      "W06000001,7\n");
+        REQUIRE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::COMPLETE_POP,
+                                         {"W06000001"}, cache, records) );
+
+        THEN( "it is indexed again" ) {
+
+          REQUIRE( records == "AuthorityCode,2011\nW06000001,7\n" );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "the dataset is replaced by one of the same size straight away" ) {
+
+        scratch.write("complete-popu1009-pop.csv",
+                      "AuthorityCode,2011,2012\n"
+                      "W06000001,5,6\n"
+                      "W06000011,1,2\n"
+                      "W06000024,3,4\n");
+        REQUIRE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::COMPLETE_POP,
+                                         {"W06000001"}, cache, records) );
+
+        THEN( "it is still indexed again, as its modified time is kept to the nanosecond" ) {
+
+          REQUIRE( records == "AuthorityCode,2011,2012\nW06000001,5,6\n" );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "there is no cache directory to keep the index in" ) {
+
+      std::string records;
+
+      THEN( "nothing is read or written, so the whole file is imported instead" ) {
+
+        REQUIRE_FALSE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::POPDEN, {"W06000011"}, "", records) );
+        REQUIRE_FALSE( std::ifstream(BethYw::areaIndexPath("", scratch.dir(), BethYw::InputFiles::POPDEN)).good() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a dataset can't be indexed or isn't the right type" ) {
+
+      scratch.write("popu1009.json", "{\"value\":[{\"Localauthority_Code\":1}]}");
+      std::string records;
+
+      THEN( "nothing is read, so the whole file is imported instead" ) {
+
+        REQUIRE_FALSE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::POPDEN, {"W06000011"}, cache, records) );
+        REQUIRE_FALSE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::AREAS, {"W06000011"}, cache, records) );
+        REQUIRE_FALSE( BethYw::readAreaRecords(scratch.dir(), BethYw::InputFiles::COMPLETE_POP, {}, cache, records) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
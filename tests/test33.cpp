@@ -0,0 +1,128 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../fileutil.h"
+
+namespace {
+
+const std::string ATOMIC_FILE = "bethyw-test-atomic.txt";
+
+std::string readAtomicFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+SCENARIO( "a file is written through a temporary file", "[fileutil]" ) {
+
+  GIVEN( "a file that is already there" ) {
+
+    REQUIRE( BethYw::writeFileAtomically(ATOMIC_FILE, "old contents") );
+
+    WHEN( "it is written again" ) {
+
+      bool written = BethYw::writeFileAtomically(ATOMIC_FILE, "new");
+
+      THEN( "it is replaced" ) {
+
+        REQUIRE( written );
+        REQUIRE( readAtomicFile(ATOMIC_FILE) == "new" );
+
+      } // THEN
+
+      AND_WHEN( "its size and modified time are read" ) {
+
+        unsigned long long size = 0;
+        long long modified = 0;
+
+        THEN( "they are those of the new file" ) {
+
+          REQUIRE( BethYw::stampFile(ATOMIC_FILE, size, modified) );
+          REQUIRE( size == 3 );
+          REQUIRE( modified > 0 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "several threads write it at the same time" ) {
+
+      std::vector<std::thread> writers;
+      for (char c = 'a'; c < 'i'; c++)
+        writers.emplace_back([c]() {
+          for (int i = 0; i < 200; i++)
+            BethYw::writeFileAtomically(ATOMIC_FILE, std::string(1000, c));
+        });
+      unsigned int missing = 0;
+      for (int i = 0; i < 2000; i++)
+        if (!std::ifstream(ATOMIC_FILE).good())
+          missing++;
+      for (auto& writer : writers)
+        writer.join();
+
+      THEN( "it is never missing, and is whole and written by one of them at the end" ) {
+
+        REQUIRE( missing == 0 );
+        std::string contents = readAtomicFile(ATOMIC_FILE);
+        REQUIRE( contents.size() == 1000 );
+        REQUIRE( contents == std::string(1000, contents[0]) );
+
+      } // THEN
+
+    } // WHEN
+
+    std::remove(ATOMIC_FILE.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a file that isn't there" ) {
+
+    unsigned long long size = 7;
+    long long modified = 7;
+
+    THEN( "it has no size or modified time" ) {
+
+      REQUIRE_FALSE( BethYw::stampFile("bethyw-test-missing.txt", size, modified) );
+      REQUIRE( size == 7 );
+      REQUIRE( modified == 7 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a directory that isn't there" ) {
+
+    THEN( "nothing is written" ) {
+
+      REQUIRE_FALSE( BethYw::writeFileAtomically("bethyw-test-missing/file.txt", "contents") );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
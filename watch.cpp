@@ -0,0 +1,121 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the implementation of the Watcher. See the header file
+  for additional comments.
+
+  The thread waits (with poll()) on both the inotify file descriptor and a
+  pipe, and the destructor stops it by writing to the pipe.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "watch.h"
+
+/*
+  Start watching a datasets directory for files that change, and reload them
+  into the Catalogue on a new thread until the Watcher is destroyed.
+
+  @param catalogue
+    The datasets in memory, which must outlive the Watcher
+
+  @param dir
+    The directory the Catalogue imports from
+
+  @param log
+    The stream to write a line to whenever a file is imported again (or fails
+    to be, in which case the old copy is kept)
+
+  @throws
+    std::runtime_error if the directory can't be watched, or if this isn't
+    Linux
+
+  @example
+    BethYw::Catalogue catalogue("datasets/");
+    BethYw::Watcher watcher(catalogue, "datasets/", std::cerr);
+*/
+BethYw::Watcher::Watcher(Catalogue& catalogue, const std::string& dir, std::ostream& log)
+    : catalogue(catalogue), log(log) {
+#ifndef __linux__
+    throw std::runtime_error("BethYw::Watcher: Watching " + dir + " needs inotify, which is only on Linux");
+#else
+    inotifyFd = ::inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0)
+        throw std::runtime_error(std::string("BethYw::Watcher: Failed to start inotify: ") + std::strerror(errno));
+    if (::inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || ::pipe(stopFds) != 0) {
+        std::string error = std::strerror(errno);
+        ::close(inotifyFd);
+        throw std::runtime_error("BethYw::Watcher: Failed to watch " + dir + ": " + error);
+    }
+    thread = std::thread(&Watcher::watch, this);
+#endif
+}
+
+/*
+  Stop watching, waiting for a reload that has already started to finish.
+*/
+BethYw::Watcher::~Watcher() {
+#ifdef __linux__
+    char stop = 0;
+    while (::write(stopFds[1], &stop, 1) < 0 && errno == EINTR) {}
+    thread.join();
+    ::close(stopFds[0]);
+    ::close(stopFds[1]);
+    ::close(inotifyFd);
+#endif
+}
+
+/*
+  The thread: wait for events, and reload each file named in them once
+  (a file is often written in several goes, each its own event).
+*/
+void BethYw::Watcher::watch() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFds[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            log << "Error watching datasets: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents != 0)
+            return;
+
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            continue;
+
+        std::set<std::string> files;
+        for (char* event = buffer; event < buffer + length;) {
+            auto* notification = reinterpret_cast<struct inotify_event*>(event);
+            if (notification->len > 0)
+                files.insert(notification->name);
+            event += sizeof(struct inotify_event) + notification->len;
+        }
+
+        for (auto const& file : files) {
+            try {
+                if (catalogue.reload(file))
+                    log << "Reloaded " << file << std::endl;
+            } catch (const std::exception& error) {
+                log << "Error reloading " << file << ": " << error.what() << std::endl;
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef WATCH_H_
+#define WATCH_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 976789
+
+  This file contains the declaration of the Watcher, used by --watch with
+  --serve and --repl to pick up a refreshed dataset without restarting.
+
+  A Watcher asks the kernel (inotify, so Linux only) to say when a file in
+  the datasets directory has been written or moved in, and on its own thread
+  calls Catalogue::reload() for that file. Only the dataset whose file
+  changed is imported again, and it is swapped in whole, so queries already
+  running finish on the old copy.
+ */
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "catalogue.h"
+
+namespace BethYw {
+
+class Watcher {
+private:
+  Catalogue& catalogue;
+  std::ostream& log;
+  int inotifyFd = -1;
+  int stopFds[2] = {-1, -1};
+  std::thread thread;
+
+  void watch();
+
+public:
+  /*----Constructor/destructor----*/
+  Watcher(Catalogue& catalogue, const std::string& dir, std::ostream& log) noexcept(false);
+  ~Watcher();
+
+  Watcher(const Watcher&) = delete;
+  Watcher& operator=(const Watcher&) = delete;
+};
+
+} // namespace BethYw
+
+#endif // WATCH_H_